@@ -4,12 +4,16 @@
  **/
 #include "SkycatchAPI.h"
 #include "Modules/ModuleManager.h"
+#include "Misc/CoreDelegates.h"
 
 #if WITH_EDITOR
 #include "ISettingsModule.h"
 #endif
 
 #include "SkycatchSettings.h"
+#include "SkycatchEndpoints.h"
+#include "SkycatchSiteCache.h"
+#include "SkycatchWarmUp.h"
 
 #define LOCTEXT_NAMESPACE "FSkycatchAPIModule"
 
@@ -33,6 +37,22 @@ void FSkycatchAPIModule::StartupModule(){
 	}
 #endif
 
+	//Connections and known sites are warmed up once the engine ticks, commandlets don't need them
+	if (GetDefault<USkycatchSettings>()->bWarmUpOnStartup && !IsRunningCommandlet())
+	{
+		FSkycatchWarmUp::Get().Start();
+	}
+
+	//The cached sites are kept for the warm up of the next session. They are saved before the engine exits, while the
+	//settings and the rest of the UObjects are still alive
+	if (GetDefault<USkycatchSettings>()->bPersistSiteCache && !IsRunningCommandlet())
+	{
+		PreExitHandle = FCoreDelegates::OnPreExit.AddLambda([]()
+		{
+			FSkycatchSiteCache::Get().Save();
+		});
+	}
+
 }
 
 /**
@@ -40,6 +60,10 @@ void FSkycatchAPIModule::StartupModule(){
  */
 void FSkycatchAPIModule::ShutdownModule()
 {
+	FSkycatchWarmUp::Get().Shutdown();
+	FSkycatchEndpointPool::Get().Shutdown();
+
+	FCoreDelegates::OnPreExit.Remove(PreExitHandle);
 
 	/**
 	 * If we have a valid instance of the settings class, we unregister the global configuration for the settings.
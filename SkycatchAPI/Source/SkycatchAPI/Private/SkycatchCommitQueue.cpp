@@ -0,0 +1,170 @@
+/**
+ * Including the Header libraries and files required
+ **/
+#include "SkycatchCommitQueue.h"
+#include "SkycatchSettings.h"
+
+DECLARE_STATS_GROUP(TEXT("Skycatch"), STATGROUP_Skycatch, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Commit Queue Depth"), STAT_SkycatchCommitQueueDepth, STATGROUP_Skycatch);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Commit Time (ms)"), STAT_SkycatchCommitMilliseconds, STATGROUP_Skycatch);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Commit Hitches"), STAT_SkycatchCommitHitches, STATGROUP_Skycatch);
+
+/**
+ * @brief Adds a commit, replacing the commit of the same owner that is still queued.
+ *
+ * @param Owner as the object the commit works on, the commit is dropped when it is destroyed
+ * @param Location as the location of the commit in Unreal coordinates, the closest to the views run first
+ * @param Step as the step run until the commit is completed
+ * @param OnCancelled as the function called if the commit is cancelled or replaced before it is completed
+ */
+void FSkycatchCommitQueue::Enqueue(UObject* Owner, const FVector& Location, FStep Step, FCancelled OnCancelled)
+{
+	Cancel(Owner);
+
+	FCommit& Commit = Commits.AddDefaulted_GetRef();
+	Commit.Owner = Owner;
+	Commit.Location = Location;
+	Commit.Step = MoveTemp(Step);
+	Commit.OnCancelled = MoveTemp(OnCancelled);
+	Commit.EnqueueTime = FPlatformTime::Seconds();
+
+	Stats.QueueDepth = Commits.Num();
+	Stats.PeakQueueDepth = FMath::Max(Stats.PeakQueueDepth, Stats.QueueDepth);
+}
+
+/**
+ * @brief Drops the commit of an owner, calling its cancel function.
+ *
+ * @param Owner as the owner of the commit
+ */
+void FSkycatchCommitQueue::Cancel(const UObject* Owner)
+{
+	//The cancel functions run once the commits are removed, as they may enqueue or cancel commits
+	TArray<FCancelled> Cancelled;
+	Commits.RemoveAll([Owner, &Cancelled](FCommit& Commit)
+	{
+		if (Commit.Owner.Get() != Owner)
+		{
+			return false;
+		}
+		if (Commit.OnCancelled)
+		{
+			Cancelled.Add(MoveTemp(Commit.OnCancelled));
+		}
+		return true;
+	});
+	Stats.QueueDepth = Commits.Num();
+
+	for (FCancelled& OnCancelled : Cancelled)
+	{
+		OnCancelled();
+	}
+}
+
+/**
+ * @brief Runs the steps of the commits until the budget is spent. At least one step runs every frame, so the
+ * queue always makes progress.
+ *
+ * @param ViewLocations as the locations of the player views
+ * @param BudgetMilliseconds as the time the commits can take this frame
+ */
+void FSkycatchCommitQueue::Run(const TArray<FVector>& ViewLocations, float BudgetMilliseconds)
+{
+	//Commits of destroyed owners are dropped
+	Commits.RemoveAll([](const FCommit& Commit)
+	{
+		return !Commit.Owner.IsValid();
+	});
+	SET_DWORD_STAT(STAT_SkycatchCommitQueueDepth, Commits.Num());
+	if (Commits.Num() == 0)
+	{
+		Stats.QueueDepth = 0;
+		return;
+	}
+
+	//The commits closest to the views run first, the queue keeps that order until the next frame
+	if (ViewLocations.Num() > 0)
+	{
+		auto ViewDistance = [&ViewLocations](const FVector& Location)
+		{
+			double Distance = TNumericLimits<double>::Max();
+			for (const FVector& View : ViewLocations)
+			{
+				Distance = FMath::Min(Distance, FVector::DistSquared(View, Location));
+			}
+			return Distance;
+		};
+		Commits.StableSort([&ViewDistance](const FCommit& A, const FCommit& B)
+		{
+			return ViewDistance(A.Location) < ViewDistance(B.Location);
+		});
+	}
+
+	//A waiting commit keeps its place, the commits after it run meanwhile
+	const double StartTime = FPlatformTime::Seconds();
+	const double Deadline = StartTime + BudgetMilliseconds / 1000.0;
+	int32 Index = 0;
+	do
+	{
+		if (RunStep(Index) == ESkycatchCommitStep::Wait)
+		{
+			Index++;
+		}
+	}
+	while (Index < Commits.Num() && FPlatformTime::Seconds() < Deadline);
+
+	const float FrameMilliseconds = (float)((FPlatformTime::Seconds() - StartTime) * 1000.0);
+	Stats.LastFrameMilliseconds = FrameMilliseconds;
+	Stats.QueueDepth = Commits.Num();
+	SET_FLOAT_STAT(STAT_SkycatchCommitMilliseconds, FrameMilliseconds);
+
+	//A step much longer than the budget could not be split by the queue, it is reported as a hitch
+	if (FrameMilliseconds > BudgetMilliseconds * 2.0f)
+	{
+		Stats.Hitches++;
+		INC_DWORD_STAT(STAT_SkycatchCommitHitches);
+		UE_LOG(LogSkycatch, Verbose, TEXT("Commits took %.2f ms over a budget of %.2f ms, %d commits left"), FrameMilliseconds, BudgetMilliseconds, Commits.Num());
+	}
+}
+
+/**
+ * @brief Runs one step of a commit and removes it once completed.
+ *
+ * @param Index as the index of the commit
+ */
+ESkycatchCommitStep FSkycatchCommitQueue::RunStep(int32 Index)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	//The step is moved out while it runs, as it may enqueue or cancel commits
+	FCommit Commit = MoveTemp(Commits[Index]);
+	Commits.RemoveAt(Index);
+	const ESkycatchCommitStep Result = Commit.Owner.IsValid() ? Commit.Step() : ESkycatchCommitStep::Completed;
+
+	const double EndTime = FPlatformTime::Seconds();
+	Stats.MaxStepMilliseconds = FMath::Max(Stats.MaxStepMilliseconds, (float)((EndTime - StartTime) * 1000.0));
+
+	if (Result == ESkycatchCommitStep::Completed)
+	{
+		Stats.CompletedCommits++;
+		TotalLatencySeconds += EndTime - Commit.EnqueueTime;
+		Stats.AverageLatencySeconds = (float)(TotalLatencySeconds / Stats.CompletedCommits);
+	}
+	else
+	{
+		//A commit replaced by its own step is not put back, and is reported as cancelled
+		const bool bReplaced = Commits.ContainsByPredicate([&Commit](const FCommit& Other)
+		{
+			return Other.Owner == Commit.Owner;
+		});
+		if (!bReplaced)
+		{
+			Commits.Insert(MoveTemp(Commit), FMath::Min(Index, Commits.Num()));
+		}
+		else if (Commit.OnCancelled)
+		{
+			Commit.OnCancelled();
+		}
+	}
+	return Result;
+}
@@ -0,0 +1,429 @@
+/**
+ * Including the Header libraries and files required
+ **/
+#include "SkycatchEndpoints.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include "HAL/IConsoleManager.h"
+#include "HttpServerModule.h"
+#include "IHttpRouter.h"
+#include "HttpServerResponse.h"
+#include "SkycatchSettings.h"
+
+/**
+ * @brief Returns the process wide endpoint pool.
+ */
+FSkycatchEndpointPool& FSkycatchEndpointPool::Get()
+{
+	static FSkycatchEndpointPool Pool;
+	return Pool;
+}
+
+/**
+ * @brief Stops the periodic health probing. Called when the plugin stops.
+ */
+void FSkycatchEndpointPool::Shutdown()
+{
+	if (ProbeTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(ProbeTickerHandle);
+		ProbeTickerHandle.Reset();
+	}
+	ProbeTickerInterval = 0.0f;
+}
+
+/**
+ * @brief Rebuilds the endpoint list from the plugin settings, keeping the statistics of known endpoints.
+ */
+void FSkycatchEndpointPool::SyncWithSettings()
+{
+	const USkycatchSettings* Settings = GetDefault<USkycatchSettings>();
+
+	TArray<FString> Configured;
+	Configured.Add(Settings->SKYVERSE_ENDPOINT);
+	Configured.Append(Settings->SKYVERSE_MIRROR_ENDPOINTS);
+
+	TArray<FSkycatchEndpointStats> Synced;
+	for (const FString& Endpoint : Configured)
+	{
+		if (Endpoint.IsEmpty() || Synced.ContainsByPredicate([&Endpoint](const FSkycatchEndpointStats& Stats) { return Stats.Endpoint == Endpoint; }))
+		{
+			continue;
+		}
+
+		const FSkycatchEndpointStats* Known = Endpoints.FindByPredicate([&Endpoint](const FSkycatchEndpointStats& Stats) { return Stats.Endpoint == Endpoint; });
+		if (Known)
+		{
+			Synced.Add(*Known);
+		}
+		else
+		{
+			FSkycatchEndpointStats Stats;
+			Stats.Endpoint = Endpoint;
+			Synced.Add(Stats);
+		}
+	}
+	Endpoints = MoveTemp(Synced);
+
+	UpdateProbeTicker();
+}
+
+/**
+ * @brief Starts or stops the periodic health probing according to the plugin settings.
+ */
+void FSkycatchEndpointPool::UpdateProbeTicker()
+{
+	const float Interval = GetDefault<USkycatchSettings>()->EndpointProbeIntervalSeconds;
+	if (Interval == ProbeTickerInterval)
+	{
+		return;
+	}
+
+	Shutdown();
+	if (Interval > 0.0f)
+	{
+		ProbeTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([this](float)
+		{
+			ProbeEndpoints();
+			return true;
+		}), Interval);
+		ProbeTickerInterval = Interval;
+	}
+}
+
+/**
+ * @brief Selects the healthy endpoint with the lowest latency. Endpoints that have not answered yet are tried
+ * first, and unhealthy ones become selectable again once the retry cooldown elapsed.
+ * Returns an empty string when every endpoint is excluded.
+ *
+ * @param Excluded as the endpoints already tried for the current lookup
+ */
+FString FSkycatchEndpointPool::SelectEndpoint(const TArray<FString>& Excluded)
+{
+	SyncWithSettings();
+
+	const double Now = FPlatformTime::Seconds();
+	const float RetryCooldown = GetDefault<USkycatchSettings>()->EndpointRetryCooldownSeconds;
+
+	const FSkycatchEndpointStats* Best = nullptr;
+	const FSkycatchEndpointStats* BestUnhealthy = nullptr;
+	for (const FSkycatchEndpointStats& Stats : Endpoints)
+	{
+		if (Excluded.Contains(Stats.Endpoint))
+		{
+			continue;
+		}
+
+		if (!Stats.bHealthy && Now - Stats.LastFailureTime < RetryCooldown)
+		{
+			//Keeps the unhealthy endpoint that failed the longest time ago in case nothing else is left
+			if (!BestUnhealthy || Stats.LastFailureTime < BestUnhealthy->LastFailureTime)
+			{
+				BestUnhealthy = &Stats;
+			}
+			continue;
+		}
+
+		//Endpoints without latency samples have a negative average, so they are tried before the measured ones
+		if (!Best || Stats.LatencyMs < Best->LatencyMs)
+		{
+			Best = &Stats;
+		}
+	}
+
+	if (!Best)
+	{
+		Best = BestUnhealthy;
+	}
+	return Best ? Best->Endpoint : FString();
+}
+
+/**
+ * @brief Records an answer of an endpoint and updates its latency average.
+ *
+ * @param Endpoint as the endpoint that answered
+ * @param LatencySeconds as the time it took to answer
+ */
+void FSkycatchEndpointPool::ReportSuccess(const FString& Endpoint, double LatencySeconds)
+{
+	FSkycatchEndpointStats* Stats = Endpoints.FindByPredicate([&Endpoint](const FSkycatchEndpointStats& Candidate) { return Candidate.Endpoint == Endpoint; });
+	if (!Stats)
+	{
+		return;
+	}
+
+	const float SampleMs = LatencySeconds * 1000.0;
+	const float Smoothing = FMath::Clamp(GetDefault<USkycatchSettings>()->EndpointLatencySmoothing, 0.0f, 1.0f);
+	Stats->LatencyMs = Stats->LatencyMs < 0.0f ? SampleMs : FMath::Lerp(Stats->LatencyMs, SampleMs, Smoothing);
+	Stats->bHealthy = true;
+	Stats->ConsecutiveFailures = 0;
+	Stats->Successes++;
+}
+
+/**
+ * @brief Records a connection failure or server error of an endpoint, marking it unhealthy.
+ *
+ * @param Endpoint as the endpoint that failed
+ */
+void FSkycatchEndpointPool::ReportFailure(const FString& Endpoint)
+{
+	FSkycatchEndpointStats* Stats = Endpoints.FindByPredicate([&Endpoint](const FSkycatchEndpointStats& Candidate) { return Candidate.Endpoint == Endpoint; });
+	if (!Stats)
+	{
+		return;
+	}
+
+	Stats->bHealthy = false;
+	Stats->ConsecutiveFailures++;
+	Stats->Failures++;
+	Stats->LastFailureTime = FPlatformTime::Seconds();
+	UE_LOG(LogSkycatch, Warning, TEXT("Skycatch endpoint %s marked unhealthy"), *Endpoint);
+}
+
+/**
+ * @brief Sends a lightweight request to every configured endpoint to refresh its health and latency. This also
+ * resolves and opens the connections to the endpoints, which the following lookups reuse.
+ *
+ * @param OnProbed as the callback executed once every endpoint answered or failed
+ */
+void FSkycatchEndpointPool::ProbeEndpoints(TFunction<void()> OnProbed)
+{
+	SyncWithSettings();
+	if (Endpoints.Num() == 0)
+	{
+		if (OnProbed)
+		{
+			OnProbed();
+		}
+		return;
+	}
+
+	//Counts the probes still waiting for an answer
+	const TSharedRef<int32> Remaining = MakeShared<int32>(Endpoints.Num());
+	const TSharedRef<TFunction<void()>> OnAllProbed = MakeShared<TFunction<void()>>(MoveTemp(OnProbed));
+	for (const FSkycatchEndpointStats& Stats : Endpoints)
+	{
+		TSharedRef<IHttpRequest, ESPMode::ThreadSafe> pRequest = FHttpModule::Get().CreateRequest();
+		pRequest->SetVerb(TEXT("HEAD"));
+		pRequest->SetHeader(TEXT("SKYVERSE_KEY"), GetDefault<USkycatchSettings>()->SKYVERSE_KEY);
+		pRequest->SetURL(Stats.Endpoint);
+
+		const FString Endpoint = Stats.Endpoint;
+		pRequest->OnProcessRequestComplete().BindLambda(
+			[this, Endpoint, Remaining, OnAllProbed](FHttpRequestPtr pRequest, FHttpResponsePtr pResponse, bool connectedSuccessfully)
+		{
+			//Any answer below a server error means the endpoint is reachable and serving
+			if (connectedSuccessfully && pResponse.IsValid() && pResponse->GetResponseCode() < 500)
+			{
+				ReportSuccess(Endpoint, pRequest->GetElapsedTime());
+			}
+			else
+			{
+				ReportFailure(Endpoint);
+			}
+
+			if (--(*Remaining) == 0 && *OnAllProbed)
+			{
+				(*OnAllProbed)();
+			}
+		});
+		pRequest->ProcessRequest();
+	}
+}
+
+/**
+ * @brief Returns the statistics of every configured endpoint, in the order of the plugin settings.
+ */
+TArray<FSkycatchEndpointStats> FSkycatchEndpointPool::GetStats()
+{
+	SyncWithSettings();
+	return Endpoints;
+}
+
+/**
+ * @brief Checks the endpoint selection and failover order against three mock endpoints served by the HTTP server
+ * module on the local machine: one returning server errors, one slow and one fast that becomes slower than the slow
+ * one halfway, so the latency average has to move the selection. The configured endpoints are restored afterwards.
+ * Usage: Skycatch.BenchmarkEndpointFailover [Rounds=10] [SlowMs=200] [Port=8090]
+ */
+static FAutoConsoleCommand BenchmarkEndpointFailoverCommand(
+	TEXT("Skycatch.BenchmarkEndpointFailover"),
+	TEXT("Checks the endpoint selection and failover order against mock endpoints. Usage: Skycatch.BenchmarkEndpointFailover [Rounds=10] [SlowMs=200] [Port=8090]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 Rounds = Args.Num() > 0 ? FMath::Max(2, FCString::Atoi(*Args[0])) : 10;
+		const float SlowSeconds = (Args.Num() > 1 ? FMath::Max(10, FCString::Atoi(*Args[1])) : 200) / 1000.0f;
+		const uint32 Port = Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 8090;
+
+		const TSharedPtr<IHttpRouter> Router = FHttpServerModule::Get().GetHttpRouter(Port);
+		if (!Router.IsValid())
+		{
+			UE_LOG(LogSkycatch, Warning, TEXT("Endpoint failover benchmark: could not open port %u"), Port);
+			return;
+		}
+
+		struct FBenchmark
+		{
+			//Route names in the order the mock endpoints were hit, for the current lookup
+			TArray<FString> Hits;
+			//Delay of the fast endpoint, raised halfway through the rounds
+			float FastSeconds = 0.0f;
+			int32 Sent = 0;
+			int32 SwitchedAt = INDEX_NONE;
+			int32 Failed = 0;
+			TArray<FHttpRouteHandle> Routes;
+			FString SavedEndpoint;
+			TArray<FString> SavedMirrors;
+		};
+		const TSharedRef<FBenchmark> Benchmark = MakeShared<FBenchmark>();
+
+		//Answers a request after a delay, as a distant or loaded server would
+		auto Delayed = [](float Seconds, const FHttpResultCallback& OnComplete)
+		{
+			FHttpResultCallback Callback = OnComplete;
+			FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Callback](float)
+			{
+				Callback(FHttpServerResponse::Create(TEXT("[]"), TEXT("application/json")));
+				return false;
+			}), Seconds);
+		};
+		Benchmark->Routes.Add(Router->BindRoute(FHttpPath(TEXT("/broken")), EHttpServerRequestVerbs::VERB_GET,
+			[Benchmark](const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+		{
+			Benchmark->Hits.Add(TEXT("broken"));
+			OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::ServerError));
+			return true;
+		}));
+		Benchmark->Routes.Add(Router->BindRoute(FHttpPath(TEXT("/slow")), EHttpServerRequestVerbs::VERB_GET,
+			[Benchmark, Delayed, SlowSeconds](const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+		{
+			Benchmark->Hits.Add(TEXT("slow"));
+			Delayed(SlowSeconds, OnComplete);
+			return true;
+		}));
+		Benchmark->Routes.Add(Router->BindRoute(FHttpPath(TEXT("/fast")), EHttpServerRequestVerbs::VERB_GET,
+			[Benchmark, Delayed](const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+		{
+			Benchmark->Hits.Add(TEXT("fast"));
+			Delayed(Benchmark->FastSeconds, OnComplete);
+			return true;
+		}));
+		FHttpServerModule::Get().StartAllListeners();
+
+		//The mock endpoints replace the configured ones, the broken one as the main endpoint
+		USkycatchSettings* Settings = GetMutableDefault<USkycatchSettings>();
+		Benchmark->SavedEndpoint = Settings->SKYVERSE_ENDPOINT;
+		Benchmark->SavedMirrors = Settings->SKYVERSE_MIRROR_ENDPOINTS;
+		const FString Base = FString::Printf(TEXT("http://localhost:%u/"), Port);
+		Settings->SKYVERSE_ENDPOINT = Base + TEXT("broken");
+		Settings->SKYVERSE_MIRROR_ENDPOINTS = { Base + TEXT("slow"), Base + TEXT("fast") };
+
+		auto Check = [Benchmark](bool bPassed, const FString& What)
+		{
+			if (!bPassed)
+			{
+				Benchmark->Failed++;
+			}
+			UE_LOG(LogSkycatch, Display, TEXT("Endpoint failover benchmark: %s %s"), bPassed ? TEXT("ok") : TEXT("FAILED"), *What);
+		};
+		auto Join = [](const TArray<FString>& Hits) { return FString::Join(Hits, TEXT(" > ")); };
+
+		//Sends the lookups one at a time, failing over like the site lookups do
+		const TSharedRef<TFunction<void(TArray<FString>)>> Send = MakeShared<TFunction<void(TArray<FString>)>>();
+		const TSharedRef<TFunction<void()>> SendNext = MakeShared<TFunction<void()>>();
+		*Send = [=](TArray<FString> TriedEndpoints)
+		{
+			const FString Endpoint = FSkycatchEndpointPool::Get().SelectEndpoint(TriedEndpoints);
+			TriedEndpoints.Add(Endpoint);
+
+			TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
+			Request->SetURL(Endpoint + FString::Printf(TEXT("?round=%d"), Benchmark->Sent));
+			Request->SetVerb("GET");
+			Request->OnProcessRequestComplete().BindLambda([=](FHttpRequestPtr pRequest, FHttpResponsePtr Response, bool bConnected)
+			{
+				FSkycatchEndpointPool& EndpointPool = FSkycatchEndpointPool::Get();
+				if (!bConnected || !Response.IsValid() || Response->GetResponseCode() >= 500)
+				{
+					EndpointPool.ReportFailure(Endpoint);
+					if (!EndpointPool.SelectEndpoint(TriedEndpoints).IsEmpty())
+					{
+						(*Send)(TriedEndpoints);
+						return;
+					}
+				}
+				else
+				{
+					EndpointPool.ReportSuccess(Endpoint, pRequest->GetElapsedTime());
+				}
+				(*SendNext)();
+			});
+			Request->ProcessRequest();
+		};
+		*SendNext = [=]()
+		{
+			const int32 Round = Benchmark->Sent;
+			if (Round == 1)
+			{
+				//Nothing is measured yet, so the endpoints are tried in the configured order
+				Check(Join(Benchmark->Hits) == TEXT("broken > slow"), FString::Printf(TEXT("first lookup fails over from the server error: %s"), *Join(Benchmark->Hits)));
+			}
+			else if (Round == 2)
+			{
+				Check(Join(Benchmark->Hits) == TEXT("fast"), FString::Printf(TEXT("second lookup tries the endpoint without samples: %s"), *Join(Benchmark->Hits)));
+			}
+			else if (Round > 2 && Round <= Rounds)
+			{
+				Check(Join(Benchmark->Hits) == TEXT("fast"), FString::Printf(TEXT("lookup %d selects the fastest endpoint: %s"), Round, *Join(Benchmark->Hits)));
+			}
+			else if (Round > Rounds && Benchmark->Hits.Num() > 0 && Benchmark->Hits.Last() == TEXT("slow"))
+			{
+				//Lookups that still went to the degraded endpoint before the selection moved
+				Benchmark->SwitchedAt = Round - Rounds - 1;
+			}
+
+			if (Round == Rounds)
+			{
+				//The healthy endpoints are preferred, and the broken one is only left when nothing else is
+				FSkycatchEndpointPool& EndpointPool = FSkycatchEndpointPool::Get();
+				Check(EndpointPool.SelectEndpoint({ Base + TEXT("fast") }) == Base + TEXT("slow"), TEXT("the slow endpoint is next when the fast one is excluded"));
+				Check(EndpointPool.SelectEndpoint({ Base + TEXT("fast"), Base + TEXT("slow") }) == Base + TEXT("broken"), TEXT("the broken endpoint is the last resort"));
+				Check(EndpointPool.SelectEndpoint({ Base + TEXT("fast"), Base + TEXT("slow"), Base + TEXT("broken") }).IsEmpty(), TEXT("nothing is selected when every endpoint is excluded"));
+
+				//The fast endpoint becomes three times slower than the slow one
+				Benchmark->FastSeconds = SlowSeconds * 3.0f;
+			}
+
+			if (Round == Rounds * 2 || Benchmark->SwitchedAt != INDEX_NONE)
+			{
+				//Samples until the average of the fast endpoint goes over the slow one, starting near 0
+				const float Smoothing = FMath::Clamp(GetDefault<USkycatchSettings>()->EndpointLatencySmoothing, 0.01f, 0.99f);
+				const int32 Expected = FMath::CeilToInt(FMath::Loge(1.0f - 1.0f / 3.0f) / FMath::Loge(1.0f - Smoothing));
+				Check(Benchmark->SwitchedAt != INDEX_NONE, FString::Printf(TEXT("the selection moves to the slow endpoint after %d lookups on the degraded one (about %d expected from the smoothing)"),
+					Benchmark->SwitchedAt, Expected));
+				for (const FSkycatchEndpointStats& Stats : FSkycatchEndpointPool::Get().GetStats())
+				{
+					UE_LOG(LogSkycatch, Display, TEXT("  %s: %s, %.1f ms average, %d successes, %d failures"), *Stats.Endpoint,
+						Stats.bHealthy ? TEXT("healthy") : TEXT("unhealthy"), Stats.LatencyMs, Stats.Successes, Stats.Failures);
+				}
+				UE_LOG(LogSkycatch, Display, TEXT("Endpoint failover benchmark: %s"), Benchmark->Failed == 0 ? TEXT("passed") : TEXT("FAILED"));
+
+				GetMutableDefault<USkycatchSettings>()->SKYVERSE_ENDPOINT = Benchmark->SavedEndpoint;
+				GetMutableDefault<USkycatchSettings>()->SKYVERSE_MIRROR_ENDPOINTS = Benchmark->SavedMirrors;
+				for (const FHttpRouteHandle& Route : Benchmark->Routes)
+				{
+					Router->UnbindRoute(Route);
+				}
+
+				//Breaks the references the functions hold to themselves
+				*Send = nullptr;
+				*SendNext = nullptr;
+				return;
+			}
+
+			Benchmark->Sent++;
+			Benchmark->Hits.Reset();
+			(*Send)(TArray<FString>());
+		};
+		(*SendNext)();
+	}));
@@ -0,0 +1,265 @@
+/**
+ * Including the Header libraries and files required
+ **/
+#include "SkycatchHeightQuery.h"
+#include "Cesium3DTileset.h"
+#include "CesiumGeoreference.h"
+#include "CesiumGeospatial/Cartographic.h"
+#include "CesiumGeospatial/Ellipsoid.h"
+#include "Components/PrimitiveComponent.h"
+#include "Async/ParallelFor.h"
+#include "SkycatchSettings.h"
+
+/**
+ * @brief Approximate length in meters of a degree of latitude, used to convert the cache tolerance to degrees.
+ */
+static constexpr double MetersPerDegree = 111320.0;
+
+/**
+ * @brief Transforms longitude, latitude and height points to UE world coordinates in one batch, computing the
+ * transform of the georeference once for all of them.
+ *
+ * @param Georeference as the georeference of the points
+ * @param LongitudeLatitudeHeight as the points to transform
+ * @param OutLocations as the transformed points
+ */
+void FSkycatchHeightCache::TransformToUnreal(const ACesiumGeoreference* Georeference, const TArray<FVector>& LongitudeLatitudeHeight, TArray<FVector>& OutLocations)
+{
+	OutLocations.SetNumUninitialized(LongitudeLatitudeHeight.Num());
+
+	//The georeference transforms to absolute world coordinates, the world origin is removed once for every point
+	const glm::dmat4 EcefToUnreal = Georeference->GetEllipsoidCenteredToAbsoluteUnrealWorldTransform();
+	const UWorld* World = Georeference->GetWorld();
+	const FVector WorldOrigin = World ? FVector(World->OriginLocation) : FVector::ZeroVector;
+
+	ParallelFor(LongitudeLatitudeHeight.Num(), [&](int32 Index)
+	{
+		const FVector& Point = LongitudeLatitudeHeight[Index];
+		const glm::dvec3 Ecef = CesiumGeospatial::Ellipsoid::WGS84.cartographicToCartesian(
+			CesiumGeospatial::Cartographic::fromDegrees(Point.X, Point.Y, Point.Z));
+		const glm::dvec4 Unreal = EcefToUnreal * glm::dvec4(Ecef, 1.0);
+		OutLocations[Index] = FVector(Unreal.x, Unreal.y, Unreal.z) - WorldOrigin;
+	});
+}
+
+/**
+ * @brief Finds the surface under the given points among the tiles of the tileset that are shown and collide.
+ * Points without such a tile under them are left unresolved, to be retried once more tiles are loaded.
+ *
+ * @param Tileset as the tileset to trace
+ * @param Georeference as the georeference of the points
+ * @param LongitudeLatitude as the points of the query, in longitude, latitude
+ * @param Indices as the indices of the points to resolve
+ * @param Samples as the samples of the query, written for the resolved points
+ * @param OutUnresolved as the indices of the points without a loaded tile under them
+ */
+void FSkycatchHeightCache::Resolve(const ACesium3DTileset* Tileset, const ACesiumGeoreference* Georeference, const TArray<FVector2D>& LongitudeLatitude,
+	const TArray<int32>& Indices, TArray<FSkycatchHeightSample>& Samples, TArray<int32>& OutUnresolved)
+{
+	if (!Tileset || !Georeference)
+	{
+		OutUnresolved.Append(Indices);
+		return;
+	}
+
+	const USkycatchSettings* Settings = GetDefault<USkycatchSettings>();
+	const double Tolerance = Settings->HeightCacheToleranceMeters / MetersPerDegree;
+
+	//Collects the tiles that are shown and collide, indexed by their horizontal bounds
+	TArray<UPrimitiveComponent*> TileComponents;
+	TArray<FBox> TileBounds;
+	FBox2D AllBounds(ForceInit);
+	TInlineComponentArray<UPrimitiveComponent*> Components(Tileset);
+	for (UPrimitiveComponent* Component : Components)
+	{
+		if (Component->IsVisible() && Component->IsCollisionEnabled() && Component->GetBodySetup())
+		{
+			const FBox Bounds = Component->Bounds.GetBox();
+			TileComponents.Add(Component);
+			TileBounds.Add(Bounds);
+			AllBounds += FBox2D(FVector2D(Bounds.Min), FVector2D(Bounds.Max));
+		}
+	}
+	if (TileComponents.Num() == 0)
+	{
+		OutUnresolved.Append(Indices);
+		return;
+	}
+
+	TQuadTree<int32> TileTree(AllBounds);
+	for (int32 Tile = 0; Tile < TileComponents.Num(); Tile++)
+	{
+		TileTree.Insert(Tile, FBox2D(FVector2D(TileBounds[Tile].Min), FVector2D(TileBounds[Tile].Max)));
+	}
+
+	//Every point is traced between its highest and lowest possible heights
+	TArray<FVector> GeodeticEnds;
+	GeodeticEnds.SetNumUninitialized(Indices.Num() * 2);
+	for (int32 Query = 0; Query < Indices.Num(); Query++)
+	{
+		const FVector2D& Point = LongitudeLatitude[Indices[Query]];
+		GeodeticEnds[Query * 2] = FVector(Point.X, Point.Y, Settings->HeightQueryMaxHeight);
+		GeodeticEnds[Query * 2 + 1] = FVector(Point.X, Point.Y, Settings->HeightQueryMinHeight);
+	}
+	TArray<FVector> Ends;
+	TransformToUnreal(Georeference, GeodeticEnds, Ends);
+
+	//The caches of the tiles are only read while tracing, the new heights are added afterwards
+	TArray<FTileHeights*> TileHeights;
+	TileHeights.Init(nullptr, TileComponents.Num());
+	for (int32 Tile = 0; Tile < TileComponents.Num(); Tile++)
+	{
+		TileHeights[Tile] = Tiles.Find(TileComponents[Tile]);
+	}
+
+	struct FTrace
+	{
+		bool bResolved = false;
+		FSkycatchHeightSample Sample;
+		TArray<TPair<int32, FSkycatchHeightSample>, TInlineAllocator<4>> NewHeights;
+	};
+	TArray<FTrace> Traces;
+	Traces.SetNum(Indices.Num());
+
+	const glm::dmat4 UnrealToEcef = Georeference->GetAbsoluteUnrealWorldToEllipsoidCenteredTransform();
+	const UWorld* World = Georeference->GetWorld();
+	const FVector WorldOrigin = World ? FVector(World->OriginLocation) : FVector::ZeroVector;
+
+	ParallelFor(Indices.Num(), [&](int32 Query)
+	{
+		const FVector2D& Point = LongitudeLatitude[Indices[Query]];
+		const FVector& Start = Ends[Query * 2];
+		const FVector& End = Ends[Query * 2 + 1];
+		FTrace& Trace = Traces[Query];
+
+		TArray<int32> Candidates;
+		TileTree.GetElements(FBox2D(FVector2D(FVector::Min(Start, End)), FVector2D(FVector::Max(Start, End))), Candidates);
+
+		for (const int32 Tile : Candidates)
+		{
+			if (!FMath::LineBoxIntersection(TileBounds[Tile], Start, End, End - Start))
+			{
+				continue;
+			}
+			Trace.bResolved = true;
+
+			//A height found on the tile before is reused
+			FSkycatchHeightSample TileSample;
+			bool bCached = false;
+			if (const FTileHeights* Heights = TileHeights[Tile])
+			{
+				TArray<FCachedHeight> Cached;
+				Heights->Heights->GetElements(FBox2D(Point - FVector2D(Tolerance), Point + FVector2D(Tolerance)), Cached);
+				if (Cached.Num() > 0)
+				{
+					TileSample = Cached[0].Sample;
+					bCached = true;
+				}
+			}
+
+			if (!bCached)
+			{
+				FHitResult Hit;
+				const FCollisionQueryParams Params(SCENE_QUERY_STAT(SkycatchHeightQuery), true);
+				if (TileComponents[Tile]->LineTraceComponent(Hit, Start, End, Params))
+				{
+					const glm::dvec4 Ecef = UnrealToEcef * glm::dvec4(Hit.ImpactPoint.X + WorldOrigin.X, Hit.ImpactPoint.Y + WorldOrigin.Y, Hit.ImpactPoint.Z + WorldOrigin.Z, 1.0);
+					const std::optional<CesiumGeospatial::Cartographic> Cartographic =
+						CesiumGeospatial::Ellipsoid::WGS84.cartesianToCartographic(glm::dvec3(Ecef));
+					TileSample.bHit = Cartographic.has_value();
+					TileSample.Height = Cartographic ? Cartographic->height : 0.0;
+				}
+				Trace.NewHeights.Add({ Tile, TileSample });
+			}
+
+			//Overlapping tiles of different levels of detail keep the highest surface
+			if (TileSample.bHit && (!Trace.Sample.bHit || TileSample.Height > Trace.Sample.Height))
+			{
+				Trace.Sample = TileSample;
+			}
+		}
+	});
+
+	//Caches the new heights in the quadtree of their tile, bounded by the longitude, latitude bounds of the tile
+	TArray<FVector> HitPoints;
+	TArray<int32> HitQueries;
+	for (int32 Query = 0; Query < Indices.Num(); Query++)
+	{
+		FTrace& Trace = Traces[Query];
+		const FVector2D& Point = LongitudeLatitude[Indices[Query]];
+		for (const TPair<int32, FSkycatchHeightSample>& NewHeight : Trace.NewHeights)
+		{
+			FTileHeights& Heights = Tiles.FindOrAdd(TileComponents[NewHeight.Key]);
+			if (!Heights.Heights)
+			{
+				FVector Corners[8];
+				TileBounds[NewHeight.Key].GetVertices(Corners);
+				FBox2D TileBox(ForceInit);
+				for (const FVector& Corner : Corners)
+				{
+					const glm::dvec3 Geodetic = Georeference->TransformUnrealToLongitudeLatitudeHeight(glm::dvec3(Corner.X, Corner.Y, Corner.Z));
+					TileBox += FVector2D(Geodetic.x, Geodetic.y);
+				}
+				Heights.Heights = MakeUnique<TQuadTree<FCachedHeight>>(TileBox.ExpandBy(Tolerance), FMath::Max(Tolerance, 1e-6));
+			}
+			Heights.Heights->Insert({ Point, NewHeight.Value }, FBox2D(Point, Point));
+			Heights.Num++;
+		}
+
+		if (!Trace.bResolved)
+		{
+			OutUnresolved.Add(Indices[Query]);
+			continue;
+		}
+
+		Samples[Indices[Query]] = Trace.Sample;
+		if (Trace.Sample.bHit)
+		{
+			HitPoints.Add(FVector(Point.X, Point.Y, Trace.Sample.Height));
+			HitQueries.Add(Indices[Query]);
+		}
+	}
+
+	//The locations are computed from the heights, so cached heights stay valid when the georeference changes
+	TArray<FVector> HitLocations;
+	TransformToUnreal(Georeference, HitPoints, HitLocations);
+	for (int32 Hit = 0; Hit < HitQueries.Num(); Hit++)
+	{
+		Samples[HitQueries[Hit]].Location = HitLocations[Hit];
+	}
+}
+
+/**
+ * @brief Drops the cached heights of the tiles that were unloaded.
+ */
+void FSkycatchHeightCache::Prune()
+{
+	for (auto It = Tiles.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+/**
+ * @brief Drops all the cached heights.
+ */
+void FSkycatchHeightCache::Empty()
+{
+	Tiles.Empty();
+}
+
+/**
+ * @brief Returns the number of cached heights.
+ */
+int32 FSkycatchHeightCache::GetNumCached() const
+{
+	int32 NumCached = 0;
+	for (const TPair<TWeakObjectPtr<UPrimitiveComponent>, FTileHeights>& Tile : Tiles)
+	{
+		NumCached += Tile.Value.Num;
+	}
+	return NumCached;
+}
@@ -0,0 +1,374 @@
+/**
+ * Including the Header libraries and files required
+ **/
+#include "SkycatchOutline.h"
+#include "SkycatchPolygonUnion.h"
+#include "Algo/Reverse.h"
+
+/**
+ * @brief Distance in degrees between the bridges that go around the right of the rings, about a centimeter.
+ */
+static constexpr double OuterBridgeSpacing = 1e-7;
+
+/**
+ * @brief Parses a GeoJSON Feature, Polygon or MultiPolygon. Returns false when the geometry has no ring.
+ *
+ * @param Geometry as the json object of the geometry
+ */
+bool FSkycatchOutline::Parse(const TSharedPtr<FJsonObject>& Geometry)
+{
+	Reset();
+	if (!Geometry.IsValid())
+	{
+		return false;
+	}
+
+	FString Type;
+	Geometry->TryGetStringField(TEXT("type"), Type);
+
+	// Handle different configurations of the incoming outline
+	const TSharedPtr<FJsonObject>* FeatureGeometry = nullptr;
+	if (Type == TEXT("Feature") && Geometry->TryGetObjectField(TEXT("geometry"), FeatureGeometry))
+	{
+		return Parse(*FeatureGeometry);
+	}
+
+	const TArray<TSharedPtr<FJsonValue>>* Coordinates = nullptr;
+	if (!Geometry->TryGetArrayField(TEXT("coordinates"), Coordinates))
+	{
+		return false;
+	}
+
+	if (Type == TEXT("MultiPolygon"))
+	{
+		for (const TSharedPtr<FJsonValue>& Polygon : *Coordinates)
+		{
+			AddPart(Polygon->AsArray());
+		}
+	}
+	else
+	{
+		AddPart(*Coordinates);
+	}
+	return NumRings() > 0;
+}
+
+/**
+ * @brief Parses a single ring in longitude, latitude and height, as kept by the actors and replicated.
+ *
+ * @param LongitudeLatitudeHeight as the ring
+ */
+void FSkycatchOutline::SetRing(const TArray<FVector>& LongitudeLatitudeHeight)
+{
+	Reset();
+	for (const FVector& Point : LongitudeLatitudeHeight)
+	{
+		Points.Add(FVector2D(Point.X, Point.Y));
+	}
+	if (Points.Num() > 1 && Points[0].Equals(Points.Last(), 0.0))
+	{
+		Points.Pop();
+	}
+	if (Points.Num() < 3)
+	{
+		Points.Reset();
+		return;
+	}
+	RingStarts.Add(Points.Num());
+	PartStarts.Add(1);
+}
+
+/**
+ * @brief Adds the points of a GeoJSON ring as a new ring of the current part.
+ *
+ * @param Coordinates as the json array of the positions of the ring
+ */
+void FSkycatchOutline::AddRing(const TArray<TSharedPtr<FJsonValue>>& Coordinates)
+{
+	const int32 FirstPoint = Points.Num();
+	for (const TSharedPtr<FJsonValue>& Position : Coordinates)
+	{
+		const TArray<TSharedPtr<FJsonValue>>& Coords = Position->AsArray();
+		if (Coords.Num() < 2)
+		{
+			continue;
+		}
+		FString lng;
+		FString lat;
+		//Gets the longitude and latitude of every coordinate
+		Coords[0].Get()->TryGetString(lng);
+		Coords[1].Get()->TryGetString(lat);
+		Points.Add(FVector2D(FCString::Atod(*lng), FCString::Atod(*lat)));
+	}
+
+	//The closing point of the ring is implicit
+	if (Points.Num() - FirstPoint > 1 && Points[FirstPoint].Equals(Points.Last(), 0.0))
+	{
+		Points.Pop();
+	}
+	if (Points.Num() - FirstPoint < 3)
+	{
+		Points.SetNum(FirstPoint);
+		return;
+	}
+	RingStarts.Add(Points.Num());
+}
+
+/**
+ * @brief Adds the rings of a GeoJSON Polygon as a new part.
+ *
+ * @param Rings as the json array of the rings of the polygon
+ */
+void FSkycatchOutline::AddPart(const TArray<TSharedPtr<FJsonValue>>& Rings)
+{
+	for (const TSharedPtr<FJsonValue>& Ring : Rings)
+	{
+		AddRing(Ring->AsArray());
+	}
+	if (NumRings() > PartStarts.Last())
+	{
+		PartStarts.Add(NumRings());
+	}
+}
+
+/**
+ * @brief Orients the rings, computes the bounds of the parts and bridges the rings into one. Can run on any thread.
+ */
+void FSkycatchOutline::Build()
+{
+	PartBounds.Reset(NumParts());
+	Bridged.Reset();
+
+	//Outer rings are counter-clockwise and holes clockwise, so the bridged ring turns the same way around all of them
+	struct FBridgedRing
+	{
+		TArray<FVector2D> Points;
+		int32 RightIndex = 0;
+		bool bOuter = false;
+	};
+	TArray<FBridgedRing> Rings;
+	Rings.Reserve(NumRings());
+	for (int32 Part = 0; Part < NumParts(); Part++)
+	{
+		FBox2D Bounds(ForceInit);
+		for (int32 Ring = PartStarts[Part]; Ring < PartStarts[Part + 1]; Ring++)
+		{
+			FBridgedRing& Bridging = Rings.AddDefaulted_GetRef();
+			Bridging.Points = TArray<FVector2D>(GetRing(Ring));
+			Bridging.bOuter = Ring == PartStarts[Part];
+			if ((FSkycatchPolygonUnion::SignedArea(Bridging.Points) < 0.0) == Bridging.bOuter)
+			{
+				Algo::Reverse(Bridging.Points);
+			}
+			for (int32 Index = 0; Index < Bridging.Points.Num(); Index++)
+			{
+				const FVector2D& Point = Bridging.Points[Index];
+				const FVector2D& Right = Bridging.Points[Bridging.RightIndex];
+				if (Point.X > Right.X || (Point.X == Right.X && Point.Y > Right.Y))
+				{
+					Bridging.RightIndex = Index;
+				}
+				if (Bridging.bOuter)
+				{
+					Bounds += Point;
+				}
+			}
+		}
+		PartBounds.Add(Bounds);
+	}
+	if (Rings.Num() == 0)
+	{
+		return;
+	}
+
+	//The rings are bridged from right to left, so a ring on the right of a bridge is already part of the bridged ring
+	//and the rings left to bridge are all on its left
+	Rings.StableSort([](const FBridgedRing& A, const FBridgedRing& B)
+	{
+		const double AX = A.Points[A.RightIndex].X;
+		const double BX = B.Points[B.RightIndex].X;
+		return AX > BX || (AX == BX && A.bOuter && !B.bOuter);
+	});
+
+	TArray<FVector2D> Ring = MoveTemp(Rings[0].Points);
+	double OuterBridgeX = Ring[Rings[0].RightIndex].X;
+	for (int32 Index = 1; Index < Rings.Num(); Index++)
+	{
+		const FBridgedRing& Bridging = Rings[Index];
+		const FVector2D Start = Bridging.Points[Bridging.RightIndex];
+
+		//The ring is walked from its rightmost point back to it
+		TArray<FVector2D> Loop;
+		Loop.Reserve(Bridging.Points.Num() + 5);
+		for (int32 Offset = 0; Offset < Bridging.Points.Num(); Offset++)
+		{
+			Loop.Add(Bridging.Points[(Bridging.RightIndex + Offset) % Bridging.Points.Num()]);
+		}
+		Loop.Add(Start);
+
+		const int32 Bridge = FindBridge(Ring, Start);
+		if (Bridge != INDEX_NONE)
+		{
+			Loop.Add(Ring[Bridge]);
+			Ring.Insert(Loop, Bridge + 1);
+			continue;
+		}
+
+		//Nothing is on the right of the ring, so it is reached around the right of everything bridged so far
+		int32 Right = 0;
+		for (int32 Point = 1; Point < Ring.Num(); Point++)
+		{
+			Right = Ring[Point].X > Ring[Right].X ? Point : Right;
+		}
+		OuterBridgeX += OuterBridgeSpacing;
+		const FVector2D RightPoint = Ring[Right];
+		TArray<FVector2D> Path = { FVector2D(OuterBridgeX, RightPoint.Y), FVector2D(OuterBridgeX, Start.Y) };
+		Path.Append(Loop);
+		Path.Append({ FVector2D(OuterBridgeX, Start.Y), FVector2D(OuterBridgeX, RightPoint.Y), RightPoint });
+		Ring.Insert(Path, Right + 1);
+	}
+
+	Bridged.Reserve(Ring.Num());
+	for (const FVector2D& Point : Ring)
+	{
+		Bridged.Add(FVector(Point.X, Point.Y, 0.0));
+	}
+}
+
+/**
+ * @brief Removes all the rings.
+ */
+void FSkycatchOutline::Reset()
+{
+	Points.Reset();
+	RingStarts.Reset();
+	RingStarts.Add(0);
+	PartStarts.Reset();
+	PartStarts.Add(0);
+	PartBounds.Reset();
+	Bridged.Reset();
+}
+
+/**
+ * @brief Returns the points of a ring, without the closing point.
+ *
+ * @param Ring as the index of the ring
+ */
+TArrayView<const FVector2D> FSkycatchOutline::GetRing(int32 Ring) const
+{
+	return TArrayView<const FVector2D>(Points.GetData() + RingStarts[Ring], RingStarts[Ring + 1] - RingStarts[Ring]);
+}
+
+/**
+ * @brief Returns every ring as its own array, to be combined with the even-odd rule.
+ */
+TArray<TArray<FVector2D>> FSkycatchOutline::GetRings() const
+{
+	TArray<TArray<FVector2D>> Rings;
+	Rings.Reserve(NumRings());
+	for (int32 Ring = 0; Ring < NumRings(); Ring++)
+	{
+		Rings.Add(TArray<FVector2D>(GetRing(Ring)));
+	}
+	return Rings;
+}
+
+/**
+ * @brief Returns the rings of a part as their own arrays, the outer ring first.
+ *
+ * @param Part as the index of the part
+ */
+TArray<TArray<FVector2D>> FSkycatchOutline::GetPartRings(int32 Part) const
+{
+	TArray<TArray<FVector2D>> Rings;
+	Rings.Reserve(PartStarts[Part + 1] - PartStarts[Part]);
+	for (int32 Ring = PartStarts[Part]; Ring < PartStarts[Part + 1]; Ring++)
+	{
+		Rings.Add(TArray<FVector2D>(GetRing(Ring)));
+	}
+	return Rings;
+}
+
+/**
+ * @brief Returns the bounds of all the parts, computed by Build.
+ */
+FBox2D FSkycatchOutline::GetBounds() const
+{
+	FBox2D Bounds(ForceInit);
+	for (const FBox2D& Part : PartBounds)
+	{
+		Bounds += Part;
+	}
+	return Bounds;
+}
+
+/**
+ * @brief Returns the index of the point of a ring that a bridge from a point on its left reaches without crossing
+ * the ring, or INDEX_NONE when the ray to the right of the point misses the ring.
+ *
+ * @param Ring as the ring to bridge to
+ * @param Point as the point the bridge starts from
+ */
+int32 FSkycatchOutline::FindBridge(const TArray<FVector2D>& Ring, const FVector2D& Point)
+{
+	//Finds the closest edge crossed by the ray to the right of the point, and its rightmost end
+	double HitX = TNumericLimits<double>::Max();
+	int32 Candidate = INDEX_NONE;
+	for (int32 Index = 0; Index < Ring.Num(); Index++)
+	{
+		const FVector2D& A = Ring[Index];
+		const FVector2D& B = Ring[(Index + 1) % Ring.Num()];
+		if ((A.Y > Point.Y) == (B.Y > Point.Y))
+		{
+			continue;
+		}
+		const double X = A.X + (Point.Y - A.Y) * (B.X - A.X) / (B.Y - A.Y);
+		if (X >= Point.X && X < HitX)
+		{
+			HitX = X;
+			Candidate = A.X > B.X ? Index : (Index + 1) % Ring.Num();
+		}
+	}
+	if (Candidate == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	//A point of the ring inside the triangle between the point, the hit and the candidate would hide the candidate,
+	//the one closest in angle to the ray is visible
+	const FVector2D Hit(HitX, Point.Y);
+	const FVector2D Corner = Ring[Candidate];
+	auto Side = [](const FVector2D& A, const FVector2D& B, const FVector2D& C)
+	{
+		return FVector2D::CrossProduct(B - A, C - A);
+	};
+	const double Orientation = Side(Point, Hit, Corner);
+	double BestTangent = TNumericLimits<double>::Max();
+	double BestDistance = TNumericLimits<double>::Max();
+	int32 Bridge = Candidate;
+	for (int32 Index = 0; Index < Ring.Num(); Index++)
+	{
+		const FVector2D& Vertex = Ring[Index];
+		if (Index == Candidate || Vertex.X < Point.X || Orientation == 0.0)
+		{
+			continue;
+		}
+		const bool bInside =
+			Side(Point, Hit, Vertex) * Orientation >= 0.0 &&
+			Side(Hit, Corner, Vertex) * Orientation >= 0.0 &&
+			Side(Corner, Point, Vertex) * Orientation >= 0.0;
+		if (!bInside)
+		{
+			continue;
+		}
+		const double Tangent = FMath::Abs(Vertex.Y - Point.Y) / FMath::Max(Vertex.X - Point.X, UE_DOUBLE_SMALL_NUMBER);
+		const double Distance = FVector2D::DistSquared(Point, Vertex);
+		if (Tangent < BestTangent || (Tangent == BestTangent && Distance < BestDistance))
+		{
+			BestTangent = Tangent;
+			BestDistance = Distance;
+			Bridge = Index;
+		}
+	}
+	return Bridge;
+}
@@ -0,0 +1,573 @@
+/**
+ * Including the Header libraries and files required
+ **/
+#include "SkycatchPolygonUnion.h"
+#include "Algo/Reverse.h"
+#include "Misc/AutomationTest.h"
+
+/**
+ * @brief Segment of an outline edge after splitting it at the intersections with the other outlines
+ */
+struct FSkycatchUnionSegment
+{
+	FVector2D Start;
+	FVector2D End;
+	bool bUsed = false;
+};
+
+/**
+ * @brief Point where an outline edge is split, at the parameter T along the edge
+ */
+struct FSkycatchUnionSplit
+{
+	double T;
+	FVector2D Point;
+};
+
+/**
+ * @brief Welds points closer than the tolerance to the first one seen, so the points computed for different outlines
+ * are exactly the same. Points are bucketed in a grid of the tolerance size.
+ */
+struct FSkycatchVertexWeld
+{
+	explicit FSkycatchVertexWeld(double InTolerance)
+		: Tolerance(InTolerance)
+		, CellSize(FMath::Max(InTolerance, 1e-12))
+	{
+	}
+
+	FVector2D Weld(const FVector2D& Point)
+	{
+		const int64 CellX = FMath::FloorToInt64(Point.X / CellSize);
+		const int64 CellY = FMath::FloorToInt64(Point.Y / CellSize);
+		for (int64 X = CellX - 1; X <= CellX + 1; X++)
+		{
+			for (int64 Y = CellY - 1; Y <= CellY + 1; Y++)
+			{
+				if (const TArray<FVector2D>* Cell = Cells.Find(TPair<int64, int64>(X, Y)))
+				{
+					for (const FVector2D& Existing : *Cell)
+					{
+						if (FVector2D::Distance(Existing, Point) <= Tolerance)
+						{
+							return Existing;
+						}
+					}
+				}
+			}
+		}
+		Cells.FindOrAdd(TPair<int64, int64>(CellX, CellY)).Add(Point);
+		return Point;
+	}
+
+	double Tolerance;
+	double CellSize;
+	TMap<TPair<int64, int64>, TArray<FVector2D>> Cells;
+};
+
+/**
+ * @brief Returns the 2D cross product of two vectors
+ */
+static double Cross2D(const FVector2D& A, const FVector2D& B)
+{
+	return A.X * B.Y - A.Y * B.X;
+}
+
+/**
+ * @brief Returns the distance from a point to a segment
+ */
+static double PointSegmentDistance(const FVector2D& Point, const FVector2D& Start, const FVector2D& End)
+{
+	const FVector2D Segment = End - Start;
+	const double LengthSquared = Segment.SizeSquared();
+	const double T = LengthSquared > 0.0 ? FMath::Clamp(FVector2D::DotProduct(Point - Start, Segment) / LengthSquared, 0.0, 1.0) : 0.0;
+	return FVector2D::Distance(Point, Start + Segment * T);
+}
+
+/**
+ * @brief Computes the proper intersection of two segments, returns false when they don't cross or are parallel
+ */
+static bool SegmentIntersection(const FVector2D& A0, const FVector2D& A1, const FVector2D& B0, const FVector2D& B1, double& OutTA, double& OutTB)
+{
+	const FVector2D DA = A1 - A0;
+	const FVector2D DB = B1 - B0;
+	const double Denominator = Cross2D(DA, DB);
+	if (FMath::Abs(Denominator) <= SMALL_NUMBER * DA.Size() * DB.Size())
+	{
+		return false;
+	}
+
+	const FVector2D Offset = B0 - A0;
+	OutTA = Cross2D(Offset, DB) / Denominator;
+	OutTB = Cross2D(Offset, DA) / Denominator;
+	return OutTA > 0.0 && OutTA < 1.0 && OutTB > 0.0 && OutTB < 1.0;
+}
+
+/**
+ * @brief Returns the signed area of a ring, positive for counter-clockwise rings.
+ *
+ * @param Ring as the ring
+ */
+double FSkycatchPolygonUnion::SignedArea(const TArray<FVector2D>& Ring)
+{
+	double Area = 0.0;
+	for (int32 i = 0, j = Ring.Num() - 1; i < Ring.Num(); j = i++)
+	{
+		Area += Cross2D(Ring[j], Ring[i]);
+	}
+	return Area * 0.5;
+}
+
+/**
+ * @brief Returns whether a point is inside a ring, using the even-odd rule.
+ *
+ * @param Ring as the ring
+ * @param Point as the point to test
+ */
+bool FSkycatchPolygonUnion::IsPointInside(const TArray<FVector2D>& Ring, const FVector2D& Point)
+{
+	bool bInside = false;
+	for (int32 i = 0, j = Ring.Num() - 1; i < Ring.Num(); j = i++)
+	{
+		const FVector2D& A = Ring[i];
+		const FVector2D& B = Ring[j];
+		if ((A.Y > Point.Y) != (B.Y > Point.Y) &&
+			Point.X < (B.X - A.X) * (Point.Y - A.Y) / (B.Y - A.Y) + A.X)
+		{
+			bInside = !bInside;
+		}
+	}
+	return bInside;
+}
+
+/**
+ * @brief Returns the bounds of a ring.
+ *
+ * @param Ring as the ring
+ */
+FBox2D FSkycatchPolygonUnion::GetBounds(const TArray<FVector2D>& Ring)
+{
+	FBox2D Bounds(ForceInit);
+	for (const FVector2D& Point : Ring)
+	{
+		Bounds += Point;
+	}
+	return Bounds;
+}
+
+/**
+ * @brief Returns the length of a degree of longitude relative to a degree of latitude at a latitude.
+ *
+ * @param Latitude as the latitude, in degrees
+ */
+double FSkycatchPolygonUnion::GetLongitudeScale(double Latitude)
+{
+	//Clamped so the tolerance stays finite next to the poles
+	return FMath::Max(FMath::Cos(FMath::DegreesToRadians(Latitude)), 0.01);
+}
+
+/**
+ * @brief Expands bounds of longitude, latitude points by a tolerance in degrees of latitude, scaling it on the
+ * longitude by the cosine of the latitude.
+ *
+ * @param Bounds as the bounds to expand
+ * @param Tolerance as the distance to expand by, in degrees of latitude
+ */
+FBox2D FSkycatchPolygonUnion::ExpandBounds(const FBox2D& Bounds, double Tolerance)
+{
+	if (!Bounds.bIsValid)
+	{
+		return Bounds;
+	}
+	const FVector2D Extent(Tolerance / GetLongitudeScale(Bounds.GetCenter().Y), Tolerance);
+	return FBox2D(Bounds.Min - Extent, Bounds.Max + Extent);
+}
+
+/**
+ * @brief Returns a copy of a ring with the longitudes scaled to the length of a degree of latitude, so distances are
+ * the same in both directions
+ */
+static TArray<FVector2D> ScaleLongitudes(const TArray<FVector2D>& Ring, double LongitudeScale)
+{
+	TArray<FVector2D> Scaled;
+	Scaled.Reserve(Ring.Num());
+	for (const FVector2D& Point : Ring)
+	{
+		Scaled.Add(FVector2D(Point.X * LongitudeScale, Point.Y));
+	}
+	return Scaled;
+}
+
+/**
+ * @brief Returns whether two outlines overlap or touch within the given tolerance.
+ *
+ * @param A as the first outline
+ * @param B as the second outline
+ * @param Tolerance as the distance under which the outlines are considered touching, in degrees of latitude
+ */
+bool FSkycatchPolygonUnion::Overlaps(const TArray<FVector2D>& A, const TArray<FVector2D>& B, double Tolerance)
+{
+	if (A.Num() < 3 || B.Num() < 3)
+	{
+		return false;
+	}
+
+	const FBox2D BoundsA = GetBounds(A);
+	if (!ExpandBounds(BoundsA, Tolerance).Intersect(GetBounds(B)))
+	{
+		return false;
+	}
+
+	//One outline containing the other
+	if (IsPointInside(B, A[0]) || IsPointInside(A, B[0]))
+	{
+		return true;
+	}
+
+	//The edges are compared with the same scale on both axes
+	const double LongitudeScale = GetLongitudeScale(BoundsA.GetCenter().Y);
+	const TArray<FVector2D> ScaledA = ScaleLongitudes(A, LongitudeScale);
+	const TArray<FVector2D> ScaledB = ScaleLongitudes(B, LongitudeScale);
+	const FBox2D BoundsB = GetBounds(ScaledB);
+
+	//Crossing or touching edges
+	for (int32 i = 0, ip = ScaledA.Num() - 1; i < ScaledA.Num(); ip = i++)
+	{
+		FBox2D EdgeBounds(ForceInit);
+		EdgeBounds += ScaledA[ip];
+		EdgeBounds += ScaledA[i];
+		EdgeBounds = EdgeBounds.ExpandBy(Tolerance);
+		if (!EdgeBounds.Intersect(BoundsB))
+		{
+			continue;
+		}
+
+		for (int32 j = 0, jp = ScaledB.Num() - 1; j < ScaledB.Num(); jp = j++)
+		{
+			double TA, TB;
+			if (SegmentIntersection(ScaledA[ip], ScaledA[i], ScaledB[jp], ScaledB[j], TA, TB) ||
+				PointSegmentDistance(ScaledA[i], ScaledB[jp], ScaledB[j]) <= Tolerance ||
+				PointSegmentDistance(ScaledB[j], ScaledA[ip], ScaledA[i]) <= Tolerance)
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Merges a group of outlines into the outer rings of their union. Vertices closer than the tolerance are
+ * welded so touching outlines join, and the intersections are computed once and shared by both outlines.
+ * Returns false when the union has holes, since they can't be expressed as clipping polygons, or when its boundary
+ * can't be traced into closed rings, in which case the outlines have to be used as they are.
+ *
+ * @param Outlines as the outlines to merge
+ * @param Tolerance as the distance under which vertices are welded, in degrees of latitude
+ * @param OutRings as the counter-clockwise outer rings of the union
+ */
+bool FSkycatchPolygonUnion::Union(const TArray<TArray<FVector2D>>& Outlines, double Tolerance, TArray<TArray<FVector2D>>& OutRings)
+{
+	OutRings.Reset();
+
+	//The union is computed with the longitudes scaled to the length of a degree of latitude at the group
+	FBox2D OutlinesBounds(ForceInit);
+	for (const TArray<FVector2D>& Outline : Outlines)
+	{
+		OutlinesBounds += GetBounds(Outline);
+	}
+	const double LongitudeScale = OutlinesBounds.bIsValid ? GetLongitudeScale(OutlinesBounds.GetCenter().Y) : 1.0;
+
+	//Counter-clockwise copies of the outlines, with the vertices of different outlines welded together
+	TArray<TArray<FVector2D>> Rings;
+	FSkycatchVertexWeld Welded(Tolerance);
+	for (const TArray<FVector2D>& Outline : Outlines)
+	{
+		if (Outline.Num() < 3)
+		{
+			continue;
+		}
+
+		TArray<FVector2D>& Ring = Rings.AddDefaulted_GetRef();
+		for (const FVector2D& Point : Outline)
+		{
+			const FVector2D Vertex = Welded.Weld(FVector2D(Point.X * LongitudeScale, Point.Y));
+			if (Ring.Num() == 0 || Ring.Last() != Vertex)
+			{
+				Ring.Add(Vertex);
+			}
+		}
+		while (Ring.Num() > 1 && Ring.Last() == Ring[0])
+		{
+			Ring.Pop();
+		}
+		if (Ring.Num() < 3)
+		{
+			Rings.Pop();
+			continue;
+		}
+		if (SignedArea(Ring) < 0.0)
+		{
+			Algo::Reverse(Ring);
+		}
+	}
+
+	auto ToLongitudeLatitude = [LongitudeScale](TArray<FVector2D>& Ring)
+	{
+		for (FVector2D& Point : Ring)
+		{
+			Point.X /= LongitudeScale;
+		}
+	};
+
+	if (Rings.Num() == 0)
+	{
+		return true;
+	}
+	if (Rings.Num() == 1)
+	{
+		ToLongitudeLatitude(Rings[0]);
+		OutRings.Add(MoveTemp(Rings[0]));
+		return true;
+	}
+
+	//Collects the points where every edge has to be split: crossings and vertices of other outlines lying on it.
+	//A crossing is computed once and the same welded point is given to both edges, and a vertex lying on an edge
+	//splits it at the vertex itself, so the segments of both outlines meet at identical points
+	TArray<TArray<TArray<FSkycatchUnionSplit>>> Splits;
+	Splits.SetNum(Rings.Num());
+	TArray<FBox2D> Bounds;
+	for (int32 r = 0; r < Rings.Num(); r++)
+	{
+		Splits[r].SetNum(Rings[r].Num());
+		Bounds.Add(GetBounds(Rings[r]).ExpandBy(Tolerance));
+	}
+
+	for (int32 ra = 0; ra < Rings.Num(); ra++)
+	{
+		for (int32 rb = ra + 1; rb < Rings.Num(); rb++)
+		{
+			if (!Bounds[ra].Intersect(Bounds[rb]))
+			{
+				continue;
+			}
+
+			const TArray<FVector2D>& A = Rings[ra];
+			const TArray<FVector2D>& B = Rings[rb];
+			for (int32 i = 0; i < A.Num(); i++)
+			{
+				const FVector2D& A0 = A[i];
+				const FVector2D& A1 = A[(i + 1) % A.Num()];
+				for (int32 j = 0; j < B.Num(); j++)
+				{
+					const FVector2D& B0 = B[j];
+					const FVector2D& B1 = B[(j + 1) % B.Num()];
+
+					double TA, TB;
+					if (SegmentIntersection(A0, A1, B0, B1, TA, TB))
+					{
+						const FVector2D Crossing = Welded.Weld(A0 + (A1 - A0) * TA);
+						Splits[ra][i].Add({ TA, Crossing });
+						Splits[rb][j].Add({ TB, Crossing });
+					}
+
+					//Vertices of one outline lying on an edge of the other one
+					if (B0 != A0 && B0 != A1 && PointSegmentDistance(B0, A0, A1) <= Tolerance)
+					{
+						Splits[ra][i].Add({ FMath::Clamp(FVector2D::DotProduct(B0 - A0, A1 - A0) / (A1 - A0).SizeSquared(), 0.0, 1.0), B0 });
+					}
+					if (A0 != B0 && A0 != B1 && PointSegmentDistance(A0, B0, B1) <= Tolerance)
+					{
+						Splits[rb][j].Add({ FMath::Clamp(FVector2D::DotProduct(A0 - B0, B1 - B0) / (B1 - B0).SizeSquared(), 0.0, 1.0), A0 });
+					}
+				}
+			}
+		}
+	}
+
+	//Splits the edges and keeps the segments whose outer side is not covered by another outline
+	const double SideOffset = FMath::Max(Tolerance * 0.5, 1e-10);
+	TArray<FSkycatchUnionSegment> Segments;
+	TMap<FVector2D, TArray<int32>> SegmentsByStart;
+	for (int32 r = 0; r < Rings.Num(); r++)
+	{
+		const TArray<FVector2D>& Ring = Rings[r];
+		for (int32 i = 0; i < Ring.Num(); i++)
+		{
+			TArray<FSkycatchUnionSplit>& EdgeSplits = Splits[r][i];
+			EdgeSplits.Add({ 0.0, Ring[i] });
+			EdgeSplits.Add({ 1.0, Ring[(i + 1) % Ring.Num()] });
+			EdgeSplits.Sort([](const FSkycatchUnionSplit& A, const FSkycatchUnionSplit& B) { return A.T < B.T; });
+
+			for (int32 s = 0; s + 1 < EdgeSplits.Num(); s++)
+			{
+				const FVector2D& SegmentStart = EdgeSplits[s].Point;
+				const FVector2D& SegmentEnd = EdgeSplits[s + 1].Point;
+				const FVector2D Direction = SegmentEnd - SegmentStart;
+				if (SegmentStart == SegmentEnd)
+				{
+					continue;
+				}
+
+				//The outer side of a counter-clockwise ring is on the right of its edges
+				const FVector2D Outward = FVector2D(Direction.Y, -Direction.X).GetSafeNormal();
+				const FVector2D OuterSample = (SegmentStart + SegmentEnd) * 0.5 + Outward * SideOffset;
+
+				bool bCovered = false;
+				for (int32 Other = 0; Other < Rings.Num() && !bCovered; Other++)
+				{
+					bCovered = Other != r && Bounds[Other].IsInside(OuterSample) && IsPointInside(Rings[Other], OuterSample);
+				}
+				if (bCovered)
+				{
+					continue;
+				}
+
+				//Shared edges running in the same direction are kept once
+				TArray<int32>& StartSegments = SegmentsByStart.FindOrAdd(SegmentStart);
+				if (StartSegments.ContainsByPredicate([&Segments, &SegmentEnd](int32 Index) { return Segments[Index].End == SegmentEnd; }))
+				{
+					continue;
+				}
+				StartSegments.Add(Segments.Num());
+				Segments.Add({ SegmentStart, SegmentEnd });
+			}
+		}
+	}
+
+	//Chains the kept segments into rings, keeping the face on the left at vertices shared by several rings
+	for (int32 First = 0; First < Segments.Num(); First++)
+	{
+		if (Segments[First].bUsed)
+		{
+			continue;
+		}
+
+		TArray<FVector2D> Ring;
+		int32 Current = First;
+		FVector2D ChainEnd = Segments[First].Start;
+		while (Current != INDEX_NONE && !Segments[Current].bUsed)
+		{
+			FSkycatchUnionSegment& Segment = Segments[Current];
+			Segment.bUsed = true;
+			Ring.Add(Segment.Start);
+			ChainEnd = Segment.End;
+
+			const FVector2D Reverse = (Segment.Start - Segment.End).GetSafeNormal();
+			int32 Next = INDEX_NONE;
+			double BestAngle = TNumericLimits<double>::Max();
+			if (const TArray<int32>* Candidates = SegmentsByStart.Find(Segment.End))
+			{
+				for (const int32 Candidate : *Candidates)
+				{
+					if (Segments[Candidate].bUsed && Candidate != First)
+					{
+						continue;
+					}
+
+					//Clockwise angle from the reversed incoming edge to the outgoing edge
+					const FVector2D Outgoing = (Segments[Candidate].End - Segments[Candidate].Start).GetSafeNormal();
+					double Angle = FMath::Atan2(-Cross2D(Reverse, Outgoing), FVector2D::DotProduct(Reverse, Outgoing));
+					if (Angle <= 0.0)
+					{
+						Angle += 2.0 * PI;
+					}
+					if (Angle < BestAngle)
+					{
+						BestAngle = Angle;
+						Next = Candidate;
+					}
+				}
+			}
+			Current = Next;
+		}
+
+		//A chain that doesn't come back to its start is not a boundary, the union can't be traced
+		if (ChainEnd != Segments[First].Start)
+		{
+			OutRings.Reset();
+			return false;
+		}
+		if (Ring.Num() < 3)
+		{
+			continue;
+		}
+
+		//Clockwise rings are holes of the union
+		if (SignedArea(Ring) < 0.0)
+		{
+			OutRings.Reset();
+			return false;
+		}
+		ToLongitudeLatitude(Ring);
+		OutRings.Add(MoveTemp(Ring));
+	}
+	return true;
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * @brief Merges crossing squares, squares sharing an edge, a square touching the edge of another one with its
+ * vertices, disjoint squares and squares enclosing a hole, and checks the tolerance is scaled on the longitude.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSkycatchPolygonUnionTest, "Skycatch.PolygonUnion.Squares",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FSkycatchPolygonUnionTest::RunTest(const FString& Parameters)
+{
+	//Axis aligned square of about 100 m around the given south west corner, in units of 1e-3 degrees
+	const FVector2D Origin(-99.1332, 19.4326);
+	auto Box = [&Origin](double West, double South, double East, double North)
+	{
+		return TArray<FVector2D>{ Origin + FVector2D(West, South) * 1e-3, Origin + FVector2D(East, South) * 1e-3,
+			Origin + FVector2D(East, North) * 1e-3, Origin + FVector2D(West, North) * 1e-3 };
+	};
+	const double Tolerance = 1e-7;
+	const double AreaUnit = 1e-6;
+
+	auto CheckUnion = [&](const TCHAR* What, const TArray<TArray<FVector2D>>& Outlines, int32 ExpectedRings, double ExpectedArea)
+	{
+		TArray<TArray<FVector2D>> Rings;
+		if (!TestTrue(*FString::Printf(TEXT("%s merge"), What), FSkycatchPolygonUnion::Union(Outlines, Tolerance, Rings)) ||
+			!TestEqual(*FString::Printf(TEXT("%s rings"), What), Rings.Num(), ExpectedRings))
+		{
+			return;
+		}
+		double Area = 0.0;
+		for (const TArray<FVector2D>& Ring : Rings)
+		{
+			TestTrue(*FString::Printf(TEXT("%s ring is counter-clockwise"), What), FSkycatchPolygonUnion::SignedArea(Ring) > 0.0);
+			Area += FSkycatchPolygonUnion::SignedArea(Ring);
+		}
+		TestEqual(*FString::Printf(TEXT("%s area"), What), Area / AreaUnit, ExpectedArea, 1e-5);
+	};
+
+	CheckUnion(TEXT("Crossing squares"), { Box(0, 0, 2, 2), Box(1, 1, 3, 3) }, 1, 7.0);
+	CheckUnion(TEXT("Squares sharing an edge"), { Box(0, 0, 1, 1), Box(1, 0, 2, 1) }, 1, 2.0);
+	CheckUnion(TEXT("Square touching an edge with its vertices"), { Box(0, 0, 2, 2), Box(2, 0.5, 3, 1.5) }, 1, 5.0);
+	CheckUnion(TEXT("Disjoint squares"), { Box(0, 0, 1, 1), Box(2, 0, 3, 1) }, 2, 2.0);
+
+	//The crossings of two squares are shared by both, so the ring has the 8 corners of the union
+	TArray<TArray<FVector2D>> Rings;
+	FSkycatchPolygonUnion::Union({ Box(0, 0, 2, 2), Box(1, 1, 3, 3) }, Tolerance, Rings);
+	TestEqual(TEXT("Crossing squares vertices"), Rings.Num() == 1 ? Rings[0].Num() : 0, 8);
+
+	//Four rectangles around a square hole can't be merged into outer rings
+	TestFalse(TEXT("Frame around a hole is not merged"), FSkycatchPolygonUnion::Union(
+		{ Box(0, 0, 3, 1), Box(0, 2, 3, 3), Box(0, 1, 1, 2), Box(2, 1, 3, 2) }, Tolerance, Rings));
+
+	//At 60 degrees a degree of longitude is half a degree of latitude, so a longitude gap of 1.5 tolerances touches
+	const TArray<FVector2D> North = { FVector2D(10.0, 60.0), FVector2D(10.001, 60.0), FVector2D(10.001, 60.001), FVector2D(10.0, 60.001) };
+	TArray<FVector2D> East = North;
+	for (FVector2D& Point : East)
+	{
+		Point.X += 0.001 + 1.5e-5;
+	}
+	TestTrue(TEXT("Longitude gap under the tolerance at 60 degrees touches"), FSkycatchPolygonUnion::Overlaps(North, East, 1e-5));
+	TestFalse(TEXT("Longitude gap over the tolerance at 60 degrees doesn't touch"), FSkycatchPolygonUnion::Overlaps(North, East, 0.5e-5));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,402 @@
+/**
+ * Including the Header libraries and files required
+ **/
+#include "SkycatchPrewarm.h"
+#include "SkycatchSubsystem.h"
+#include "SkycatchSettings.h"
+#include "Cesium3DTileset.h"
+#include "CesiumCameraManager.h"
+#include "LevelSequenceActor.h"
+#include "LevelSequencePlayer.h"
+#include "Camera/CameraActor.h"
+#include "Camera/CameraComponent.h"
+#include "Components/SplineComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+
+/**
+ * @brief Frames a batch of poses is kept at least, the tilesets select the tiles of new cameras on the next frame.
+ */
+static constexpr int32 MinBatchFrames = 2;
+
+/**
+ * @brief Samples the poses of a camera while a level sequence plays from its start to its end. The playback
+ * position of the sequence is restored afterwards.
+ *
+ * @param SequenceActor as the level sequence to sample
+ * @param Camera as the camera bound to the camera track of the sequence
+ * @param NumSamples as the number of poses to sample
+ * @param OutPoses as the sampled poses
+ * @param OutFieldOfView as the horizontal field of view of the camera, in degrees
+ */
+void FSkycatchTilePrewarm::SampleSequence(ALevelSequenceActor* SequenceActor, ACameraActor* Camera, int32 NumSamples, TArray<FTransform>& OutPoses, float& OutFieldOfView)
+{
+	OutPoses.Reset();
+	ULevelSequencePlayer* Player = SequenceActor ? SequenceActor->GetSequencePlayer() : nullptr;
+	UCameraComponent* CameraComponent = Camera ? Camera->GetCameraComponent() : nullptr;
+	if (!Player || !CameraComponent || NumSamples <= 0)
+	{
+		return;
+	}
+
+	const FFrameTime StartTime = Player->GetStartTime().Time;
+	const FFrameTime Duration = Player->GetDuration().Time;
+	const FFrameTime CurrentTime = Player->GetCurrentTime().Time;
+
+	OutPoses.Reserve(NumSamples);
+	for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+	{
+		const float Alpha = NumSamples > 1 ? (float)Sample / (NumSamples - 1) : 0.0f;
+		Player->SetPlaybackPosition(FMovieSceneSequencePlaybackParams(StartTime + Duration * Alpha, EUpdatePositionMethod::Scrub));
+		OutPoses.Add(CameraComponent->GetComponentTransform());
+	}
+	OutFieldOfView = CameraComponent->FieldOfView;
+
+	Player->SetPlaybackPosition(FMovieSceneSequencePlaybackParams(CurrentTime, EUpdatePositionMethod::Scrub));
+}
+
+/**
+ * @brief Samples poses at regular distances along a spline, looking along it.
+ *
+ * @param Spline as the spline to sample
+ * @param NumSamples as the number of poses to sample
+ * @param OutPoses as the sampled poses
+ */
+void FSkycatchTilePrewarm::SampleSpline(const USplineComponent* Spline, int32 NumSamples, TArray<FTransform>& OutPoses)
+{
+	OutPoses.Reset();
+	if (!Spline || NumSamples <= 0)
+	{
+		return;
+	}
+
+	const float Length = Spline->GetSplineLength();
+	OutPoses.Reserve(NumSamples);
+	for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+	{
+		const float Distance = NumSamples > 1 ? Length * Sample / (NumSamples - 1) : 0.0f;
+		OutPoses.Add(FTransform(
+			Spline->GetRotationAtDistanceAlongSpline(Distance, ESplineCoordinateSpace::World),
+			Spline->GetLocationAtDistanceAlongSpline(Distance, ESplineCoordinateSpace::World)));
+	}
+}
+
+/**
+ * @brief Starts prewarming the tiles seen from the given poses, cancelling any prewarm running.
+ *
+ * @param World as the world of the tilesets
+ * @param InPoses as the poses of the camera
+ * @param InTilesets as the Skycatch tilesets of the sites along the path, waited for before the next poses
+ * @param InFieldOfView as the horizontal field of view of the camera, in degrees
+ * @param InResolution as the resolution the path is rendered at
+ * @param bInWatchPlayback whether the path is played by a level sequence, whose playback is watched
+ * @param InOnCompleted as the callback executed when the prewarm completes or is cancelled
+ */
+void FSkycatchTilePrewarm::Start(UWorld* World, TArray<FTransform> InPoses, const TArray<ACesium3DTileset*>& InTilesets, float InFieldOfView, FVector2D InResolution, bool bInWatchPlayback, TFunction<void(const FSkycatchPrewarmStats&)> InOnCompleted)
+{
+	Cancel(World);
+
+	Poses = MoveTemp(InPoses);
+	FieldOfView = InFieldOfView;
+	Resolution = InResolution;
+	bWatchPlayback = bInWatchPlayback;
+	OnCompleted = MoveTemp(InOnCompleted);
+	Tilesets.Reset();
+	for (ACesium3DTileset* Tileset : InTilesets)
+	{
+		Tilesets.Add(Tileset);
+	}
+
+	Stats = FSkycatchPrewarmStats();
+	Stats.Samples = Poses.Num();
+	Stats.Tilesets = Tilesets.Num();
+
+	NextPose = 0;
+	BatchFrames = 0;
+	StartTime = FPlatformTime::Seconds();
+	BatchStartTime = StartTime;
+	LastTickTime = StartTime;
+	bRunning = true;
+	bWatchingPlayback = false;
+	Pin();
+
+	UE_LOG(LogSkycatch, Log, TEXT("Prewarming the tiles of %d poses over %d Skycatch tilesets"), Stats.Samples, Stats.Tilesets);
+}
+
+/**
+ * @brief Adds the next poses once the tilesets finished loading the current ones, and watches the playback that
+ * follows the prewarm.
+ *
+ * @param World as the world of the tilesets
+ */
+void FSkycatchTilePrewarm::Tick(UWorld* World)
+{
+	const double Now = FPlatformTime::Seconds();
+	const float DeltaSeconds = (float)(Now - LastTickTime);
+	LastTickTime = Now;
+
+	if (bRunning)
+	{
+		const bool bLoaded = AreTilesetsLoaded();
+		if (!bLoaded)
+		{
+			Stats.LoadingSeconds += DeltaSeconds;
+		}
+
+		//Keep the batch until its tiles loaded or it timed out
+		if (CameraIds.Num() > 0)
+		{
+			++BatchFrames;
+			const bool bTimedOut = Now - BatchStartTime >= GetDefault<USkycatchSettings>()->PrewarmBatchTimeoutSeconds;
+			if (BatchFrames < MinBatchFrames || (!bLoaded && !bTimedOut))
+			{
+				return;
+			}
+			if (!bLoaded)
+			{
+				++Stats.TimedOutBatches;
+				UE_LOG(LogSkycatch, Warning, TEXT("Prewarm of poses %d to %d timed out before their tiles loaded"), NextPose - CameraIds.Num(), NextPose - 1);
+			}
+			RemoveCameras(World);
+		}
+
+		if (NextPose >= Poses.Num())
+		{
+			bRunning = false;
+			Stats.bCompleted = true;
+			Stats.PrewarmSeconds = (float)(Now - StartTime);
+			UE_LOG(LogSkycatch, Log, TEXT("Prewarmed %d poses in %.2f s, %.2f s of them loading tiles, %d batches timed out"),
+				Stats.Samples, Stats.PrewarmSeconds, Stats.LoadingSeconds, Stats.TimedOutBatches);
+
+			CompletedTime = Now;
+			bWatchingPlayback = bWatchPlayback;
+			bPlaybackStarted = false;
+			if (OnCompleted)
+			{
+				TFunction<void(const FSkycatchPrewarmStats&)> Callback = MoveTemp(OnCompleted);
+				Callback(Stats);
+			}
+			return;
+		}
+
+		ACesiumCameraManager* CameraManager = ACesiumCameraManager::GetDefaultCameraManager(World);
+		if (!CameraManager)
+		{
+			Cancel(World);
+			return;
+		}
+
+		const int32 BatchSize = FMath::Min(GetDefault<USkycatchSettings>()->PrewarmParallelCameras, Poses.Num() - NextPose);
+		for (int32 Index = NextPose; Index < NextPose + BatchSize; ++Index)
+		{
+			const FTransform& Pose = Poses[Index];
+			CameraIds.Add(CameraManager->AddCamera(FCesiumCamera(Resolution, Pose.GetLocation(), Pose.Rotator(), FieldOfView)));
+		}
+		NextPose += BatchSize;
+		BatchFrames = 0;
+		BatchStartTime = Now;
+		return;
+	}
+
+	//Without a playback started in time, the tilesets go back to the cache size of the memory governor
+	if (bPinned && !bPlaybackStarted && Now - CompletedTime >= GetDefault<USkycatchSettings>()->PrewarmReleaseSeconds)
+	{
+		Unpin();
+		UE_LOG(LogSkycatch, Log, TEXT("Prewarm cache released, no playback started within %.0f s"), GetDefault<USkycatchSettings>()->PrewarmReleaseSeconds);
+	}
+
+	if (bWatchingPlayback && World)
+	{
+		bool bPlaying = false;
+		for (TActorIterator<ALevelSequenceActor> It(World); It && !bPlaying; ++It)
+		{
+			const ULevelSequencePlayer* Player = It->GetSequencePlayer();
+			bPlaying = Player && Player->IsPlaying();
+		}
+
+		if (bPlaying)
+		{
+			bPlaybackStarted = true;
+			if (!AreTilesetsLoaded())
+			{
+				Stats.PlaybackLoadingSeconds += DeltaSeconds;
+			}
+		}
+		else if (bPlaybackStarted)
+		{
+			//The playback after the prewarm ended, the tilesets go back to the cache size of the memory governor
+			bWatchingPlayback = false;
+			Unpin();
+			UE_LOG(LogSkycatch, Log, TEXT("Playback after the prewarm loaded tiles for %.2f s, the prewarm took %.2f s, %.2f s of them loading tiles"),
+				Stats.PlaybackLoadingSeconds, Stats.PrewarmSeconds, Stats.LoadingSeconds);
+		}
+	}
+}
+
+/**
+ * @brief Stops the prewarm, removes its cameras and releases the cache size kept for its tilesets.
+ *
+ * @param World as the world of the tilesets
+ */
+void FSkycatchTilePrewarm::Cancel(UWorld* World)
+{
+	RemoveCameras(World);
+	Unpin();
+	bWatchingPlayback = false;
+	if (!bRunning)
+	{
+		return;
+	}
+
+	bRunning = false;
+	Stats.PrewarmSeconds = (float)(FPlatformTime::Seconds() - StartTime);
+	UE_LOG(LogSkycatch, Log, TEXT("Prewarm cancelled after %d of %d poses"), NextPose, Stats.Samples);
+	if (OnCompleted)
+	{
+		TFunction<void(const FSkycatchPrewarmStats&)> Callback = MoveTemp(OnCompleted);
+		Callback(Stats);
+	}
+}
+
+/**
+ * @brief Returns whether every watched tileset finished loading.
+ */
+bool FSkycatchTilePrewarm::AreTilesetsLoaded() const
+{
+	for (const TWeakObjectPtr<ACesium3DTileset>& Tileset : Tilesets)
+	{
+		if (Tileset.IsValid() && !Tileset->IsHidden() && Tileset->GetLoadProgress() < 100.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Returns whether a tileset keeps the cache size of the prewarm.
+ *
+ * @param Tileset as the tileset
+ */
+bool FSkycatchTilePrewarm::IsPinned(const ACesium3DTileset* Tileset) const
+{
+	return bPinned && Tilesets.Contains(Tileset);
+}
+
+/**
+ * @brief Raises the cache size of the tilesets along the path to the one of the prewarm.
+ */
+void FSkycatchTilePrewarm::Pin()
+{
+	const int64 PrewarmBytes = GetDefault<USkycatchSettings>()->PrewarmTilesetBytes;
+	UnpinnedCachedBytes.Reset(Tilesets.Num());
+	for (const TWeakObjectPtr<ACesium3DTileset>& Tileset : Tilesets)
+	{
+		UnpinnedCachedBytes.Add(Tileset.IsValid() ? Tileset->MaximumCachedBytes : 0);
+		if (Tileset.IsValid())
+		{
+			Tileset->MaximumCachedBytes = FMath::Max<int64>(Tileset->MaximumCachedBytes, PrewarmBytes);
+		}
+	}
+	bPinned = true;
+}
+
+/**
+ * @brief Restores the cache size the tilesets had before the prewarm.
+ */
+void FSkycatchTilePrewarm::Unpin()
+{
+	if (!bPinned)
+	{
+		return;
+	}
+
+	for (int32 Index = 0; Index < Tilesets.Num(); Index++)
+	{
+		if (Tilesets[Index].IsValid())
+		{
+			Tilesets[Index]->MaximumCachedBytes = UnpinnedCachedBytes[Index];
+		}
+	}
+	UnpinnedCachedBytes.Reset();
+	bPinned = false;
+}
+
+/**
+ * @brief Removes the cameras of the current batch from the Cesium camera manager.
+ */
+void FSkycatchTilePrewarm::RemoveCameras(UWorld* World)
+{
+	ACesiumCameraManager* CameraManager = World && CameraIds.Num() > 0 ? ACesiumCameraManager::GetDefaultCameraManager(World) : nullptr;
+	if (CameraManager)
+	{
+		for (int32 CameraId : CameraIds)
+		{
+			CameraManager->RemoveCamera(CameraId);
+		}
+	}
+	CameraIds.Reset();
+}
+
+/*
+* Prewarm tiles along path async wrapper
+*/
+UPrewarmSkycatchTilesAlongPath::UPrewarmSkycatchTilesAlongPath(const FObjectInitializer& ObjectInitializer) :
+	Super(ObjectInitializer),
+	WorldContextObject(nullptr),
+	FieldOfView(90.0f),
+	Resolution(1920.0, 1080.0),
+	bWatchPlayback(false)
+{
+
+}
+
+UPrewarmSkycatchTilesAlongPath* UPrewarmSkycatchTilesAlongPath::PrewarmSkycatchTilesAlongSequence(UObject* WorldContextObject, ALevelSequenceActor* SequenceActor, ACameraActor* Camera, int32 Samples, FVector2D Resolution)
+{
+	UPrewarmSkycatchTilesAlongPath* ExecNode = NewObject<UPrewarmSkycatchTilesAlongPath>();
+	ExecNode->WorldContextObject = WorldContextObject;
+	ExecNode->Resolution = Resolution;
+	ExecNode->bWatchPlayback = true;
+	FSkycatchTilePrewarm::SampleSequence(SequenceActor, Camera, Samples, ExecNode->Poses, ExecNode->FieldOfView);
+	ExecNode->RegisterWithGameInstance(WorldContextObject);
+	return ExecNode;
+}
+
+UPrewarmSkycatchTilesAlongPath* UPrewarmSkycatchTilesAlongPath::PrewarmSkycatchTilesAlongSpline(UObject* WorldContextObject, USplineComponent* Spline, float FieldOfView, int32 Samples, FVector2D Resolution)
+{
+	UPrewarmSkycatchTilesAlongPath* ExecNode = NewObject<UPrewarmSkycatchTilesAlongPath>();
+	ExecNode->WorldContextObject = WorldContextObject;
+	ExecNode->FieldOfView = FieldOfView;
+	ExecNode->Resolution = Resolution;
+	FSkycatchTilePrewarm::SampleSpline(Spline, Samples, ExecNode->Poses);
+	ExecNode->RegisterWithGameInstance(WorldContextObject);
+	return ExecNode;
+}
+
+void UPrewarmSkycatchTilesAlongPath::Activate()
+{
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	USkycatchSubsystem* Subsystem = World ? World->GetSubsystem<USkycatchSubsystem>() : nullptr;
+	if (!Subsystem || Poses.Num() == 0)
+	{
+		Execute(FSkycatchPrewarmStats());
+		return;
+	}
+
+	// Start the prewarm and execute this class execute function when it completes
+	TWeakObjectPtr<UPrewarmSkycatchTilesAlongPath> WeakThis(this);
+	Subsystem->StartPrewarm(MoveTemp(Poses), FieldOfView, Resolution, bWatchPlayback, [WeakThis](const FSkycatchPrewarmStats& Stats)
+	{
+		if (WeakThis.IsValid())
+		{
+			WeakThis->Execute(Stats);
+		}
+	});
+}
+
+void UPrewarmSkycatchTilesAlongPath::Execute(const FSkycatchPrewarmStats& Stats)
+{
+	OnPrewarmCompleted.Broadcast(Stats);
+
+	SetReadyToDestroy();
+}
@@ -0,0 +1,611 @@
+/**
+ * Including the Header libraries and files required
+ **/
+#include "SkycatchSiteCache.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Async/Async.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+#include "HAL/IConsoleManager.h"
+#include "HttpServerModule.h"
+#include "IHttpRouter.h"
+#include "HttpServerResponse.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "SkycatchPolygonUnion.h"
+#include "SkycatchOutline.h"
+#include "SkycatchEndpoints.h"
+#include "SkycatchSettings.h"
+
+/**
+ * @brief Returns the process wide site cache.
+ */
+FSkycatchSiteCache& FSkycatchSiteCache::Get()
+{
+	static FSkycatchSiteCache Cache;
+	return Cache;
+}
+
+/**
+ * @brief Resolves a site lookup from the cache, or sends it to the Skycatch services when it is not cached or
+ * expired. The callback is executed immediately on a cache hit.
+ *
+ * @param Params as the query params of the lookup
+ * @param OnCompleted as the callback executed with the response
+ */
+void FSkycatchSiteCache::Lookup(const FString& Params, FOnSiteLookupCompleted OnCompleted)
+{
+	if (IsCached(Params))
+	{
+		UE_LOG(LogSkycatch, Display, TEXT("Site lookup served from cache: %s"), *Params);
+		OnCompleted.ExecuteIfBound(true, 200, Sites[Params].Response);
+		return;
+	}
+
+	//A lookup of the same site already being sent answers this one too
+	if (TArray<FOnSiteLookupCompleted>* Waiting = InFlight.Find(Params))
+	{
+		Waiting->Add(MoveTemp(OnCompleted));
+		return;
+	}
+
+	InFlight.Add(Params).Add(MoveTemp(OnCompleted));
+	SendRequest(Params, TArray<FString>());
+}
+
+/**
+ * @brief Fetches a site lookup into the cache without doing anything with the response.
+ *
+ * @param Params as the query params of the lookup
+ */
+void FSkycatchSiteCache::Prefetch(const FString& Params)
+{
+	Lookup(Params, FOnSiteLookupCompleted());
+}
+
+/**
+ * @brief Returns whether a lookup has a cached response that has not expired.
+ *
+ * @param Params as the query params of the lookup
+ */
+bool FSkycatchSiteCache::IsCached(const FString& Params) const
+{
+	const FSkycatchCachedSite* Site = Sites.Find(Params);
+	return Site && FPlatformTime::Seconds() - Site->FetchTime < GetDefault<USkycatchSettings>()->SiteCacheLifetimeSeconds;
+}
+
+/**
+ * @brief Returns whether a lookup is being sent to the Skycatch services.
+ *
+ * @param Params as the query params of the lookup
+ */
+bool FSkycatchSiteCache::IsInFlight(const FString& Params) const
+{
+	return InFlight.Contains(Params);
+}
+
+/**
+ * @brief Returns all the cached sites, including the expired ones.
+ */
+TArray<FSkycatchCachedSite> FSkycatchSiteCache::GetSites() const
+{
+	TArray<FSkycatchCachedSite> CachedSites;
+	Sites.GenerateValueArray(CachedSites);
+	return CachedSites;
+}
+
+/**
+ * @brief Removes all the cached sites.
+ */
+void FSkycatchSiteCache::Empty()
+{
+	Sites.Empty();
+}
+
+/**
+ * @brief Sends a lookup to the fastest healthy endpoint, failing over to the next endpoint on connection or
+ * server errors.
+ *
+ * @param Params as the query params of the lookup
+ * @param TriedEndpoints as the endpoints that already failed for this lookup
+ */
+void FSkycatchSiteCache::SendRequest(const FString& Params, TArray<FString> TriedEndpoints)
+{
+	FHttpModule& httpModule = FHttpModule::Get();
+
+	// Create an http request
+	// The request will execute asynchronously, and call us back on the Lambda below
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> pRequest = httpModule.CreateRequest();
+
+	// This is where we set the HTTP method (GET, POST, etc)
+	pRequest->SetVerb(TEXT("GET"));
+
+	// We'll need to tell the server what type of content to expect in the GET data
+	pRequest->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
+
+	// Authorization header
+	pRequest->SetHeader(TEXT("SKYVERSE_KEY"), GetDefault<USkycatchSettings>()->SKYVERSE_KEY);
+
+	// Picks the fastest healthy endpoint that was not tried yet for this lookup
+	const FString ENDPOINT = FSkycatchEndpointPool::Get().SelectEndpoint(TriedEndpoints);
+	const FString URL = ENDPOINT + Params;
+	TriedEndpoints.Add(ENDPOINT);
+
+	UE_LOG(LogSkycatch, Warning, TEXT("Full URL: %s"), *URL);
+
+	// Set the http URL
+	pRequest->SetURL(URL);
+
+	// Set the callback, which will execute when the HTTP call is complete
+	pRequest->OnProcessRequestComplete().BindLambda(
+		[this, Params, ENDPOINT, TriedEndpoints](
+			FHttpRequestPtr pRequest,
+			FHttpResponsePtr pResponse,
+			bool connectedSuccessfully) {
+
+		// Connection and server errors mark the endpoint unhealthy and retry the lookup on the next endpoint
+		FSkycatchEndpointPool& EndpointPool = FSkycatchEndpointPool::Get();
+		if (!connectedSuccessfully || !pResponse.IsValid() || pResponse->GetResponseCode() >= 500)
+		{
+			EndpointPool.ReportFailure(ENDPOINT);
+			if (!EndpointPool.SelectEndpoint(TriedEndpoints).IsEmpty())
+			{
+				UE_LOG(LogSkycatch, Warning, TEXT("Request to %s failed, failing over to the next endpoint"), *ENDPOINT);
+				SendRequest(Params, TriedEndpoints);
+				return;
+			}
+		}
+		else
+		{
+			EndpointPool.ReportSuccess(ENDPOINT, pRequest->GetElapsedTime());
+		}
+
+		const bool bConnected = connectedSuccessfully && pResponse.IsValid();
+		CompleteLookup(Params, bConnected, bConnected ? pResponse->GetResponseCode() : 0, bConnected ? pResponse->GetContentAsString() : FString());
+	});
+
+	// Finally, submit the request for processing
+	pRequest->ProcessRequest();
+}
+
+/**
+ * @brief Stores a successful response and executes all the callbacks waiting for the lookup.
+ */
+void FSkycatchSiteCache::CompleteLookup(const FString& Params, bool bConnected, int32 ResponseCode, const FString& Content)
+{
+	FString ShapedContent = Content;
+	if (bConnected && ResponseCode == 200)
+	{
+		FSkycatchCachedSite& Site = Sites.FindOrAdd(Params);
+		Site.Params = Params;
+		FParse::Value(*Params, TEXT("lat="), Site.Latitude);
+		FParse::Value(*Params, TEXT("lng="), Site.Longitude);
+		//The best site comes first, and only what is read is kept in memory
+		ShapedContent = ShapeResponse(Content, Site.Latitude, Site.Longitude);
+		UE_LOG(LogSkycatch, Verbose, TEXT("Site lookup response shaped from %d to %d characters: %s"), Content.Len(), ShapedContent.Len(), *Params);
+		Site.Response = ShapedContent;
+		Site.FetchTime = FPlatformTime::Seconds();
+		EvictOldest();
+	}
+
+	TArray<FOnSiteLookupCompleted> Waiting;
+	InFlight.RemoveAndCopyValue(Params, Waiting);
+	for (FOnSiteLookupCompleted& OnCompleted : Waiting)
+	{
+		OnCompleted.ExecuteIfBound(bConnected, ResponseCode, ShapedContent);
+	}
+}
+
+/**
+ * @brief Evicts the oldest responses above the configured number of entries.
+ */
+void FSkycatchSiteCache::EvictOldest()
+{
+	const int32 MaxEntries = FMath::Max(1, GetDefault<USkycatchSettings>()->SiteCacheMaxEntries);
+	while (Sites.Num() > MaxEntries)
+	{
+		const FString* Oldest = nullptr;
+		double OldestTime = TNumericLimits<double>::Max();
+		for (const TPair<FString, FSkycatchCachedSite>& Entry : Sites)
+		{
+			if (Entry.Value.FetchTime < OldestTime)
+			{
+				OldestTime = Entry.Value.FetchTime;
+				Oldest = &Entry.Key;
+			}
+		}
+		Sites.Remove(FString(*Oldest));
+	}
+}
+
+/**
+ * @brief Returns the path of the file the cached sites are saved to.
+ */
+FString FSkycatchSiteCache::GetSavePath()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Skycatch"), TEXT("SiteCache.json"));
+}
+
+/**
+ * @brief Writes the cached sites to the saved folder of the project, so the next session starts with them.
+ */
+void FSkycatchSiteCache::Save() const
+{
+	//The fetch times are platform times of this session, they are saved as UTC dates
+	const double Now = FPlatformTime::Seconds();
+	const FDateTime UtcNow = FDateTime::UtcNow();
+	TArray<TSharedPtr<FJsonValue>> Entries;
+	for (const TPair<FString, FSkycatchCachedSite>& Entry : Sites)
+	{
+		const TSharedPtr<FJsonObject> Site = MakeShared<FJsonObject>();
+		Site->SetStringField(TEXT("params"), Entry.Value.Params);
+		Site->SetNumberField(TEXT("lat"), Entry.Value.Latitude);
+		Site->SetNumberField(TEXT("lng"), Entry.Value.Longitude);
+		Site->SetStringField(TEXT("response"), Entry.Value.Response);
+		Site->SetStringField(TEXT("fetched"), (UtcNow - FTimespan::FromSeconds(Now - Entry.Value.FetchTime)).ToIso8601());
+		Entries.Add(MakeShared<FJsonValueObject>(Site));
+	}
+
+	FString Content;
+	const TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> JsonWriter =
+		TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Content);
+	FJsonSerializer::Serialize(Entries, JsonWriter);
+	if (FFileHelper::SaveStringToFile(Content, *GetSavePath()))
+	{
+		UE_LOG(LogSkycatch, Display, TEXT("Saved %d cached sites to %s"), Entries.Num(), *GetSavePath());
+	}
+}
+
+/**
+ * @brief Reads the sites saved by a previous session on a worker thread, then adds them to the cache on the game
+ * thread without replacing the responses received meanwhile.
+ *
+ * @param OnLoaded as the callback executed on the game thread with the number of sites added
+ */
+void FSkycatchSiteCache::LoadAsync(TFunction<void(int32)> OnLoaded)
+{
+	Async(EAsyncExecution::ThreadPool, [this, OnLoaded = MoveTemp(OnLoaded)]() mutable
+	{
+		TArray<FSkycatchCachedSite> Loaded;
+		FString Content;
+		TArray<TSharedPtr<FJsonValue>> Entries;
+		if (FFileHelper::LoadFileToString(Content, *GetSavePath()))
+		{
+			const TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(Content);
+			FJsonSerializer::Deserialize(JsonReader, Entries);
+		}
+
+		const double Now = FPlatformTime::Seconds();
+		const FDateTime UtcNow = FDateTime::UtcNow();
+		for (const TSharedPtr<FJsonValue>& Entry : Entries)
+		{
+			const TSharedPtr<FJsonObject> Site = Entry.IsValid() ? Entry->AsObject() : nullptr;
+			FDateTime Fetched;
+			if (!Site.IsValid() || !FDateTime::ParseIso8601(*Site->GetStringField(TEXT("fetched")), Fetched))
+			{
+				continue;
+			}
+			FSkycatchCachedSite& CachedSite = Loaded.AddDefaulted_GetRef();
+			CachedSite.Params = Site->GetStringField(TEXT("params"));
+			CachedSite.Latitude = Site->GetNumberField(TEXT("lat"));
+			CachedSite.Longitude = Site->GetNumberField(TEXT("lng"));
+			CachedSite.Response = Site->GetStringField(TEXT("response"));
+			CachedSite.FetchTime = Now - (UtcNow - Fetched).GetTotalSeconds();
+		}
+
+		AsyncTask(ENamedThreads::GameThread, [this, Loaded = MoveTemp(Loaded), OnLoaded = MoveTemp(OnLoaded)]()
+		{
+			int32 Added = 0;
+			for (const FSkycatchCachedSite& Site : Loaded)
+			{
+				if (!Site.Params.IsEmpty() && !Sites.Contains(Site.Params))
+				{
+					Sites.Add(Site.Params, Site);
+					Added++;
+				}
+			}
+			EvictOldest();
+			UE_LOG(LogSkycatch, Display, TEXT("Loaded %d cached sites from %s"), Added, *GetSavePath());
+			if (OnLoaded)
+			{
+				OnLoaded(Added);
+			}
+		});
+	});
+}
+
+/**
+ * @brief Ranks the tiles of a lookup response, the tiles whose outline contains the point first and then by the
+ * distance from the point to the center of their outline, keeps only the configured number of tiles and only the
+ * properties the plugin reads. Returns the response unchanged when it can't be parsed.
+ *
+ * @param Response as the content of the Skycatch services response
+ * @param Latitude as the latitude of the lookup
+ * @param Longitude as the longitude of the lookup
+ */
+FString FSkycatchSiteCache::ShapeResponse(const FString& Response, double Latitude, double Longitude)
+{
+	TArray<TSharedPtr<FJsonValue>> Tiles;
+	const TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(Response);
+	if (!FJsonSerializer::Deserialize(JsonReader, Tiles))
+	{
+		return Response;
+	}
+
+	const USkycatchSettings* Settings = GetDefault<USkycatchSettings>();
+	TArray<FString> Fields;
+	Settings->SiteLookupFields.ParseIntoArray(Fields, TEXT(","));
+
+	struct FRankedTile
+	{
+		TSharedPtr<FJsonObject> Tile;
+		bool bContainsPoint = false;
+		double Distance = TNumericLimits<double>::Max();
+	};
+	TArray<FRankedTile> RankedTiles;
+	const FVector2D Point(Longitude, Latitude);
+	const double LongitudeScale = FMath::Cos(FMath::DegreesToRadians(Latitude));
+	for (const TSharedPtr<FJsonValue>& Value : Tiles)
+	{
+		const TSharedPtr<FJsonObject> Tile = Value.IsValid() ? Value->AsObject() : nullptr;
+		if (!Tile.IsValid())
+		{
+			continue;
+		}
+
+		FRankedTile& Ranked = RankedTiles.AddDefaulted_GetRef();
+		if (Fields.Num() > 0)
+		{
+			Ranked.Tile = MakeShared<FJsonObject>();
+			for (const FString& Field : Fields)
+			{
+				if (const TSharedPtr<FJsonValue> FieldValue = Tile->TryGetField(Field.TrimStartAndEnd()))
+				{
+					Ranked.Tile->SetField(Field.TrimStartAndEnd(), FieldValue);
+				}
+			}
+		}
+		else
+		{
+			Ranked.Tile = Tile;
+		}
+
+		//Reads every ring of the outline, as a geojson Feature, Polygon or MultiPolygon
+		const TSharedPtr<FJsonObject>* Outline = nullptr;
+		FSkycatchOutline Geometry;
+		if (!Tile->TryGetObjectField(TEXT("outline"), Outline) || !Geometry.Parse(*Outline))
+		{
+			continue;
+		}
+
+		//The point is inside the site when an odd number of rings contain it, so a point in a hole is outside. The
+		//holes are inside the outer rings, so the bounds of every ring are the bounds of the parts
+		FBox2D Bounds(ForceInit);
+		int32 ContainingRings = 0;
+		for (const TArray<FVector2D>& Ring : Geometry.GetRings())
+		{
+			Bounds += FBox2D(Ring);
+			ContainingRings += FSkycatchPolygonUnion::IsPointInside(Ring, Point) ? 1 : 0;
+		}
+		const FVector2D Center = Bounds.GetCenter();
+		Ranked.bContainsPoint = ContainingRings % 2 == 1;
+		Ranked.Distance = FVector2D((Center.X - Point.X) * LongitudeScale, Center.Y - Point.Y).Size();
+	}
+
+	//Ties keep the order of the server
+	RankedTiles.StableSort([](const FRankedTile& A, const FRankedTile& B)
+	{
+		if (A.bContainsPoint != B.bContainsPoint)
+		{
+			return A.bContainsPoint;
+		}
+		return A.Distance < B.Distance;
+	});
+	if (Settings->SiteLookupLimit > 0 && RankedTiles.Num() > Settings->SiteLookupLimit)
+	{
+		RankedTiles.SetNum(Settings->SiteLookupLimit);
+	}
+
+	TArray<TSharedPtr<FJsonValue>> ShapedTiles;
+	for (const FRankedTile& Ranked : RankedTiles)
+	{
+		ShapedTiles.Add(MakeShared<FJsonValueObject>(Ranked.Tile));
+	}
+
+	FString Shaped;
+	const TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> JsonWriter =
+		TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Shaped);
+	FJsonSerializer::Serialize(ShapedTiles, JsonWriter);
+	return Shaped;
+}
+
+/**
+ * @brief Compares site lookups with and without request shaping against a mock endpoint served by the HTTP server
+ * module on the local machine. The mock returns synthetic sites in a random order, with properties the plugin doesn't
+ * read, and honors the fields and limit query params. Like the Skycatch services described by the settings, the mock
+ * only returns the closest sites first when bServerRanksSitesByDistance is set, and the shaped lookups only send the
+ * limit in that case, as the plugin does. Usage: Skycatch.BenchmarkRequestShaping [Sites=500] [Rounds=20] [Port=8089]
+ */
+static FAutoConsoleCommand BenchmarkRequestShapingCommand(
+	TEXT("Skycatch.BenchmarkRequestShaping"),
+	TEXT("Compares the bytes and latency of site lookups with and without request shaping against a mock endpoint. Usage: Skycatch.BenchmarkRequestShaping [Sites=500] [Rounds=20] [Port=8089]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumSites = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 500;
+		const int32 Rounds = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 20;
+		const uint32 Port = Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 8089;
+		const double Latitude = 19.4326;
+		const double Longitude = -99.1332;
+
+		//Square sites of about 1 km on a grid centered on the point, shuffled
+		FRandomStream Random(NumSites);
+		TArray<TSharedPtr<FJsonObject>> MockSites;
+		const int32 GridSide = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumSites)));
+		const int32 CenterSite = (GridSide / 2) * GridSide + GridSide / 2;
+		for (int32 Index = 0; Index < NumSites; Index++)
+		{
+			const double West = Longitude + (Index % GridSide - GridSide / 2) * 0.01 - 0.005;
+			const double South = Latitude + (Index / GridSide - GridSide / 2) * 0.01 - 0.005;
+			TArray<TSharedPtr<FJsonValue>> Ring;
+			for (const FVector2D& Corner : { FVector2D(West, South), FVector2D(West + 0.01, South), FVector2D(West + 0.01, South + 0.01), FVector2D(West, South + 0.01), FVector2D(West, South) })
+			{
+				Ring.Add(MakeShared<FJsonValueArray>(TArray<TSharedPtr<FJsonValue>>{
+					MakeShared<FJsonValueString>(FString::SanitizeFloat(Corner.X)), MakeShared<FJsonValueString>(FString::SanitizeFloat(Corner.Y)) }));
+			}
+			const TSharedPtr<FJsonObject> Geometry = MakeShared<FJsonObject>();
+			Geometry->SetStringField(TEXT("type"), TEXT("Polygon"));
+			Geometry->SetArrayField(TEXT("coordinates"), { MakeShared<FJsonValueArray>(Ring) });
+
+			const TSharedPtr<FJsonObject> Site = MakeShared<FJsonObject>();
+			Site->SetStringField(TEXT("id"), FGuid::NewGuid().ToString());
+			Site->SetStringField(TEXT("name"), FString::Printf(TEXT("Site %d"), Index));
+			Site->SetStringField(TEXT("description"), FString::ChrN(200, TEXT('x')));
+			Site->SetStringField(TEXT("tilesetUrl"), FString::Printf(TEXT("https://tiles.example.com/%d/tileset.json"), Index));
+			Site->SetStringField(TEXT("thumbnailUrl"), FString::Printf(TEXT("https://tiles.example.com/%d/thumbnail.png"), Index));
+			Site->SetStringField(TEXT("captureDate"), TEXT("2024-01-01T00:00:00Z"));
+			Site->SetObjectField(TEXT("outline"), Geometry);
+			Site->SetObjectField(TEXT("footprint"), Geometry);
+			MockSites.Add(Site);
+		}
+		for (int32 Index = MockSites.Num() - 1; Index > 0; Index--)
+		{
+			MockSites.Swap(Index, Random.RandRange(0, Index));
+		}
+
+		const TSharedPtr<IHttpRouter> Router = FHttpServerModule::Get().GetHttpRouter(Port);
+		if (!Router.IsValid())
+		{
+			UE_LOG(LogSkycatch, Warning, TEXT("Request shaping benchmark: could not open port %u"), Port);
+			return;
+		}
+
+		//Like the Skycatch services, the mock keeps the requested properties and the first sites up to the limit, which
+		//are the closest ones only when the services rank them
+		const bool bServerRanks = GetDefault<USkycatchSettings>()->bServerRanksSitesByDistance;
+		const FHttpRouteHandle Route = Router->BindRoute(FHttpPath(TEXT("/sites")), EHttpServerRequestVerbs::VERB_GET,
+			[MockSites, Latitude, Longitude, bServerRanks](const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+		{
+			TArray<TSharedPtr<FJsonObject>> Sites = MockSites;
+			if (const FString* Limit = Request.QueryParams.Find(TEXT("limit")))
+			{
+				auto Distance = [=](const TSharedPtr<FJsonObject>& Site)
+				{
+					const TArray<TSharedPtr<FJsonValue>>& Corner = Site->GetObjectField(TEXT("outline"))->GetArrayField(TEXT("coordinates"))[0]->AsArray()[0]->AsArray();
+					return FMath::Square(FCString::Atod(*Corner[0]->AsString()) + 0.005 - Longitude) +
+						FMath::Square(FCString::Atod(*Corner[1]->AsString()) + 0.005 - Latitude);
+				};
+				if (bServerRanks)
+				{
+					Sites.Sort([&](const TSharedPtr<FJsonObject>& A, const TSharedPtr<FJsonObject>& B) { return Distance(A) < Distance(B); });
+				}
+				Sites.SetNum(FMath::Min(Sites.Num(), FMath::Max(1, FCString::Atoi(**Limit))));
+			}
+
+			TArray<FString> Fields;
+			if (const FString* FieldList = Request.QueryParams.Find(TEXT("fields")))
+			{
+				FGenericPlatformHttp::UrlDecode(*FieldList).ParseIntoArray(Fields, TEXT(","));
+			}
+			TArray<TSharedPtr<FJsonValue>> Values;
+			for (const TSharedPtr<FJsonObject>& Site : Sites)
+			{
+				TSharedPtr<FJsonObject> Projected = Site;
+				if (Fields.Num() > 0)
+				{
+					Projected = MakeShared<FJsonObject>();
+					for (const FString& Field : Fields)
+					{
+						if (const TSharedPtr<FJsonValue> Value = Site->TryGetField(Field))
+						{
+							Projected->SetField(Field, Value);
+						}
+					}
+				}
+				Values.Add(MakeShared<FJsonValueObject>(Projected));
+			}
+
+			FString Body;
+			const TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> JsonWriter =
+				TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Body);
+			FJsonSerializer::Serialize(Values, JsonWriter);
+			OnComplete(FHttpServerResponse::Create(Body, TEXT("application/json")));
+			return true;
+		});
+		FHttpServerModule::Get().StartAllListeners();
+
+		struct FBenchmark
+		{
+			int32 Sent = 0;
+			int32 Received[2] = { 0, 0 };
+			int64 Bytes[2] = { 0, 0 };
+			double Seconds[2] = { 0.0, 0.0 };
+			double ParseSeconds[2] = { 0.0, 0.0 };
+			bool bContained = true;
+		};
+		const TSharedRef<FBenchmark> Benchmark = MakeShared<FBenchmark>();
+		const FString Base = FString::Printf(TEXT("http://localhost:%u/sites?lat=%f&lng=%f"), Port, Latitude, Longitude);
+		const USkycatchSettings* Settings = GetDefault<USkycatchSettings>();
+		FString Shaping = TEXT("&fields=") + FGenericPlatformHttp::UrlEncode(Settings->SiteLookupFields);
+		if (Settings->bServerRanksSitesByDistance && Settings->SiteLookupLimit > 0)
+		{
+			Shaping += FString::Printf(TEXT("&limit=%d"), Settings->SiteLookupLimit);
+		}
+
+		//Sends the lookups one at a time, alternating plain and shaped, so both see the same conditions
+		const TSharedRef<TFunction<void()>> SendNext = MakeShared<TFunction<void()>>();
+		*SendNext = [=]()
+		{
+			if (Benchmark->Sent == Rounds * 2)
+			{
+				Router->UnbindRoute(Route);
+				for (int32 Shaped = 0; Shaped < 2; Shaped++)
+				{
+					const int32 Received = FMath::Max(1, Benchmark->Received[Shaped]);
+					UE_LOG(LogSkycatch, Display, TEXT("Request shaping benchmark, %s: %lld bytes, %.2f ms round trip, %.2f ms parsing and ranking"),
+						Shaped ? TEXT("shaped") : TEXT("plain"), Benchmark->Bytes[Shaped] / Received,
+						Benchmark->Seconds[Shaped] * 1000.0 / Received, Benchmark->ParseSeconds[Shaped] * 1000.0 / Received);
+				}
+				UE_LOG(LogSkycatch, Display, TEXT("  %.1f%% fewer bytes, %.2f ms saved per lookup, first site contains the point: %s"),
+					100.0 * (1.0 - static_cast<double>(Benchmark->Bytes[1]) / FMath::Max<int64>(1, Benchmark->Bytes[0])),
+					(Benchmark->Seconds[0] - Benchmark->Seconds[1]) * 1000.0 / Rounds, Benchmark->bContained ? TEXT("yes") : TEXT("no"));
+
+				//Breaks the reference the function holds to itself
+				*SendNext = nullptr;
+				return;
+			}
+
+			const int32 Shaped = Benchmark->Sent++ % 2;
+			const double StartTime = FPlatformTime::Seconds();
+			TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
+			Request->SetURL(Shaped ? Base + Shaping : Base);
+			Request->SetVerb("GET");
+			Request->OnProcessRequestComplete().BindLambda([=](FHttpRequestPtr, FHttpResponsePtr Response, bool bConnected)
+			{
+				const double EndTime = FPlatformTime::Seconds();
+				if (bConnected && Response.IsValid())
+				{
+					Benchmark->Received[Shaped]++;
+					Benchmark->Bytes[Shaped] += Response->GetContent().Num();
+					Benchmark->Seconds[Shaped] += EndTime - StartTime;
+
+					//Both go through the ranking, as every lookup does
+					const FString Ranked = FSkycatchSiteCache::ShapeResponse(Response->GetContentAsString(), Latitude, Longitude);
+					TArray<TSharedPtr<FJsonValue>> Tiles;
+					const TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(Ranked);
+					FJsonSerializer::Deserialize(JsonReader, Tiles);
+					Benchmark->ParseSeconds[Shaped] += FPlatformTime::Seconds() - EndTime;
+
+					Benchmark->bContained &= Tiles.Num() > 0 && Tiles[0]->AsObject()->GetStringField(TEXT("tilesetUrl")).Contains(
+						FString::Printf(TEXT("/%d/"), CenterSite));
+				}
+				(*SendNext)();
+			});
+			Request->ProcessRequest();
+		};
+		(*SendNext)();
+	}));
@@ -0,0 +1,356 @@
+/**
+ * Including the Header libraries and files required
+ **/
+#include "SkycatchSiteIndex.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/VectorRegister.h"
+#include "SkycatchPolygonUnion.h"
+#include "SkycatchSettings.h"
+
+/**
+ * @brief Number of locations under which a batch is answered on the calling thread.
+ */
+static constexpr int32 ParallelQueryThreshold = 2048;
+
+/**
+ * @brief Number of locations answered by each task of a parallel batch.
+ */
+static constexpr int32 QueryChunkSize = 1024;
+
+/**
+ * @brief Maximum number of cells along each side of the grid.
+ */
+static constexpr int32 MaxGridSize = 512;
+
+/**
+ * @brief Removes all the sites.
+ */
+void FSkycatchSiteIndex::Reset()
+{
+	AddedSites.Reset();
+	Sites.Reset();
+	EdgeX0.Reset();
+	EdgeY0.Reset();
+	EdgeX1.Reset();
+	EdgeY1.Reset();
+	CellStart.Reset();
+	CellSites.Reset();
+	GridSizeX = 0;
+	GridSizeY = 0;
+}
+
+/**
+ * @brief Adds a site. The rings are combined with the even-odd rule, so holes are given as rings inside the outer
+ * ring. When sites overlap, points are given to the smallest one. Build has to be called after adding the sites.
+ *
+ * @param SiteId as the id returned for the points inside the site
+ * @param Rings as the rings of the site, without a closing point
+ */
+void FSkycatchSiteIndex::AddSite(int32 SiteId, const TArray<TArray<FVector2D>>& Rings)
+{
+	AddedSites.Emplace(SiteId, Rings);
+}
+
+/**
+ * @brief Builds the grid over the added sites. The sites added before are kept.
+ */
+void FSkycatchSiteIndex::Build()
+{
+	Sites.Reset();
+	EdgeX0.Reset();
+	EdgeY0.Reset();
+	EdgeX1.Reset();
+	EdgeY1.Reset();
+	CellStart.Reset();
+	CellSites.Reset();
+	GridSizeX = 0;
+	GridSizeY = 0;
+
+	//The edges are stored from the center of all the sites, so world coordinates keep their precision in floats
+	FBox2D AllBounds(ForceInit);
+	TArray<double> Areas;
+	for (const TPair<int32, TArray<TArray<FVector2D>>>& AddedSite : AddedSites)
+	{
+		double Area = 0.0;
+		for (const TArray<FVector2D>& Ring : AddedSite.Value)
+		{
+			AllBounds += FSkycatchPolygonUnion::GetBounds(Ring);
+			Area += FSkycatchPolygonUnion::SignedArea(Ring);
+		}
+		Areas.Add(FMath::Abs(Area));
+	}
+	if (!AllBounds.bIsValid)
+	{
+		return;
+	}
+	Origin = AllBounds.GetCenter();
+
+	//The smallest sites come first, so points inside overlapping sites get the most specific one
+	TArray<int32> Order;
+	for (int32 Index = 0; Index < AddedSites.Num(); Index++)
+	{
+		Order.Add(Index);
+	}
+	Order.StableSort([&Areas](int32 A, int32 B) { return Areas[A] < Areas[B]; });
+
+	for (const int32 Index : Order)
+	{
+		FSite& Site = Sites.AddDefaulted_GetRef();
+		Site.SiteId = AddedSites[Index].Key;
+		Site.FirstEdge = EdgeX0.Num();
+		Site.Bounds = FBox2f(ForceInit);
+		for (const TArray<FVector2D>& Ring : AddedSites[Index].Value)
+		{
+			if (Ring.Num() < 3)
+			{
+				continue;
+			}
+			for (int32 Vertex = 0; Vertex < Ring.Num(); Vertex++)
+			{
+				const FVector2f Start(Ring[Vertex] - Origin);
+				const FVector2f End(Ring[(Vertex + 1) % Ring.Num()] - Origin);
+				EdgeX0.Add(Start.X);
+				EdgeY0.Add(Start.Y);
+				EdgeX1.Add(End.X);
+				EdgeY1.Add(End.Y);
+				Site.Bounds += Start;
+			}
+		}
+
+		//Horizontal edges never cross the ray of a point, they pad the site to whole registers
+		while (EdgeX0.Num() % 4 != 0)
+		{
+			EdgeX0.Add(0.0f);
+			EdgeY0.Add(0.0f);
+			EdgeX1.Add(0.0f);
+			EdgeY1.Add(0.0f);
+		}
+		Site.NumEdges = EdgeX0.Num() - Site.FirstEdge;
+	}
+
+	//About four cells per site along each side of the grid, with square cells
+	const FVector2D Extent = AllBounds.GetSize();
+	const int32 CellsPerSide = FMath::Clamp(FMath::CeilToInt(FMath::Sqrt(static_cast<float>(Sites.Num()))) * 4, 1, MaxGridSize);
+	CellSize = FMath::Max(FMath::Max(Extent.X, Extent.Y) / CellsPerSide, 1.0);
+	GridMin = FVector2f(AllBounds.Min - Origin);
+	GridSizeX = FMath::Clamp(FMath::CeilToInt(Extent.X / CellSize), 1, MaxGridSize);
+	GridSizeY = FMath::Clamp(FMath::CeilToInt(Extent.Y / CellSize), 1, MaxGridSize);
+
+	auto GetCellRange = [this](const FBox2f& Bounds, FIntPoint& OutMin, FIntPoint& OutMax)
+	{
+		OutMin.X = FMath::Clamp(FMath::FloorToInt((Bounds.Min.X - GridMin.X) / CellSize), 0, GridSizeX - 1);
+		OutMin.Y = FMath::Clamp(FMath::FloorToInt((Bounds.Min.Y - GridMin.Y) / CellSize), 0, GridSizeY - 1);
+		OutMax.X = FMath::Clamp(FMath::FloorToInt((Bounds.Max.X - GridMin.X) / CellSize), 0, GridSizeX - 1);
+		OutMax.Y = FMath::Clamp(FMath::FloorToInt((Bounds.Max.Y - GridMin.Y) / CellSize), 0, GridSizeY - 1);
+	};
+
+	//Counts the sites of every cell, then fills them in the order of the sites
+	CellStart.SetNumZeroed(GridSizeX * GridSizeY + 1);
+	for (const FSite& Site : Sites)
+	{
+		FIntPoint Min, Max;
+		GetCellRange(Site.Bounds, Min, Max);
+		for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+		{
+			for (int32 X = Min.X; X <= Max.X; X++)
+			{
+				CellStart[Y * GridSizeX + X + 1]++;
+			}
+		}
+	}
+	for (int32 Cell = 1; Cell < CellStart.Num(); Cell++)
+	{
+		CellStart[Cell] += CellStart[Cell - 1];
+	}
+
+	CellSites.SetNumUninitialized(CellStart.Last());
+	TArray<int32> CellFill(CellStart.GetData(), CellStart.Num() - 1);
+	for (int32 Index = 0; Index < Sites.Num(); Index++)
+	{
+		FIntPoint Min, Max;
+		GetCellRange(Sites[Index].Bounds, Min, Max);
+		for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+		{
+			for (int32 X = Min.X; X <= Max.X; X++)
+			{
+				CellSites[CellFill[Y * GridSizeX + X]++] = Index;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Returns whether a point relative to the origin is inside a site.
+ */
+bool FSkycatchSiteIndex::IsInside(const FSite& Site, const FVector2f& Point) const
+{
+	if (Point.X < Site.Bounds.Min.X || Point.X > Site.Bounds.Max.X || Point.Y < Site.Bounds.Min.Y || Point.Y > Site.Bounds.Max.Y)
+	{
+		return false;
+	}
+
+	//Counts the edges crossed by a ray from the point towards +X, four edges at a time
+	const VectorRegister4Float PointX = VectorSetFloat1(Point.X);
+	const VectorRegister4Float PointY = VectorSetFloat1(Point.Y);
+	int32 Crossings = 0;
+	for (int32 Edge = Site.FirstEdge; Edge < Site.FirstEdge + Site.NumEdges; Edge += 4)
+	{
+		const VectorRegister4Float X0 = VectorLoad(&EdgeX0[Edge]);
+		const VectorRegister4Float Y0 = VectorLoad(&EdgeY0[Edge]);
+		const VectorRegister4Float X1 = VectorLoad(&EdgeX1[Edge]);
+		const VectorRegister4Float Y1 = VectorLoad(&EdgeY1[Edge]);
+
+		//The edge spans the height of the point, and crosses it to the right of the point
+		const VectorRegister4Float Spans = VectorBitwiseXor(VectorCompareGT(Y0, PointY), VectorCompareGT(Y1, PointY));
+		const VectorRegister4Float CrossingX = VectorMultiplyAdd(VectorSubtract(X1, X0),
+			VectorDivide(VectorSubtract(PointY, Y0), VectorSubtract(Y1, Y0)), X0);
+		const VectorRegister4Float Crosses = VectorBitwiseAnd(Spans, VectorCompareGT(CrossingX, PointX));
+		Crossings += FMath::CountBits(VectorMaskBits(Crosses));
+	}
+	return (Crossings & 1) != 0;
+}
+
+/**
+ * @brief Returns the id of the site containing a point, or INDEX_NONE.
+ *
+ * @param Point as the point to locate
+ */
+int32 FSkycatchSiteIndex::FindSite(const FVector2D& Point) const
+{
+	if (GridSizeX == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	const FVector2f Local(Point - Origin);
+	const int32 X = FMath::FloorToInt((Local.X - GridMin.X) / CellSize);
+	const int32 Y = FMath::FloorToInt((Local.Y - GridMin.Y) / CellSize);
+	if (X < 0 || Y < 0 || X >= GridSizeX || Y >= GridSizeY)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 Cell = Y * GridSizeX + X;
+	for (int32 Entry = CellStart[Cell]; Entry < CellStart[Cell + 1]; Entry++)
+	{
+		const FSite& Site = Sites[CellSites[Entry]];
+		if (IsInside(Site, Local))
+		{
+			return Site.SiteId;
+		}
+	}
+	return INDEX_NONE;
+}
+
+/**
+ * @brief Finds the site containing each of the locations, using their X and Y.
+ *
+ * @param Locations as the locations to find
+ * @param OutSiteIds as the id of the site containing each location, or INDEX_NONE
+ * @param bParallel as whether large batches are split across worker threads
+ */
+void FSkycatchSiteIndex::FindSites(TArrayView<const FVector> Locations, TArrayView<int32> OutSiteIds, bool bParallel) const
+{
+	check(Locations.Num() == OutSiteIds.Num());
+	const int32 NumChunks = FMath::DivideAndRoundUp(Locations.Num(), QueryChunkSize);
+	ParallelFor(NumChunks, [&](int32 Chunk)
+	{
+		const int32 End = FMath::Min(Locations.Num(), (Chunk + 1) * QueryChunkSize);
+		for (int32 Index = Chunk * QueryChunkSize; Index < End; Index++)
+		{
+			OutSiteIds[Index] = FindSite(FVector2D(Locations[Index]));
+		}
+	}, bParallel && Locations.Num() >= ParallelQueryThreshold ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+}
+
+/**
+ * @brief Compares the site index against testing every point against every site, over random sites and points.
+ * Usage: Skycatch.BenchmarkSiteQuery [Agents=10000] [Sites=100] [Vertices=64]
+ */
+static FAutoConsoleCommand BenchmarkSiteQueryCommand(
+	TEXT("Skycatch.BenchmarkSiteQuery"),
+	TEXT("Measures the site containment query over random sites and agents. Usage: Skycatch.BenchmarkSiteQuery [Agents=10000] [Sites=100] [Vertices=64]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumAgents = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 10000;
+		const int32 NumSites = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 100;
+		const int32 NumVertices = Args.Num() > 2 ? FMath::Max(3, FCString::Atoi(*Args[2])) : 64;
+
+		//Star shaped sites of 200 m to 2 km scattered over 50 km, in centimeters around a georeference far from the origin
+		FRandomStream Random(NumSites);
+		const FVector2D Center(3.0e7, -1.5e7);
+		const double Extent = 2.5e6;
+		TArray<TArray<FVector2D>> Outlines;
+		FSkycatchSiteIndex Index;
+		for (int32 Site = 0; Site < NumSites; Site++)
+		{
+			const FVector2D SiteCenter = Center + FVector2D(Random.FRandRange(-Extent, Extent), Random.FRandRange(-Extent, Extent));
+			const double Radius = Random.FRandRange(2.0e4, 2.0e5);
+			TArray<FVector2D>& Outline = Outlines.AddDefaulted_GetRef();
+			for (int32 Vertex = 0; Vertex < NumVertices; Vertex++)
+			{
+				const double Angle = 2.0 * PI * Vertex / NumVertices;
+				Outline.Add(SiteCenter + FVector2D(FMath::Cos(Angle), FMath::Sin(Angle)) * Radius * Random.FRandRange(0.6, 1.0));
+			}
+			Index.AddSite(Site, { Outline });
+		}
+
+		double StartTime = FPlatformTime::Seconds();
+		Index.Build();
+		const double BuildMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		TArray<FVector> Agents;
+		for (int32 Agent = 0; Agent < NumAgents; Agent++)
+		{
+			Agents.Add(FVector(Center + FVector2D(Random.FRandRange(-Extent, Extent), Random.FRandRange(-Extent, Extent)), 0.0));
+		}
+
+		//Every agent against every site, as testing the outlines one by one does
+		TArray<int32> Expected;
+		Expected.Init(INDEX_NONE, NumAgents);
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Agent = 0; Agent < NumAgents; Agent++)
+		{
+			double SmallestArea = TNumericLimits<double>::Max();
+			for (int32 Site = 0; Site < NumSites; Site++)
+			{
+				if (FSkycatchPolygonUnion::IsPointInside(Outlines[Site], FVector2D(Agents[Agent])))
+				{
+					const double Area = FMath::Abs(FSkycatchPolygonUnion::SignedArea(Outlines[Site]));
+					if (Area < SmallestArea)
+					{
+						SmallestArea = Area;
+						Expected[Agent] = Site;
+					}
+				}
+			}
+		}
+		const double BruteForceMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		TArray<int32> SingleThreaded;
+		SingleThreaded.SetNumUninitialized(NumAgents);
+		StartTime = FPlatformTime::Seconds();
+		Index.FindSites(Agents, SingleThreaded, false);
+		const double SingleThreadedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		TArray<int32> Parallel;
+		Parallel.SetNumUninitialized(NumAgents);
+		StartTime = FPlatformTime::Seconds();
+		Index.FindSites(Agents, Parallel);
+		const double ParallelMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		int32 Inside = 0;
+		int32 Mismatches = 0;
+		for (int32 Agent = 0; Agent < NumAgents; Agent++)
+		{
+			Inside += Expected[Agent] != INDEX_NONE ? 1 : 0;
+			Mismatches += Expected[Agent] != Parallel[Agent] || Parallel[Agent] != SingleThreaded[Agent] ? 1 : 0;
+		}
+
+		UE_LOG(LogSkycatch, Display, TEXT("Site query benchmark: %d agents, %d sites of %d vertices, %d agents inside a site, index built in %.2f ms"),
+			NumAgents, NumSites, NumVertices, Inside, BuildMs);
+		UE_LOG(LogSkycatch, Display, TEXT("  every site: %.2f ms, index: %.2f ms, index in parallel: %.2f ms (%.1fx)"),
+			BruteForceMs, SingleThreadedMs, ParallelMs, BruteForceMs / FMath::Max(ParallelMs, 0.001));
+		UE_LOG(LogSkycatch, Display, TEXT("  %d agents answered differently, from points on the edges"), Mismatches);
+	}));
@@ -0,0 +1,252 @@
+/**
+ * Including the Header libraries and files required
+ **/
+#include "SkycatchSitePayload.h"
+#include "Misc/AutomationTest.h"
+
+/**
+ * @brief Quantization of the replicated coordinates, 1e-7 degrees is about one centimeter
+ */
+static constexpr double SkycatchOutlineQuantization = 1e7;
+
+/**
+ * @brief Writes a signed integer as a zigzag variable length integer
+ */
+static void WriteVarint(TArray<uint8>& Data, int64 Value)
+{
+	uint64 ZigZag = (static_cast<uint64>(Value) << 1) ^ static_cast<uint64>(Value >> 63);
+	do
+	{
+		uint8 Byte = ZigZag & 0x7F;
+		ZigZag >>= 7;
+		if (ZigZag != 0)
+		{
+			Byte |= 0x80;
+		}
+		Data.Add(Byte);
+	} while (ZigZag != 0);
+}
+
+/**
+ * @brief Reads a zigzag variable length integer, returns false when the data ends before the integer does
+ */
+static bool ReadVarint(const TArray<uint8>& Data, int32& Offset, int64& Value)
+{
+	uint64 ZigZag = 0;
+	for (int32 Shift = 0; Shift < 64; Shift += 7)
+	{
+		if (!Data.IsValidIndex(Offset))
+		{
+			return false;
+		}
+
+		const uint8 Byte = Data[Offset++];
+		ZigZag |= static_cast<uint64>(Byte & 0x7F) << Shift;
+		if ((Byte & 0x80) == 0)
+		{
+			Value = static_cast<int64>(ZigZag >> 1) ^ -static_cast<int64>(ZigZag & 1);
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Quantizes and encodes the parts of an outline, each being an outer ring and its holes in longitude and
+ * latitude, without a closing point.
+ *
+ * @param Parts as the parts of the outline to encode
+ */
+TArray<uint8> FSkycatchSitePayload::EncodeOutline(const TArray<TArray<TArray<FVector2D>>>& Parts)
+{
+	TArray<uint8> Data;
+
+	//The structure of the outline comes first, so the client rebuilds the same parts and holes
+	int32 NumPoints = 0;
+	WriteVarint(Data, Parts.Num());
+	for (const TArray<TArray<FVector2D>>& Rings : Parts)
+	{
+		WriteVarint(Data, Rings.Num());
+		for (const TArray<FVector2D>& Ring : Rings)
+		{
+			WriteVarint(Data, Ring.Num());
+			NumPoints += Ring.Num();
+		}
+	}
+	Data.Reserve(Data.Num() + NumPoints * 4);
+
+	int64 PreviousLongitude = 0;
+	int64 PreviousLatitude = 0;
+	for (const TArray<TArray<FVector2D>>& Rings : Parts)
+	{
+		for (const TArray<FVector2D>& Ring : Rings)
+		{
+			for (const FVector2D& Point : Ring)
+			{
+				//Consecutive outline points are close, so their deltas fit in a few bytes
+				const int64 Longitude = FMath::RoundToInt64(Point.X * SkycatchOutlineQuantization);
+				const int64 Latitude = FMath::RoundToInt64(Point.Y * SkycatchOutlineQuantization);
+				WriteVarint(Data, Longitude - PreviousLongitude);
+				WriteVarint(Data, Latitude - PreviousLatitude);
+				PreviousLongitude = Longitude;
+				PreviousLatitude = Latitude;
+			}
+		}
+	}
+	return Data;
+}
+
+/**
+ * @brief Decodes the parts of an outline. Returns false when the data is malformed.
+ *
+ * @param Data as the encoded outline
+ * @param OutParts as the decoded parts, each being an outer ring and its holes in longitude and latitude
+ */
+bool FSkycatchSitePayload::DecodeOutline(const TArray<uint8>& Data, TArray<TArray<TArray<FVector2D>>>& OutParts)
+{
+	OutParts.Reset();
+
+	//Every count takes at least one byte and every point two, so a count larger than the bytes left is malformed
+	int32 Offset = 0;
+	int64 NumParts;
+	if (!ReadVarint(Data, Offset, NumParts) || NumParts < 0 || NumParts > Data.Num() - Offset)
+	{
+		return false;
+	}
+	OutParts.SetNum(NumParts);
+	for (TArray<TArray<FVector2D>>& Rings : OutParts)
+	{
+		int64 NumRings;
+		if (!ReadVarint(Data, Offset, NumRings) || NumRings < 0 || NumRings > Data.Num() - Offset)
+		{
+			return false;
+		}
+		Rings.SetNum(NumRings);
+		for (TArray<FVector2D>& Ring : Rings)
+		{
+			int64 NumPoints;
+			if (!ReadVarint(Data, Offset, NumPoints) || NumPoints < 0 || NumPoints > (Data.Num() - Offset) / 2)
+			{
+				return false;
+			}
+			Ring.SetNumUninitialized(NumPoints);
+		}
+	}
+
+	int64 Longitude = 0;
+	int64 Latitude = 0;
+	for (TArray<TArray<FVector2D>>& Rings : OutParts)
+	{
+		for (TArray<FVector2D>& Ring : Rings)
+		{
+			for (FVector2D& Point : Ring)
+			{
+				int64 LongitudeDelta;
+				int64 LatitudeDelta;
+				if (!ReadVarint(Data, Offset, LongitudeDelta) || !ReadVarint(Data, Offset, LatitudeDelta))
+				{
+					return false;
+				}
+
+				Longitude += LongitudeDelta;
+				Latitude += LatitudeDelta;
+				Point = FVector2D(Longitude / SkycatchOutlineQuantization, Latitude / SkycatchOutlineQuantization);
+			}
+		}
+	}
+	return Offset == Data.Num();
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * @brief Encodes and decodes outlines through the replicated payload: an empty outline, steps of one quantum with
+ * negative deltas, a polygon with holes, a multipolygon, the extremes of the coordinates and malformed payloads.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSkycatchSitePayloadOutlineTest, "Skycatch.SitePayload.OutlineRoundTrip",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FSkycatchSitePayloadOutlineTest::RunTest(const FString& Parameters)
+{
+	typedef TArray<TArray<FVector2D>> FRings;
+
+	//Decoded outlines keep their parts and rings, and their coordinates are within half a quantum of the encoded ones
+	auto RoundTrip = [this](const FString& What, const TArray<FRings>& Parts)
+	{
+		TArray<FRings> Decoded;
+		const TArray<uint8> Data = FSkycatchSitePayload::EncodeOutline(Parts);
+		if (!TestTrue(*(What + TEXT(" decodes")), FSkycatchSitePayload::DecodeOutline(Data, Decoded)) ||
+			!TestEqual(*(What + TEXT(" part count")), Decoded.Num(), Parts.Num()))
+		{
+			return;
+		}
+		for (int32 Part = 0; Part < Parts.Num(); Part++)
+		{
+			if (!TestEqual(*FString::Printf(TEXT("%s part %d ring count"), *What, Part), Decoded[Part].Num(), Parts[Part].Num()))
+			{
+				continue;
+			}
+			for (int32 Ring = 0; Ring < Parts[Part].Num(); Ring++)
+			{
+				const TArray<FVector2D>& Expected = Parts[Part][Ring];
+				const TArray<FVector2D>& Actual = Decoded[Part][Ring];
+				if (!TestEqual(*FString::Printf(TEXT("%s ring %d.%d point count"), *What, Part, Ring), Actual.Num(), Expected.Num()))
+				{
+					continue;
+				}
+				for (int32 Index = 0; Index < Expected.Num(); Index++)
+				{
+					TestEqual(*FString::Printf(TEXT("%s longitude %d.%d.%d"), *What, Part, Ring, Index), Actual[Index].X, Expected[Index].X, 0.5e-7);
+					TestEqual(*FString::Printf(TEXT("%s latitude %d.%d.%d"), *What, Part, Ring, Index), Actual[Index].Y, Expected[Index].Y, 0.5e-7);
+				}
+			}
+		}
+	};
+
+	//An empty outline only writes its part count
+	TestEqual(TEXT("Empty outline payload size"), FSkycatchSitePayload::EncodeOutline({}).Num(), 1);
+	RoundTrip(TEXT("Empty outline"), {});
+
+	//A ring west of Greenwich and south of the equator, walked with steps of one quantum in every direction
+	const FVector2D Origin(-70.6482935, -33.4569397);
+	TArray<FVector2D> Steps = { Origin };
+	for (const FVector2D& Step : { FVector2D(1, 0), FVector2D(0, 1), FVector2D(-1, 0), FVector2D(0, -1), FVector2D(-3, -2), FVector2D(3, 2) })
+	{
+		Steps.Add(Steps.Last() + Step * 1e-7);
+	}
+	RoundTrip(TEXT("One quantum steps"), { { Steps } });
+
+	//Adjacent points that differ by one quantum stay distinct, the precision is 1e-7 degrees
+	TArray<FRings> Decoded;
+	FSkycatchSitePayload::DecodeOutline(FSkycatchSitePayload::EncodeOutline({ { Steps } }), Decoded);
+	if (Decoded.Num() == 1 && Decoded[0].Num() == 1 && Decoded[0][0].Num() == Steps.Num())
+	{
+		TestNotEqual(TEXT("One quantum apart points stay distinct"), Decoded[0][0][0].X, Decoded[0][0][1].X);
+	}
+
+	//A square with two holes, and a multipolygon whose second part has a hole
+	const TArray<FVector2D> Square = { FVector2D(-99.14, 19.42), FVector2D(-99.12, 19.42), FVector2D(-99.12, 19.44), FVector2D(-99.14, 19.44) };
+	const TArray<FVector2D> HoleA = { FVector2D(-99.138, 19.422), FVector2D(-99.138, 19.428), FVector2D(-99.132, 19.428), FVector2D(-99.132, 19.422) };
+	const TArray<FVector2D> HoleB = { FVector2D(-99.128, 19.432), FVector2D(-99.128, 19.438), FVector2D(-99.122, 19.438) };
+	RoundTrip(TEXT("Polygon with holes"), { { Square, HoleA, HoleB } });
+	RoundTrip(TEXT("Multipolygon"), { { Steps }, { Square, HoleA } });
+
+	//The largest deltas a geodetic outline can have, across the antimeridian and between the poles
+	RoundTrip(TEXT("Extremes"), { { { FVector2D(180.0, 90.0), FVector2D(-180.0, -90.0), FVector2D(179.9999999, -89.9999999), FVector2D(0.0, 0.0) } } });
+
+	//Small steps take one byte per coordinate, after one byte for each count
+	TestEqual(TEXT("Payload size of one quantum steps"), FSkycatchSitePayload::EncodeOutline({ { { FVector2D::ZeroVector, FVector2D(1e-7, -1e-7) } } }).Num(), 7);
+
+	//A payload cut inside a point, with bytes after the last point, or with counts larger than the payload is malformed
+	TArray<uint8> Truncated = FSkycatchSitePayload::EncodeOutline({ { Steps } });
+	Truncated.SetNum(Truncated.Num() - 1);
+	TestFalse(TEXT("Truncated payload is rejected"), FSkycatchSitePayload::DecodeOutline(Truncated, Decoded));
+	TArray<uint8> Trailing = FSkycatchSitePayload::EncodeOutline({ { Steps } });
+	Trailing.Add(0);
+	TestFalse(TEXT("Trailing bytes are rejected"), FSkycatchSitePayload::DecodeOutline(Trailing, Decoded));
+	TestFalse(TEXT("Oversized counts are rejected"), FSkycatchSitePayload::DecodeOutline({ 0x7E, 0x02, 0x02 }, Decoded));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,1228 @@
+/**
+ * Including the Header libraries and files required
+ **/
+#include "SkycatchSubsystem.h"
+#include "SkycatchTerrain.h"
+#include "Cesium3DTileset.h"
+#include "Cesium3DTilesSelection/Tileset.h"
+#include "CesiumCartographicPolygon.h"
+#include "CesiumPolygonRasterOverlay.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "EngineUtils.h"
+#include "SkycatchSiteCache.h"
+#include "SkycatchSettings.h"
+#include "SkycatchPolygonUnion.h"
+
+/**
+ * @brief Approximate length in meters of a degree of latitude, used to convert the merge tolerance to degrees.
+ */
+static constexpr double MetersPerDegree = 111320.0;
+
+/**
+ * @brief Factor applied to the priority of a collision tileset, which only loads coarse tiles.
+ */
+static constexpr float CollisionTilesetPriority = 0.25f;
+
+/**
+ * @brief Factor applied to the priority of a tileset that is hidden or kept warm for a capture of the site.
+ */
+static constexpr float BackgroundTilesetPriority = 0.1f;
+
+/**
+ * @brief Stops listening to the georeferences when the world is torn down
+ */
+void USkycatchSubsystem::Deinitialize()
+{
+	for (const TWeakObjectPtr<ACesiumGeoreference>& Georeference : BoundGeoreferences)
+	{
+		if (Georeference.IsValid())
+		{
+			Georeference->OnGeoreferenceUpdated.RemoveDynamic(this, &USkycatchSubsystem::HandleGeoreferenceUpdated);
+		}
+	}
+	TilePrewarm.Cancel(GetWorld());
+	BoundGeoreferences.Empty();
+	Terrains.Empty();
+
+	for (const TPair<int32, FOverlayGroup>& Group : OverlayGroups)
+	{
+		for (const TWeakObjectPtr<ACesiumCartographicPolygon>& Polygon : Group.Value.Polygons)
+		{
+			if (Polygon.IsValid())
+			{
+				Polygon->Destroy();
+			}
+		}
+	}
+	OverlayGroups.Empty();
+	OverlaySites.Empty();
+	SubmittedPolygons.Empty();
+
+	Super::Deinitialize();
+}
+
+/**
+ * @brief Called every frame
+ * 
+ * @param DeltaTime 
+ */
+void USkycatchSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const USkycatchSettings* Settings = GetDefault<USkycatchSettings>();
+	TimeSincePrefetch += DeltaTime;
+	if (Settings->SitePrefetchDistance > 0.0f && TimeSincePrefetch >= Settings->SitePrefetchIntervalSeconds)
+	{
+		TimeSincePrefetch = 0.0f;
+		PrefetchNearbySites();
+	}
+
+	TimeSinceActivation += DeltaTime;
+	if (OverlaySites.Num() > 0 && TimeSinceActivation >= Settings->OverlayActivationIntervalSeconds)
+	{
+		TimeSinceActivation = 0.0f;
+		UpdateOverlayActivation();
+	}
+
+	TimeSinceTilesetBudget += DeltaTime;
+	if (Settings->bGovernTilesetMemory && (bTilesetBudgetsDirty || TimeSinceTilesetBudget >= Settings->TilesetBudgetIntervalSeconds))
+	{
+		TimeSinceTilesetBudget = 0.0f;
+		RebalanceTilesetBudgets();
+	}
+
+	if (CommitQueue.Num() > 0)
+	{
+		TArray<FVector> ViewLocations;
+		for (const FPlayerView& View : GetPlayerViews())
+		{
+			ViewLocations.Add(View.Location);
+		}
+		CommitQueue.Run(ViewLocations, Settings->CommitBudgetMilliseconds);
+	}
+
+	//The overlay changes made since the last refresh are applied together once the queued commits are done, at
+	//most once per interval, so a burst of commits refreshes the overlay once
+	TimeSinceOverlayRefresh += DeltaTime;
+	if (bOverlayRefreshPending && CommitQueue.Num() == 0 && TimeSinceOverlayRefresh >= Settings->OverlayRefreshIntervalSeconds)
+	{
+		RefreshOverlay();
+	}
+
+	TilePrewarm.Tick(GetWorld());
+}
+
+TStatId USkycatchSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USkycatchSubsystem, STATGROUP_Tickables);
+}
+
+/**
+ * @brief Fetches the lookups of the known sites close to the player views ahead of their streaming, so they are
+ * cached when the actors of the sites stream in.
+ */
+void USkycatchSubsystem::PrefetchNearbySites()
+{
+	UWorld* World = GetWorld();
+	if (!World || !World->IsGameWorld())
+	{
+		return;
+	}
+
+	ACesiumGeoreference* Georeference = ACesiumGeoreference::GetDefaultGeoreference(World);
+	if (!Georeference)
+	{
+		return;
+	}
+
+	const TArray<FPlayerView> Views = GetPlayerViews();
+
+	//Refreshes the known sites that are close to a view and whose cached lookup expired
+	FSkycatchSiteCache& SiteCache = FSkycatchSiteCache::Get();
+	const double PrefetchDistanceSquared = FMath::Square((double)GetDefault<USkycatchSettings>()->SitePrefetchDistance);
+	for (const FSkycatchCachedSite& Site : SiteCache.GetSites())
+	{
+		if (SiteCache.IsCached(Site.Params) || SiteCache.IsInFlight(Site.Params))
+		{
+			continue;
+		}
+
+		const glm::dvec3 SiteLocation = Georeference->TransformLongitudeLatitudeHeightToUnreal(glm::dvec3(Site.Longitude, Site.Latitude, 0.0));
+		for (const FPlayerView& View : Views)
+		{
+			if (FVector::DistSquared(View.Location, FVector(SiteLocation.x, SiteLocation.y, SiteLocation.z)) <= PrefetchDistanceSquared)
+			{
+				SiteCache.Prefetch(Site.Params);
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Adds the outlines of the sites that came close to or into the player views to the raster overlay, and
+ * removes those of the sites that left them, in one batch.
+ */
+void USkycatchSubsystem::UpdateOverlayActivation()
+{
+	const UWorld* World = GetWorld();
+	const TArray<FPlayerView> Views = GetPlayerViews();
+	const bool bAlwaysActive = !World || !World->IsGameWorld() || !GetDefault<USkycatchSettings>()->bAutoActivateOverlayPolygons || Views.Num() == 0;
+
+	TArray<TWeakObjectPtr<ASkycatchTerrain>> ChangedSites;
+	int32 Activated = 0;
+	for (TPair<TWeakObjectPtr<ASkycatchTerrain>, FOverlaySite>& Site : OverlaySites)
+	{
+		const bool bActive = bAlwaysActive || ShouldActivateSite(Site.Value, Views);
+		if (bActive != Site.Value.bActive)
+		{
+			Site.Value.bActive = bActive;
+			ChangedSites.Add(Site.Key);
+			Activated += bActive ? 1 : 0;
+		}
+	}
+
+	if (ChangedSites.Num() > 0)
+	{
+		UE_LOG(LogSkycatch, Verbose, TEXT("Activated %d and deactivated %d Skycatch polygons"), Activated, ChangedSites.Num() - Activated);
+		MergeSites(ChangedSites);
+	}
+}
+
+/**
+ * @brief Collects the views of the local players.
+ */
+TArray<USkycatchSubsystem::FPlayerView> USkycatchSubsystem::GetPlayerViews() const
+{
+	TArray<FPlayerView> Views;
+	const UWorld* World = GetWorld();
+	if (!World)
+	{
+		return Views;
+	}
+
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (!PlayerController || !PlayerController->IsLocalController())
+		{
+			continue;
+		}
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+		//The cone around the view direction contains the corners of the horizontal field of view
+		const float HorizontalFOV = PlayerController->PlayerCameraManager ? PlayerController->PlayerCameraManager->GetFOVAngle() : 90.0f;
+		int32 ViewportWidth = 16;
+		int32 ViewportHeight = 9;
+		PlayerController->GetViewportSize(ViewportWidth, ViewportHeight);
+		const double AspectRatio = ViewportWidth > 0 && ViewportHeight > 0 ? (double)ViewportWidth / ViewportHeight : 16.0 / 9.0;
+		const double HalfTangent = FMath::Tan(FMath::DegreesToRadians(HorizontalFOV * 0.5));
+		const double HalfAngle = FMath::Atan(HalfTangent * FMath::Sqrt(1.0 + 1.0 / FMath::Square(AspectRatio)));
+
+		Views.Add({ ViewLocation, ViewRotation.Vector(), HalfAngle });
+	}
+	return Views;
+}
+
+/**
+ * @brief Computes the center and radius of a site in Unreal coordinates.
+ *
+ * @param Terrain as the actor of the site
+ * @param Site as the site to locate
+ */
+void USkycatchSubsystem::LocateSite(const ASkycatchTerrain* Terrain, FOverlaySite& Site)
+{
+	if (!Terrain || !Terrain->GeoreferenceActor || !Site.Bounds.bIsValid)
+	{
+		return;
+	}
+
+	const double Height = Terrain->OutlineLongitudeLatitudeHeight.Num() > 0 ? Terrain->OutlineLongitudeLatitudeHeight[0].Z : 0.0;
+	auto Project = [Terrain, Height](const FVector2D& Point)
+	{
+		const glm::dvec3 UECoords = Terrain->GeoreferenceActor->TransformLongitudeLatitudeHeightToUnreal(glm::dvec3(Point.X, Point.Y, Height));
+		return FVector(UECoords.x, UECoords.y, UECoords.z);
+	};
+
+	Site.Location = Project(Site.Bounds.GetCenter());
+	Site.Radius = 0.0;
+	const FVector2D Corners[] = {
+		Site.Bounds.Min, Site.Bounds.Max,
+		FVector2D(Site.Bounds.Min.X, Site.Bounds.Max.Y), FVector2D(Site.Bounds.Max.X, Site.Bounds.Min.Y) };
+	for (const FVector2D& Corner : Corners)
+	{
+		Site.Radius = FMath::Max(Site.Radius, FVector::Dist(Site.Location, Project(Corner)));
+	}
+}
+
+/**
+ * @brief Returns whether a site has to be in the raster overlay for the given views. The thresholds are enlarged
+ * by the hysteresis for a site that is already active.
+ *
+ * @param Site as the site to check
+ * @param Views as the player views
+ */
+bool USkycatchSubsystem::ShouldActivateSite(const FOverlaySite& Site, const TArray<FPlayerView>& Views) const
+{
+	const USkycatchSettings* Settings = GetDefault<USkycatchSettings>();
+	const double Scale = Site.bActive ? 1.0 + Settings->OverlayActivationHysteresis : 1.0;
+	const double ActivationDistance = Settings->OverlayActivationDistance * Scale;
+	const double ViewDistance = Settings->OverlayViewDistance * Scale;
+
+	for (const FPlayerView& View : Views)
+	{
+		const FVector ToSite = Site.Location - View.Location;
+		const double CenterDistance = ToSite.Size();
+		const double Distance = FMath::Max(0.0, CenterDistance - Site.Radius);
+		if (Distance <= ActivationDistance)
+		{
+			return true;
+		}
+
+		if (Settings->bActivateOverlayInView && (Settings->OverlayViewDistance <= 0.0f || Distance <= ViewDistance))
+		{
+			//The site is seen when its bounding sphere intersects the cone of the view
+			const double Angle = FMath::Acos(FMath::Clamp(FVector::DotProduct(View.Direction, ToSite / CenterDistance), -1.0, 1.0));
+			const double AngularRadius = FMath::Asin(FMath::Min(1.0, Site.Radius / CenterDistance));
+			if (Angle - AngularRadius <= FMath::Min(View.HalfAngle * Scale, (double)PI))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Fetches the lookup of a site into the site cache, so a Skycatch Terrain actor streaming in over it later
+ * resolves without waiting for the Skycatch services.
+ *
+ * @param Lat is the Latitude value
+ * @param Lon is the Longitude value
+ */
+void USkycatchSubsystem::PrefetchSite(double Lat, double Lon)
+{
+	FSkycatchSiteCache::Get().Prefetch(ASkycatchTerrain::MakeQueryParams(Lat, Lon));
+}
+
+/**
+ * @brief Registers a Skycatch Terrain actor with a polygon outline, and listens to the changes of its georeference.
+ *
+ * @param Terrain as the actor to register
+ */
+void USkycatchSubsystem::RegisterTerrain(ASkycatchTerrain* Terrain)
+{
+	if (!Terrain)
+	{
+		return;
+	}
+
+	Terrains.AddUnique(Terrain);
+	bSiteIndexDirty = true;
+
+	ACesiumGeoreference* Georeference = Terrain->GeoreferenceActor;
+	if (Georeference && !BoundGeoreferences.Contains(Georeference))
+	{
+		Georeference->OnGeoreferenceUpdated.AddUniqueDynamic(this, &USkycatchSubsystem::HandleGeoreferenceUpdated);
+		BoundGeoreferences.Add(Georeference);
+	}
+}
+
+/**
+ * @brief Unregisters a Skycatch Terrain actor.
+ *
+ * @param Terrain as the actor to unregister
+ */
+void USkycatchSubsystem::UnregisterTerrain(ASkycatchTerrain* Terrain)
+{
+	Terrains.Remove(Terrain);
+	bSiteIndexDirty = true;
+}
+
+/**
+ * @brief Re-projects the polygons of all the registered Skycatch Terrain actors from their kept geodetic outlines
+ * in one batch, then refreshes every affected world terrain once. No request is made to Skycatch services.
+ */
+void USkycatchSubsystem::ReprojectOutlines()
+{
+	Terrains.RemoveAll([](const TWeakObjectPtr<ASkycatchTerrain>& Terrain) { return !Terrain.IsValid(); });
+	for (const TWeakObjectPtr<ASkycatchTerrain>& Terrain : Terrains)
+	{
+		Terrain->ReprojectOutline();
+	}
+	bSiteIndexDirty = true;
+
+	for (TPair<TWeakObjectPtr<ASkycatchTerrain>, FOverlaySite>& Site : OverlaySites)
+	{
+		LocateSite(Site.Key.Get(), Site.Value);
+	}
+
+	//The merged polygons are owned by the subsystem, so they are re-projected here
+	for (TPair<int32, FOverlayGroup>& Group : OverlayGroups)
+	{
+		ProjectGroup(Group.Value);
+	}
+
+	//Only the polygons submitted to the world terrain need its overlay to be refreshed, once for all of them
+	if (SubmittedPolygons.Num() > 0)
+	{
+		RequestOverlayRefresh();
+	}
+
+	UE_LOG(LogSkycatch, Verbose, TEXT("Re-projected %d Skycatch polygons"), Terrains.Num());
+}
+
+/**
+ * @brief Called when any of the georeferences used by the registered actors changes its origin.
+ */
+void USkycatchSubsystem::HandleGeoreferenceUpdated()
+{
+	ReprojectOutlines();
+}
+
+/**
+ * @brief Submits the outline of a Skycatch Terrain actor to the world terrain raster overlay. The outline is
+ * merged with the outlines of the adjacent sites, and only the group of sites it touches is merged again.
+ *
+ * @param Terrain as the actor whose outline is submitted
+ * @param Overlay as the raster overlay of the world terrain
+ */
+void USkycatchSubsystem::SubmitSitePolygon(ASkycatchTerrain* Terrain, UCesiumPolygonRasterOverlay* Overlay)
+{
+	if (!Terrain || !Terrain->CartographicPolygon || !Overlay)
+	{
+		return;
+	}
+
+	//The outlines are submitted in longitude, latitude, without the closing point of the geojson ring
+	TArray<FVector2D> Outline;
+	Outline.Reserve(Terrain->OutlineLongitudeLatitudeHeight.Num());
+	for (const FVector& Point : Terrain->OutlineLongitudeLatitudeHeight)
+	{
+		Outline.Add(FVector2D(Point.X, Point.Y));
+	}
+	if (Outline.Num() > 1 && Outline[0].Equals(Outline.Last(), 0.0))
+	{
+		Outline.Pop();
+	}
+
+	const bool bOverlayChanged = RasterOverlay != Overlay;
+	if (bOverlayChanged)
+	{
+		//The world terrain changed, so every polygon is submitted again to the new overlay
+		if (RasterOverlay.IsValid())
+		{
+			for (const TWeakObjectPtr<ACesiumCartographicPolygon>& Polygon : SubmittedPolygons)
+			{
+				RasterOverlay->Polygons.Remove(Polygon.Get());
+			}
+		}
+		SubmittedPolygons.Empty();
+		RasterOverlay = Overlay;
+	}
+
+	FOverlaySite* Site = OverlaySites.Find(Terrain);
+	if (Site && Site->Outline == Outline)
+	{
+		//Nothing changed since the outline was submitted, re-projections refresh the world terrain on their own
+		if (bOverlayChanged)
+		{
+			CommitOverlay();
+		}
+		return;
+	}
+
+	const bool bNewSite = !Site;
+	if (!Site)
+	{
+		Site = &OverlaySites.Add(Terrain);
+	}
+	Site->Outline = MoveTemp(Outline);
+	Site->bHasHoles = Terrain->OutlineGeometry.NumRings() > 1;
+	//The bounds of the parts leave out the bridges between them
+	Site->Bounds = Terrain->OutlineGeometry.NumParts() > 0 ? Terrain->OutlineGeometry.GetBounds() : FSkycatchPolygonUnion::GetBounds(Site->Outline);
+	LocateSite(Terrain, *Site);
+
+	//A new site far from the views waits out of the overlay until it comes close
+	const UWorld* World = GetWorld();
+	if (bNewSite && World && World->IsGameWorld() && GetDefault<USkycatchSettings>()->bAutoActivateOverlayPolygons)
+	{
+		const TArray<FPlayerView> Views = GetPlayerViews();
+		Site->bActive = Views.Num() == 0 || ShouldActivateSite(*Site, Views);
+	}
+	if (!Site->bActive && Site->Group == INDEX_NONE)
+	{
+		CommitOverlay();
+		return;
+	}
+	MergeSites({ Terrain });
+}
+
+/**
+ * @brief Removes the outline of a Skycatch Terrain actor from the world terrain raster overlay.
+ *
+ * @param Terrain as the actor whose outline is removed
+ */
+void USkycatchSubsystem::WithdrawSitePolygon(ASkycatchTerrain* Terrain)
+{
+	FOverlaySite Site;
+	if (!OverlaySites.RemoveAndCopyValue(Terrain, Site))
+	{
+		return;
+	}
+
+	//The other sites of its group are merged again without it
+	TArray<TWeakObjectPtr<ASkycatchTerrain>> GroupSites;
+	if (FOverlayGroup* Group = OverlayGroups.Find(Site.Group))
+	{
+		Group->Sites.Remove(Terrain);
+		GroupSites = Group->Sites;
+		if (GroupSites.Num() == 0)
+		{
+			RemoveGroup(Site.Group);
+		}
+	}
+
+	if (GroupSites.Num() > 0)
+	{
+		MergeSites(GroupSites);
+	}
+	else
+	{
+		CommitOverlay();
+	}
+}
+
+/**
+ * @brief Returns whether the outline of a Skycatch Terrain actor is submitted to the world terrain raster overlay.
+ *
+ * @param Terrain as the actor to check
+ */
+bool USkycatchSubsystem::IsSiteSubmitted(const ASkycatchTerrain* Terrain) const
+{
+	return OverlaySites.Contains(const_cast<ASkycatchTerrain*>(Terrain));
+}
+
+/**
+ * @brief Merges again the groups of sites touched by the given sites, then submits the polygons to the overlay.
+ *
+ * @param ChangedSites as the sites that were submitted, changed or withdrawn
+ */
+void USkycatchSubsystem::MergeSites(const TArray<TWeakObjectPtr<ASkycatchTerrain>>& ChangedSites)
+{
+	const USkycatchSettings* Settings = GetDefault<USkycatchSettings>();
+	const double Tolerance = Settings->PolygonMergeToleranceMeters / MetersPerDegree;
+
+	//Finds the groups the changed sites belonged to, and the groups their new outlines may touch
+	TSet<int32> DirtyGroups;
+	TArray<TWeakObjectPtr<ASkycatchTerrain>> Sites;
+	for (const TWeakObjectPtr<ASkycatchTerrain>& Terrain : ChangedSites)
+	{
+		const FOverlaySite* Site = OverlaySites.Find(Terrain);
+		if (!Site)
+		{
+			continue;
+		}
+
+		if (Site->Group != INDEX_NONE)
+		{
+			DirtyGroups.Add(Site->Group);
+		}
+		//An inactive site only leaves its group
+		if (!Site->bActive)
+		{
+			continue;
+		}
+
+		Sites.AddUnique(Terrain);
+		if (Settings->bMergeOverlayPolygons)
+		{
+			const FBox2D Bounds = FSkycatchPolygonUnion::ExpandBounds(Site->Bounds, Tolerance);
+			for (const TPair<int32, FOverlayGroup>& Group : OverlayGroups)
+			{
+				if (Group.Value.Bounds.Intersect(Bounds))
+				{
+					DirtyGroups.Add(Group.Key);
+				}
+			}
+		}
+	}
+
+	//The sites of those groups are grouped again, the other groups are kept as they are
+	for (const int32 GroupId : DirtyGroups)
+	{
+		for (const TWeakObjectPtr<ASkycatchTerrain>& Terrain : OverlayGroups[GroupId].Sites)
+		{
+			const FOverlaySite* Site = OverlaySites.Find(Terrain);
+			if (Site && Site->bActive)
+			{
+				Sites.AddUnique(Terrain);
+			}
+		}
+		RemoveGroup(GroupId);
+	}
+
+	//Destroyed actors that were not withdrawn are dropped
+	Sites.RemoveAll([this](const TWeakObjectPtr<ASkycatchTerrain>& Terrain)
+	{
+		if (!Terrain.IsValid())
+		{
+			OverlaySites.Remove(Terrain);
+			return true;
+		}
+		return false;
+	});
+
+	//Groups the sites whose outlines touch
+	TArray<int32> Parents;
+	Parents.SetNumUninitialized(Sites.Num());
+	for (int32 Index = 0; Index < Sites.Num(); Index++)
+	{
+		Parents[Index] = Index;
+	}
+	auto FindRoot = [&Parents](int32 Index)
+	{
+		while (Parents[Index] != Index)
+		{
+			Parents[Index] = Parents[Parents[Index]];
+			Index = Parents[Index];
+		}
+		return Index;
+	};
+
+	if (Settings->bMergeOverlayPolygons)
+	{
+		for (int32 A = 0; A < Sites.Num(); A++)
+		{
+			const FOverlaySite& SiteA = OverlaySites[Sites[A]];
+			for (int32 B = A + 1; B < Sites.Num(); B++)
+			{
+				const FOverlaySite& SiteB = OverlaySites[Sites[B]];
+				const int32 RootA = FindRoot(A);
+				const int32 RootB = FindRoot(B);
+				if (RootA != RootB && FSkycatchPolygonUnion::Overlaps(SiteA.Outline, SiteB.Outline, Tolerance))
+				{
+					Parents[RootB] = RootA;
+				}
+			}
+		}
+	}
+
+	TMap<int32, TArray<TWeakObjectPtr<ASkycatchTerrain>>> Groups;
+	for (int32 Index = 0; Index < Sites.Num(); Index++)
+	{
+		Groups.FindOrAdd(FindRoot(Index)).Add(Sites[Index]);
+	}
+	for (const TPair<int32, TArray<TWeakObjectPtr<ASkycatchTerrain>>>& Group : Groups)
+	{
+		CreateGroup(Group.Value);
+	}
+
+	CommitOverlay();
+}
+
+/**
+ * @brief Creates a group from sites whose outlines touch, merging their outlines when possible.
+ *
+ * @param Sites as the sites of the group
+ */
+void USkycatchSubsystem::CreateGroup(const TArray<TWeakObjectPtr<ASkycatchTerrain>>& Sites)
+{
+	const int32 GroupId = NextOverlayGroupId++;
+	FOverlayGroup& Group = OverlayGroups.Add(GroupId);
+	Group.Sites = Sites;
+	Group.Bounds = FBox2D(ForceInit);
+
+	TArray<TArray<FVector2D>> Outlines;
+	bool bHasHoles = false;
+	for (const TWeakObjectPtr<ASkycatchTerrain>& Terrain : Sites)
+	{
+		FOverlaySite& Site = OverlaySites[Terrain];
+		Site.Group = GroupId;
+		Group.Bounds += Site.Bounds;
+		Outlines.Add(Site.Outline);
+		bHasHoles |= Site.bHasHoles;
+	}
+
+	//A single site keeps its own polygon
+	if (Sites.Num() < 2)
+	{
+		return;
+	}
+
+	//The union only gives outer rings, so sites with holes or several parts keep their bridged polygons
+	if (bHasHoles)
+	{
+		UE_LOG(LogSkycatch, Log, TEXT("%d adjacent sites include outlines with holes or several parts, they are not merged"), Sites.Num());
+		return;
+	}
+
+	const double Tolerance = GetDefault<USkycatchSettings>()->PolygonMergeToleranceMeters / MetersPerDegree;
+	if (!FSkycatchPolygonUnion::Union(Outlines, Tolerance, Group.Rings))
+	{
+		//A union with holes can't be clipped as outer rings, so the outlines are submitted as they are
+		UE_LOG(LogSkycatch, Log, TEXT("The outlines of %d adjacent sites enclose a hole or can't be traced, they are not merged"), Sites.Num());
+		Group.Rings.Empty();
+		return;
+	}
+
+	for (int32 Index = 0; Index < Group.Rings.Num(); Index++)
+	{
+		ACesiumCartographicPolygon* Polygon = GetWorld()->SpawnActor<ACesiumCartographicPolygon>(FVector::ZeroVector, FRotator::ZeroRotator);
+		Polygon->Tags.Add(FName("Skycatch"));
+		Group.Polygons.Add(Polygon);
+	}
+	ProjectGroup(Group);
+}
+
+/**
+ * @brief Destroys the polygons spawned for a group and forgets it.
+ *
+ * @param GroupId as the group to remove
+ */
+void USkycatchSubsystem::RemoveGroup(int32 GroupId)
+{
+	FOverlayGroup Group;
+	if (!OverlayGroups.RemoveAndCopyValue(GroupId, Group))
+	{
+		return;
+	}
+
+	for (const TWeakObjectPtr<ASkycatchTerrain>& Terrain : Group.Sites)
+	{
+		if (FOverlaySite* Site = OverlaySites.Find(Terrain))
+		{
+			Site->Group = INDEX_NONE;
+		}
+	}
+	//The polygons stay in the overlay until the next commit replaces them
+	for (const TWeakObjectPtr<ACesiumCartographicPolygon>& Polygon : Group.Polygons)
+	{
+		if (Polygon.IsValid())
+		{
+			Polygon->Destroy();
+		}
+	}
+}
+
+/**
+ * @brief Projects the rings of a group to the polygons spawned for it.
+ *
+ * @param Group as the group to project
+ */
+void USkycatchSubsystem::ProjectGroup(FOverlayGroup& Group)
+{
+	//Any site of the group can project the rings, they share the height of the sites
+	ASkycatchTerrain* Terrain = nullptr;
+	for (const TWeakObjectPtr<ASkycatchTerrain>& Site : Group.Sites)
+	{
+		if (Site.IsValid() && Site->GeoreferenceActor && Site->OutlineLongitudeLatitudeHeight.Num() > 0)
+		{
+			Terrain = Site.Get();
+			break;
+		}
+	}
+	if (!Terrain)
+	{
+		return;
+	}
+
+	const double Height = Terrain->OutlineLongitudeLatitudeHeight[0].Z;
+	for (int32 Index = 0; Index < Group.Rings.Num() && Index < Group.Polygons.Num(); Index++)
+	{
+		if (!Group.Polygons[Index].IsValid())
+		{
+			continue;
+		}
+
+		TArray<FVector> Ring;
+		Ring.Reserve(Group.Rings[Index].Num());
+		for (const FVector2D& Point : Group.Rings[Index])
+		{
+			Ring.Add(FVector(Point.X, Point.Y, Height));
+		}
+		Group.Polygons[Index]->Polygon->SetSplinePoints(Terrain->ProjectOutline(Ring), ESplineCoordinateSpace::World);
+	}
+}
+
+/**
+ * @brief Replaces the polygons previously submitted to the raster overlay with the current ones, and refreshes
+ * the world terrain once.
+ */
+void USkycatchSubsystem::CommitOverlay()
+{
+	if (!RasterOverlay.IsValid())
+	{
+		return;
+	}
+
+	//Collects the polygons of every group, merged or not
+	TArray<TWeakObjectPtr<ACesiumCartographicPolygon>> Polygons;
+	FSkycatchOverlayStats Stats;
+	for (const TPair<TWeakObjectPtr<ASkycatchTerrain>, FOverlaySite>& Site : OverlaySites)
+	{
+		Stats.InactiveSites += Site.Value.bActive ? 0 : 1;
+	}
+	for (const TPair<int32, FOverlayGroup>& Group : OverlayGroups)
+	{
+		Stats.Sites += Group.Value.Sites.Num();
+		if (Group.Value.Rings.Num() > 0)
+		{
+			Polygons.Append(Group.Value.Polygons);
+			continue;
+		}
+		for (const TWeakObjectPtr<ASkycatchTerrain>& Terrain : Group.Value.Sites)
+		{
+			if (Terrain.IsValid() && Terrain->CartographicPolygon)
+			{
+				Polygons.Add(Terrain->CartographicPolygon);
+			}
+		}
+	}
+
+	for (const TWeakObjectPtr<ACesiumCartographicPolygon>& Polygon : SubmittedPolygons)
+	{
+		RasterOverlay->Polygons.Remove(Polygon.Get());
+	}
+	for (const TWeakObjectPtr<ACesiumCartographicPolygon>& Polygon : Polygons)
+	{
+		if (Polygon.IsValid())
+		{
+			RasterOverlay->Polygons.AddUnique(Polygon.Get());
+			Stats.Polygons++;
+			Stats.Vertices += Polygon->Polygon->GetNumberOfSplinePoints();
+		}
+	}
+	SubmittedPolygons = MoveTemp(Polygons);
+
+	RequestOverlayRefresh();
+
+	if (Stats.Sites != OverlayStats.Sites || Stats.InactiveSites != OverlayStats.InactiveSites || Stats.Polygons != OverlayStats.Polygons || Stats.Vertices != OverlayStats.Vertices)
+	{
+		UE_LOG(LogSkycatch, Display, TEXT("Raster overlay: %d sites submitted as %d polygons with %d vertices, %d inactive sites"), Stats.Sites, Stats.Polygons, Stats.Vertices, Stats.InactiveSites);
+	}
+	OverlayStats = Stats;
+}
+
+/**
+ * @brief Asks for a refresh of the raster overlay. In game worlds the refresh waits for the refresh interval,
+ * so the changes made in between are applied together.
+ */
+void USkycatchSubsystem::RequestOverlayRefresh()
+{
+	const UWorld* World = GetWorld();
+	if (World && World->IsGameWorld())
+	{
+		bOverlayRefreshPending = true;
+		return;
+	}
+	RefreshOverlay();
+}
+
+/**
+ * @brief Refreshes the raster overlay with its current polygons. The world terrain tiles stay loaded, only the
+ * overlay is rasterized again.
+ */
+void USkycatchSubsystem::RefreshOverlay()
+{
+	bOverlayRefreshPending = false;
+	TimeSinceOverlayRefresh = 0.0f;
+	if (RasterOverlay.IsValid())
+	{
+		RasterOverlay->Refresh();
+	}
+}
+
+/**
+ * @brief Splits the Cesium cache size and tile load concurrency budgets across the Skycatch tilesets of the world
+ * by priority. Tilesets close to or seen by the player views get the largest shares.
+ */
+void USkycatchSubsystem::RebalanceTilesetBudgets()
+{
+	bTilesetBudgetsDirty = false;
+	TilesetMemory.Reset();
+
+	UWorld* World = GetWorld();
+	const USkycatchSettings* Settings = GetDefault<USkycatchSettings>();
+	if (!World || !Settings->bGovernTilesetMemory)
+	{
+		return;
+	}
+
+	//The warm captures keep the cache size of their own budget, only their loads are governed
+	const TArray<FPlayerView> Views = GetPlayerViews();
+	int64 AvailableBytes = Settings->TilesetMemoryBudgetBytes;
+	TArray<bool> GovernBytes;
+	for (TActorIterator<ASkycatchTerrain> It(World); It; ++It)
+	{
+		ASkycatchTerrain* Terrain = *It;
+
+		//Locates the site from its outline, or from the actor while the outline isn't known
+		FOverlaySite Site;
+		Site.Bounds = FBox2D(ForceInit);
+		for (const FVector& Point : Terrain->OutlineLongitudeLatitudeHeight)
+		{
+			Site.Bounds += FVector2D(Point);
+		}
+		Site.Location = Terrain->GetActorLocation();
+		LocateSite(Terrain, Site);
+
+		//The priority halves at the configured distance from the closest view, and grows when the site is seen
+		float Priority = 1.0f;
+		if (Views.Num() > 0)
+		{
+			double ClosestDistance = TNumericLimits<double>::Max();
+			bool bSeen = false;
+			for (const FPlayerView& View : Views)
+			{
+				const FVector ToSite = Site.Location - View.Location;
+				const double CenterDistance = ToSite.Size();
+				ClosestDistance = FMath::Min(ClosestDistance, FMath::Max(0.0, CenterDistance - Site.Radius));
+				if (CenterDistance <= Site.Radius)
+				{
+					bSeen = true;
+					continue;
+				}
+				const double Angle = FMath::Acos(FMath::Clamp(FVector::DotProduct(View.Direction, ToSite / CenterDistance), -1.0, 1.0));
+				bSeen |= Angle - FMath::Asin(FMath::Min(1.0, Site.Radius / CenterDistance)) <= View.HalfAngle;
+			}
+			Priority = static_cast<float>(1.0 / (1.0 + ClosestDistance / Settings->TilesetPriorityDistance));
+			Priority *= bSeen ? Settings->TilesetFocusPriority : 1.0f;
+		}
+
+		auto AddTileset = [&](ACesium3DTileset* Tileset, float Scale, bool bGovernBytes)
+		{
+			if (IsValid(Tileset))
+			{
+				FSkycatchTilesetMemory& Memory = TilesetMemory.AddDefaulted_GetRef();
+				Memory.Terrain = Terrain;
+				Memory.Tileset = Tileset;
+				Memory.Priority = Priority * Scale;
+				GovernBytes.Add(bGovernBytes);
+			}
+		};
+		//A tileset along a prewarmed path keeps the cache size of the prewarm until the path is played
+		const bool bPrewarmPinned = TilePrewarm.IsPinned(Terrain->Cesium3DTilesetActor);
+		if (bPrewarmPinned)
+		{
+			AvailableBytes -= Terrain->Cesium3DTilesetActor->MaximumCachedBytes;
+		}
+		AddTileset(Terrain->Cesium3DTilesetActor, Terrain->Cesium3DTilesetActorVisible ? 1.0f : BackgroundTilesetPriority, !bPrewarmPinned);
+		AddTileset(Terrain->PendingTilesetActor, 1.0f, true);
+		AddTileset(Terrain->CollisionTilesetActor, CollisionTilesetPriority, true);
+		for (ACesium3DTileset* WarmTileset : Terrain->WarmTilesets)
+		{
+			if (IsValid(WarmTileset))
+			{
+				AvailableBytes -= WarmTileset->MaximumCachedBytes;
+				AddTileset(WarmTileset, BackgroundTilesetPriority, false);
+			}
+		}
+	}
+
+	if (TilesetMemory.Num() == 0)
+	{
+		return;
+	}
+
+	//Every tileset keeps the minimum cache size, the rest of the budget is split by priority
+	int32 NumGoverned = 0;
+	double GovernedPriority = 0.0;
+	double TotalPriority = 0.0;
+	for (int32 Index = 0; Index < TilesetMemory.Num(); Index++)
+	{
+		NumGoverned += GovernBytes[Index] ? 1 : 0;
+		GovernedPriority += GovernBytes[Index] ? TilesetMemory[Index].Priority : 0.0;
+		TotalPriority += TilesetMemory[Index].Priority;
+	}
+	AvailableBytes = FMath::Max<int64>(0, AvailableBytes);
+	const int64 MinimumBytes = FMath::Min<int64>(Settings->MinimumTilesetBytes, NumGoverned > 0 ? AvailableBytes / NumGoverned : 0);
+	const int64 SharedBytes = AvailableBytes - MinimumBytes * NumGoverned;
+
+	int64 BudgetBytes = 0;
+	for (int32 Index = 0; Index < TilesetMemory.Num(); Index++)
+	{
+		FSkycatchTilesetMemory& Memory = TilesetMemory[Index];
+		if (GovernBytes[Index])
+		{
+			Memory.Tileset->MaximumCachedBytes = MinimumBytes + (GovernedPriority > 0.0 ? static_cast<int64>(SharedBytes * (Memory.Priority / GovernedPriority)) : SharedBytes / NumGoverned);
+		}
+		Memory.Tileset->MaximumSimultaneousTileLoads = FMath::Max(1, FMath::FloorToInt(Settings->TilesetLoadBudget *
+			(TotalPriority > 0.0 ? Memory.Priority / TotalPriority : 1.0 / TilesetMemory.Num())));
+		Memory.BudgetBytes = Memory.Tileset->MaximumCachedBytes;
+		Memory.SimultaneousTileLoads = Memory.Tileset->MaximumSimultaneousTileLoads;
+		Memory.ResidentBytes = GetResidentBytes(Memory.Tileset);
+		BudgetBytes += Memory.BudgetBytes;
+	}
+
+	UE_LOG(LogSkycatch, Verbose, TEXT("Tileset budgets: %d tilesets, %lld resident bytes of %lld budgeted"),
+		TilesetMemory.Num(), GetResidentTilesetBytes(), BudgetBytes);
+}
+
+/**
+ * @brief Returns the budgets given to the Skycatch tilesets of the world, with the bytes they currently use.
+ */
+TArray<FSkycatchTilesetMemory> USkycatchSubsystem::GetTilesetMemory() const
+{
+	TArray<FSkycatchTilesetMemory> Memory;
+	Memory.Reserve(TilesetMemory.Num());
+	for (const FSkycatchTilesetMemory& Tileset : TilesetMemory)
+	{
+		if (IsValid(Tileset.Tileset))
+		{
+			Memory.Add(Tileset).ResidentBytes = GetResidentBytes(Tileset.Tileset);
+		}
+	}
+	return Memory;
+}
+
+/**
+ * @brief Returns the bytes of the tiles of all the Skycatch tilesets of the world currently in memory.
+ */
+int64 USkycatchSubsystem::GetResidentTilesetBytes() const
+{
+	int64 ResidentBytes = 0;
+	for (const FSkycatchTilesetMemory& Tileset : TilesetMemory)
+	{
+		ResidentBytes += IsValid(Tileset.Tileset) ? GetResidentBytes(Tileset.Tileset) : 0;
+	}
+	return ResidentBytes;
+}
+
+/**
+ * @brief Returns the bytes of the tiles of a tileset currently in memory.
+ *
+ * @param Tileset as the tileset to measure
+ */
+int64 USkycatchSubsystem::GetResidentBytes(const ACesium3DTileset* Tileset)
+{
+	const Cesium3DTilesSelection::Tileset* NativeTileset = Tileset ? Tileset->GetTileset() : nullptr;
+	return NativeTileset ? NativeTileset->getTotalDataBytes() : 0;
+}
+
+/**
+ * @brief Finds the Skycatch site containing each of the given world locations, from the horizontal position of
+ * the locations against the projected outlines of the sites. Meant to be called every frame for many agents.
+ *
+ * @param Locations as the world locations to find
+ * @param OutSiteIds as the id of the site containing each location, or -1 when none does
+ */
+void USkycatchSubsystem::FindSitesAtLocations(const TArray<FVector>& Locations, TArray<int32>& OutSiteIds)
+{
+	OutSiteIds.SetNumUninitialized(Locations.Num());
+	FindSites(Locations, OutSiteIds);
+}
+
+/**
+ * @brief Finds the Skycatch site containing each of the given world locations, writing into a caller owned buffer.
+ *
+ * @param Locations as the world locations to find
+ * @param OutSiteIds as the id of the site containing each location, or INDEX_NONE, as many as the locations
+ */
+void USkycatchSubsystem::FindSites(TArrayView<const FVector> Locations, TArrayView<int32> OutSiteIds)
+{
+	if (bSiteIndexDirty)
+	{
+		RebuildSiteIndex();
+	}
+	SiteIndex.FindSites(Locations, OutSiteIds);
+}
+
+/**
+ * @brief Returns the id of the site of a Skycatch Terrain actor, which stays the same while the actor lives, or
+ * -1 when the actor has no outline.
+ *
+ * @param Terrain as the actor of the site
+ */
+int32 USkycatchSubsystem::GetSiteId(const ASkycatchTerrain* Terrain) const
+{
+	const int32* SiteId = SiteIds.Find(Terrain);
+	return SiteId ? *SiteId : INDEX_NONE;
+}
+
+/**
+ * @brief Returns the Skycatch Terrain actor of a site id, or null.
+ *
+ * @param SiteId as the id of the site
+ */
+ASkycatchTerrain* USkycatchSubsystem::GetSiteTerrain(int32 SiteId) const
+{
+	const TWeakObjectPtr<ASkycatchTerrain>* Terrain = SiteTerrains.Find(SiteId);
+	return Terrain ? Terrain->Get() : nullptr;
+}
+
+/**
+ * @brief Rebuilds the site index from the projected outlines of the registered Skycatch Terrain actors.
+ */
+void USkycatchSubsystem::RebuildSiteIndex()
+{
+	bSiteIndexDirty = false;
+	SiteIndex.Reset();
+
+	//Forgets the ids of the actors that are gone, the others keep theirs
+	for (auto It = SiteIds.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid() || !Terrains.Contains(It.Key()))
+		{
+			SiteTerrains.Remove(It.Value());
+			It.RemoveCurrent();
+		}
+	}
+
+	for (const TWeakObjectPtr<ASkycatchTerrain>& Terrain : Terrains)
+	{
+		if (!Terrain.IsValid() || !Terrain->GeoreferenceActor || Terrain->OutlineGeometry.NumRings() == 0)
+		{
+			continue;
+		}
+
+		//Every ring is added on its own, the index combines them with the even-odd rule
+		TArray<TArray<FVector2D>> Rings;
+		for (int32 Ring = 0; Ring < Terrain->OutlineGeometry.NumRings(); Ring++)
+		{
+			TArray<FVector2D>& Projected = Rings.AddDefaulted_GetRef();
+			for (const FVector2D& Point : Terrain->OutlineGeometry.GetRing(Ring))
+			{
+				const glm::dvec3 UECoords = Terrain->GeoreferenceActor->TransformLongitudeLatitudeHeightToUnreal(glm::dvec3(Point.X, Point.Y, 0.0));
+				Projected.Add(FVector2D(UECoords.x, UECoords.y));
+			}
+		}
+
+		int32& SiteId = SiteIds.FindOrAdd(Terrain, INDEX_NONE);
+		if (SiteId == INDEX_NONE)
+		{
+			SiteId = NextSiteId++;
+			SiteTerrains.Add(SiteId, Terrain);
+		}
+		SiteIndex.AddSite(SiteId, Rings);
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	SiteIndex.Build();
+	UE_LOG(LogSkycatch, Verbose, TEXT("Site index of %d sites built in %.2f ms"), SiteIndex.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+/**
+ * @brief Starts prewarming the tiles seen from the poses of a camera path, waiting on the Skycatch tilesets of
+ * the sites within the prewarm distance of the path. Cancels the prewarm running.
+ *
+ * @param Poses as the poses of the camera
+ * @param FieldOfView as the horizontal field of view of the camera, in degrees
+ * @param Resolution as the resolution the path is rendered at
+ * @param bWatchPlayback whether the path is played by a level sequence, whose playback is watched
+ * @param OnCompleted as the callback executed when the prewarm completes or is cancelled
+ */
+void USkycatchSubsystem::StartPrewarm(TArray<FTransform> Poses, float FieldOfView, FVector2D Resolution, bool bWatchPlayback, TFunction<void(const FSkycatchPrewarmStats&)> OnCompleted)
+{
+	const double SiteDistance = GetDefault<USkycatchSettings>()->PrewarmSiteDistance;
+
+	TArray<ACesium3DTileset*> Tilesets;
+	for (TActorIterator<ASkycatchTerrain> It(GetWorld()); It; ++It)
+	{
+		ASkycatchTerrain* Terrain = *It;
+		ACesium3DTileset* Tileset = Terrain->Cesium3DTilesetActor;
+		if (!Tileset || Tileset->IsHidden())
+		{
+			continue;
+		}
+
+		//Sites without an outline are located at their actor
+		FOverlaySite Site;
+		Site.Location = Terrain->GetActorLocation();
+		Site.Bounds = FBox2D(ForceInit);
+		for (const FVector& Point : Terrain->OutlineLongitudeLatitudeHeight)
+		{
+			Site.Bounds += FVector2D(Point.X, Point.Y);
+		}
+		LocateSite(Terrain, Site);
+
+		const bool bAlongPath = Poses.ContainsByPredicate([&Site, SiteDistance](const FTransform& Pose)
+		{
+			return FVector::Dist(Pose.GetLocation(), Site.Location) - Site.Radius <= SiteDistance;
+		});
+		if (bAlongPath)
+		{
+			Tilesets.Add(Tileset);
+		}
+	}
+
+	TilePrewarm.Start(GetWorld(), MoveTemp(Poses), Tilesets, FieldOfView, Resolution, bWatchPlayback, MoveTemp(OnCompleted));
+}
+
+/**
+ * @brief Stops the prewarm running and removes its cameras.
+ */
+void USkycatchSubsystem::CancelPrewarm()
+{
+	TilePrewarm.Cancel(GetWorld());
+}
+
+/**
+ * @brief Ends the last prewarm once its path was rendered, giving the cache size kept for its tilesets back to
+ * the memory governor.
+ */
+void USkycatchSubsystem::EndPrewarm()
+{
+	TilePrewarm.Cancel(GetWorld());
+}
+
+/**
+ * @brief Returns the stats of the last prewarm, including the loading of the playback that followed it.
+ */
+FSkycatchPrewarmStats USkycatchSubsystem::GetPrewarmStats() const
+{
+	return TilePrewarm.GetStats();
+}
+
+/**
+ * @brief Returns whether the commits of the resolved sites are spread over frames, which is the case in game
+ * worlds with a commit budget.
+ */
+bool USkycatchSubsystem::ShouldQueueCommits() const
+{
+	const UWorld* World = GetWorld();
+	return World && World->IsGameWorld() && GetDefault<USkycatchSettings>()->CommitBudgetMilliseconds > 0.0f;
+}
+
+/**
+ * @brief Queues the commit of a resolved site, or runs it to completion right away when commits are not queued.
+ *
+ * @param Terrain as the actor of the site, replacing its commit still queued
+ * @param Step as the step run until the commit is completed
+ * @param OnCancelled as the function called if the commit is cancelled or replaced before it is completed
+ */
+void USkycatchSubsystem::EnqueueCommit(ASkycatchTerrain* Terrain, FSkycatchCommitQueue::FStep Step, FSkycatchCommitQueue::FCancelled OnCancelled)
+{
+	if (!ShouldQueueCommits())
+	{
+		CommitQueue.Cancel(Terrain);
+		while (Step() != ESkycatchCommitStep::Completed)
+		{
+		}
+		return;
+	}
+	CommitQueue.Enqueue(Terrain, Terrain->GetActorLocation(), MoveTemp(Step), MoveTemp(OnCancelled));
+}
+
+/**
+ * @brief Drops the commit of a site still queued, reporting it as cancelled.
+ *
+ * @param Terrain as the actor of the site
+ */
+void USkycatchSubsystem::CancelCommit(const ASkycatchTerrain* Terrain)
+{
+	CommitQueue.Cancel(Terrain);
+}
+
+/**
+ * @brief Returns the time spent committing the resolved sites and the depth of the commit queue.
+ */
+FSkycatchCommitStats USkycatchSubsystem::GetCommitStats() const
+{
+	return CommitQueue.GetStats();
+}
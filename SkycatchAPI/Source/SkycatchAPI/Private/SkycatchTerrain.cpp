@@ -3,18 +3,27 @@
  * Including the Header libraries and files required
  **/
 #include "SkycatchTerrain.h"
-#include "HttpModule.h"
-#include "Interfaces/IHttpRequest.h"
-#include "Interfaces/IHttpResponse.h"
 #include "Cesium3DTileset.h"
+#include "Cesium3DTilesSelection/Tileset.h"
 #include "CesiumCartographicPolygon.h"
 #include "CesiumPolygonRasterOverlay.h"
 #include "Math/Vector.h"
 #include "Serialization/JsonReader.h"
 #include "Serialization/JsonSerializer.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "Hash/CityHash.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
 #include "SkycatchSettings.h"
+#include "SkycatchSubsystem.h"
+#include "SkycatchEndpoints.h"
+#include "SkycatchSiteCache.h"
 #include "Kismet/GameplayStatics.h"
+#include "GameFramework/PlayerController.h"
+#include "PhysicsEngine/BodySetup.h"
 #include "Logging/LogMacros.h"
+#include "Net/UnrealNetwork.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
 
 
 /**
@@ -28,6 +37,22 @@ ASkycatchTerrain::ASkycatchTerrain()
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
+
+	// The resolved site is replicated to clients so they don't look it up again. It is the only replicated property
+	// and only changes when the server resolves a new site, which forces a net update, so the low frequency costs
+	// nothing between resolutions
+	bReplicates = true;
+	bAlwaysRelevant = GetDefault<USkycatchSettings>()->bTerrainAlwaysRelevant;
+	NetUpdateFrequency = 2.0f;
+}
+
+int32 ASkycatchTerrain::LookupsAvoidedByReplication = 0;
+
+void ASkycatchTerrain::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ASkycatchTerrain, ReplicatedSite);
 }
 
 /**
@@ -36,6 +61,37 @@ ASkycatchTerrain::ASkycatchTerrain()
 void ASkycatchTerrain::BeginPlay()
 {
 	Super::BeginPlay();
+
+	//Actors placed in streamed levels or World Partition cells resolve their site as soon as they stream in,
+	//which is cheap when the lookup was already cached or prefetched
+	if (ResolveOnStreamIn && GeoreferenceActor)
+	{
+		RequestTilesetAtActorLocation();
+	}
+}
+
+/**
+ * @brief Called when the actor is removed from the world
+ * 
+ * @param EndPlayReason 
+ */
+void ASkycatchTerrain::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	//When the level or cell of the actor streams out, the spawned tilesets and polygon are released with it.
+	//The lookup stays in the site cache, so streaming in again does not hit the Skycatch services.
+	if (ReleaseOnStreamOut && EndPlayReason == EEndPlayReason::RemovedFromWorld)
+	{
+		UnloadTileset();
+	}
+
+	if (USkycatchSubsystem* Subsystem = GetWorld()->GetSubsystem<USkycatchSubsystem>())
+	{
+		Subsystem->CancelCommit(this);
+		Subsystem->WithdrawSitePolygon(this);
+		Subsystem->UnregisterTerrain(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 /**
@@ -46,6 +102,33 @@ void ASkycatchTerrain::BeginPlay()
 void ASkycatchTerrain::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
+
+	//Swaps the pending tileset once it reaches the configured load progress, without waiting for the full load
+	if (PendingTilesetActor && SwapLoadProgressThreshold < 100.0f)
+	{
+		const Cesium3DTilesSelection::Tileset* PendingTileset = PendingTilesetActor->GetTileset();
+		if (PendingTileset && PendingTileset->getRootTile() &&
+			PendingTilesetActor->GetLoadProgress() >= SwapLoadProgressThreshold)
+		{
+			SwapPendingTileset();
+		}
+	}
+
+	TimeSinceCollisionUpdate += DeltaTime;
+	if (TimeSinceCollisionUpdate >= GetDefault<USkycatchSettings>()->CollisionUpdateIntervalSeconds)
+	{
+		TimeSinceCollisionUpdate = 0.0f;
+		UpdateCollision();
+	}
+
+	//Unloaded tiles drop their cached heights, and the queries waiting for tiles are retried
+	TimeSinceHeightRetry += DeltaTime;
+	if (TimeSinceHeightRetry >= GetDefault<USkycatchSettings>()->HeightQueryRetryIntervalSeconds)
+	{
+		TimeSinceHeightRetry = 0.0f;
+		HeightCache.Prune();
+		ResolvePendingHeightQueries();
+	}
 }
 
 /**
@@ -107,112 +190,449 @@ void ASkycatchTerrain::PostEditChangeProperty(FPropertyChangedEvent& PropertyCha
 void ASkycatchTerrain::FindResource(FString Params, bool CalledFromEditor = false)
 {
 
+	//Every request gets a serial, so the listeners can tell which request a completion reports
+	const int32 RequestSerial = ++LastRequestSerial;
+
 	//Checks if there is a Georeference Actor selected, if not the process stops
 	if(GeoreferenceActor == nullptr)
 	{
 		UE_LOG(LogSkycatch, Error, TEXT("No Georeference Actor selected in SkycatchTerrain Actor"));
+		BroadcastRequestCompleted(RequestSerial, false);
 		return;
 	}
 	
-	FHttpModule& httpModule = FHttpModule::Get();
+	//Clients of a session get the site resolved by the server, so they never call the Skycatch services themselves.
+	//The request completes with the replicated site being shown, otherwise it fails as there is nothing to wait for
+	if (ReplicateSiteResolution && GetNetMode() == NM_Client)
+	{
+		UE_LOG(LogSkycatch, Verbose, TEXT("Lookup skipped on client, the site is resolved by the server"));
+		if (!bReplicatedSitePending)
+		{
+			const bool bShown = !ReplicatedSite.TilesetUrl.IsEmpty() && Cesium3DTilesetActor && IsSameUrl(ShownTilesetUrl, ReplicatedSite.TilesetUrl);
+			BroadcastRequestCompleted(RequestSerial, bShown);
+		}
+		return;
+	}
 
-	// Create an http request
-	// The request will execute asynchronously, and call us back on the Lambda below
-	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> pRequest = httpModule.CreateRequest();
+	// The lookup is answered from the site cache when possible, otherwise sent to the Skycatch services.
+	// The actor may stream out before the response arrives, so the callback is only run while it is alive.
+	FSkycatchSiteCache::Get().Lookup(Params, FOnSiteLookupCompleted::CreateWeakLambda(this,
+		[this, CalledFromEditor, RequestSerial](bool connectedSuccessfully, int32 ResponseCode, const FString& Content)
+	{
+		HandleResourceResponse(connectedSuccessfully, ResponseCode, Content, CalledFromEditor, RequestSerial);
+	}));
+}
 
-	// This is where we set the HTTP method (GET, POST, etc)
-	pRequest->SetVerb(TEXT("GET"));
+/**
+ * @brief Broadcasts the completion of a request.
+ *
+ * @param RequestSerial as the serial of the completed request
+ * @param bSuccess whether the tile of the request was shown
+ */
+void ASkycatchTerrain::BroadcastRequestCompleted(int32 RequestSerial, bool bSuccess)
+{
+	BroadcastRequestSerial = RequestSerial;
+	OnTilesetRequestCompleted.Broadcast(bSuccess, Cesium3DTilesetActor, CartographicPolygon);
+}
 
-	// We'll need to tell the server what type of content to expect in the GET data
-	pRequest->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
-	
-	
-	// Authorization header
-	pRequest->SetHeader(TEXT("SKYVERSE_KEY"), GetData(SkycatchSettings->SKYVERSE_KEY));;
+/**
+ * @brief Function that parses the response of a site lookup and continues the process of rendering.
+ * 
+ * @param connectedSuccessfully whether the Skycatch services could be reached
+ * @param ResponseCode as the HTTP response code
+ * @param Content as the content of the response
+ * @param CalledFromEditor whether the polygon has to be registered immediately
+ * @param RequestSerial as the serial of the request the response answers
+ */
+void ASkycatchTerrain::HandleResourceResponse(bool connectedSuccessfully, int32 ResponseCode, const FString& Content, bool CalledFromEditor, int32 RequestSerial)
+{
+	if (connectedSuccessfully) {
 
+		// We should have a JSON response - attempt to process it.
+		HttpData = Content;
 
-	FString ENDPOINT = GetData(SkycatchSettings->SKYVERSE_ENDPOINT);
-	const FString URL = ENDPOINT.Append(Params);
+		// We got an OK response from tendpoint, attempt to parse
+		if (ResponseCode == 200)
+		{
+			TArray<TSharedPtr<FJsonValue>> Tiles;
+			const TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(HttpData);
+			FJsonSerializer::Deserialize(JsonReader, Tiles);
+			if(Tiles.Num()>0)
+			{
+				//Keeps every capture of the site sorted by capture date. The site cache ranked the tiles, so the first
+				//one is the site that contains the point, or the closest one, and stays selected
+				const TSharedPtr<FJsonObject> FirstTile = Tiles[0]->AsObject();
+				SiteCaptures.Reset(Tiles.Num());
+				for (const TSharedPtr<FJsonValue>& Tile : Tiles)
+				{
+					if (Tile.IsValid() && Tile->AsObject().IsValid())
+					{
+						SiteCaptures.Add(Tile->AsObject());
+					}
+				}
+				SiteCaptures.StableSort([](const TSharedPtr<FJsonObject>& A, const TSharedPtr<FJsonObject>& B)
+				{
+					return GetTileCaptureDate(A) < GetTileCaptureDate(B);
+				});
+				ActiveCaptureIndex = SiteCaptures.IndexOfByKey(FirstTile);
 
-	UE_LOG(LogSkycatch, Warning, TEXT("Full URL: %s"), *URL);
-	
-	// Set the http URL
-	pRequest->SetURL(URL);
+				//Calls the function that renders the requested tileset and its polygon. The commit may be spread over
+				//the next frames, so the listeners are notified once it is completed, or cancelled by a newer request
+				ShowTile(FirstTile, CalledFromEditor, [this, RequestSerial](bool bShown)
+				{
+					if (bShown)
+					{
+						RefreshWarmCaptures();
+					}
+					BroadcastRequestCompleted(RequestSerial, bShown);
+				});
+				return;
+			}else
+			{
+				//If there is not tiles, prints an error
+				UE_LOG(LogSkycatch, Error, TEXT("No tiles found"));				
+			}
+		}
+
+		if (ResponseCode == 401)
+		{
+			UE_LOG(LogSkycatch, Error, TEXT("Invalid endpoint credentials. Please check that the Skyverse Key is correctly set in the project settings"));
+		}
+
+		if (ResponseCode == 404) 
+		{
+			UE_LOG(LogSkycatch, Error, TEXT("Endpoint not found. Please check that the Skyverse Endpoint is correctly set in the project settings"));
+		}
+	}
+	else {
+		//If there is an error in the connection to Skycatch services, sends an error
+		UE_LOG(LogSkycatch, Error, TEXT("Connection failed."));
+	}
+	BroadcastRequestCompleted(RequestSerial, false);
+}
+
+/**
+ * @brief Function that shows a tile from the Skycatch services response, rebuilding only the tileset and the polygon
+ * parts that differ from what is currently shown. In game worlds the commit is split in steps queued in the
+ * subsystem, so the sites that resolve together are committed over several frames.
+ * 
+ * @param Tile as the json object of the tile to show
+ * @param CalledFromEditor whether the polygon has to be registered immediately
+ * @param OnShown as the callback executed once the tile is shown, or with false if the commit is cancelled or
+ * replaced by another tile before
+ */
+void ASkycatchTerrain::ShowTile(const TSharedPtr<FJsonObject>& Tile, bool CalledFromEditor, TFunction<void(bool)> OnShown)
+{
+	SelectedTile = Tile;
+	//Parse the tileset url from the response
+	FString TilesetUrl = SelectedTile->GetStringField("tilesetUrl");
 
+	//Compares the response with what is currently shown, so only the parts that changed are rebuilt
+	const uint64 OutlineHash = HashTileOutline(SelectedTile);
+	const bool bTilesetChanged = Cesium3DTilesetActor == nullptr || !IsSameUrl(TilesetUrl, ShownTilesetUrl);
+	const bool bOutlineChanged = CartographicPolygon == nullptr || OutlineHash != ShownOutlineHash;
 
-	// Set the callback, which will execute when the HTTP call is complete
-	pRequest->OnProcessRequestComplete().BindLambda(
-		// Here, we "capture" the 'this' pointer (the "&"), so our lambda can call this
-		// class's methods in the callback.
-		[&, CalledFromEditor](
-			FHttpRequestPtr pRequest,
-			FHttpResponsePtr pResponse,
-			bool connectedSuccessfully) mutable {
+	USkycatchSubsystem* Subsystem = GetWorld() ? GetWorld()->GetSubsystem<USkycatchSubsystem>() : nullptr;
+	const bool bQueued = Subsystem && !CalledFromEditor && Subsystem->ShouldQueueCommits();
 
-		bool bRequestSuccess = false;
-		if (connectedSuccessfully) {
+	//State of the commit kept between its steps
+	struct FTileCommit
+	{
+		int32 Stage = 0;
+		FSkycatchOutline Outline;
+		bool bHasOutline = false;
+		TFuture<TOptional<FSkycatchOutline>> ParsedOutline;
+		TArray<FVector> SplinePoints;
+	};
+	const TSharedRef<FTileCommit> Commit = MakeShared<FTileCommit>();
+	const int32 ChunkPoints = GetDefault<USkycatchSettings>()->CommitChunkPoints;
+
+	//The rings of the outline are parsed and bridged on a worker thread while the commit waits in the queue
+	if (bOutlineChanged && bQueued)
+	{
+		Commit->ParsedOutline = Async(EAsyncExecution::ThreadPool, [Tile]()
+		{
+			FSkycatchOutline Outline;
+			return ParseTileOutline(Tile, Outline) ? TOptional<FSkycatchOutline>(MoveTemp(Outline)) : TOptional<FSkycatchOutline>();
+		});
+	}
+	else if (bOutlineChanged)
+	{
+		Commit->bHasOutline = ParseTileOutline(Tile, Commit->Outline);
+	}
 
-			// We should have a JSON response - attempt to process it.
-			HttpData = pResponse->GetContentAsString();
-			auto ResponseCode = pResponse->GetResponseCode();
+	FSkycatchCommitQueue::FStep Step = [this, Commit, TilesetUrl, OutlineHash, bTilesetChanged, bOutlineChanged, CalledFromEditor, ChunkPoints, OnShown]()
+	{
+		switch (Commit->Stage)
+		{
+		case 0:
+			if (bTilesetChanged)
+			{
+				//Calls the function that renders the requested tileset
+				RenderResource(TilesetUrl);
+				ShownTilesetUrl = TilesetUrl;
+			}
+			else
+			{
+				UE_LOG(LogSkycatch, Display, TEXT("Tileset already shown, skipping reload"));
+			}
+			Commit->Stage = bOutlineChanged ? 1 : 4;
+			return ESkycatchCommitStep::Continue;
 
-			// We got an OK response from tendpoint, attempt to parse
-			if (ResponseCode == 200)
+		case 1:
+			if (Commit->ParsedOutline.IsValid())
 			{
-				TArray<TSharedPtr<FJsonValue>> Tiles;
-				const TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(HttpData);
-				FJsonSerializer::Deserialize(JsonReader, Tiles);
-				if(Tiles.Num()>0)
+				if (!Commit->ParsedOutline.IsReady())
 				{
-					//Selects the first tileset from the response
-					SelectedTile = Tiles[0]->AsObject();
-					//Parse the tileset url from the response
-					FString TilesetUrl = SelectedTile->GetStringField("tilesetUrl");
-					//Calls the function that renders the requested tileset
-					RenderResource(TilesetUrl);
-					SpawnCartographicPolygon();
-
-					// When called from editor, the OnTilesetLoaded callback is not processed, so we immediately register the polygon
-					if (CalledFromEditor)
-					{
-						// When called from editor, always register the polygon as raster overlay
-						RenderRasterOverlay();
-					}
+					return ESkycatchCommitStep::Wait;
+				}
+				const TOptional<FSkycatchOutline>& Parsed = Commit->ParsedOutline.Get();
+				Commit->bHasOutline = Parsed.IsSet();
+				if (Parsed.IsSet())
+				{
+					Commit->Outline = Parsed.GetValue();
+				}
+				Commit->ParsedOutline.Reset();
+			}
+			Commit->Stage = Commit->bHasOutline ? 2 : 4;
+			return ESkycatchCommitStep::Continue;
 
-					bRequestSuccess = true;
-				}else
+		case 2:
+			//The outline of a site loading in the secondary tileset is projected when both are swapped
+			if (!PendingTilesetActor && GeoreferenceActor)
+			{
+				//Large outlines are projected over several steps
+				const TArray<FVector>& Outline = Commit->Outline.GetLongitudeLatitudeHeight();
+				const int32 First = Commit->SplinePoints.Num();
+				const int32 Last = FMath::Min(First + ChunkPoints, Outline.Num());
+				Commit->SplinePoints.Reserve(Outline.Num());
+				for (int32 Index = First; Index < Last; Index++)
+				{
+					const FVector& Point = Outline[Index];
+					const glm::dvec3 UECoords = GeoreferenceActor->TransformLongitudeLatitudeHeightToUnreal(glm::dvec3(Point.X, Point.Y, Point.Z));
+					Commit->SplinePoints.Add(FVector(UECoords.x, UECoords.y, UECoords.z));
+				}
+				if (Last < Outline.Num())
 				{
-					//If there is not tiles, prints an error
-					UE_LOG(LogSkycatch, Error, TEXT("No tiles found"));				
+					return ESkycatchCommitStep::Continue;
 				}
 			}
+			Commit->Stage = 3;
+			return ESkycatchCommitStep::Continue;
+
+		case 3:
+			SpawnCartographicPolygon(MoveTemp(Commit->Outline), MoveTemp(Commit->SplinePoints));
+			Commit->Stage = 4;
+			return ESkycatchCommitStep::Continue;
+
+		default:
+			if (bOutlineChanged)
+			{
+				ShownOutlineHash = CartographicPolygon ? OutlineHash : 0;
+			}
 
-			if (ResponseCode == 401)
+			// When called from editor, the OnTilesetLoaded callback is not processed, so we immediately register the polygon
+			if (CalledFromEditor)
+			{
+				// When called from editor, always register the polygon as raster overlay
+				RenderRasterOverlay();
+			}
+			else if (bOutlineChanged && AutoRegisterPolygon && (!bTilesetChanged || IsPolygonRegistered()))
 			{
-				UE_LOG(LogSkycatch, Error, TEXT("Invalid endpoint credentials. Please check that the Skyverse Key is correctly set in the project settings"));
+				// OnTilesetLoaded won't register a new outline (the tileset was not reloaded, or the polygon is already
+				// registered), so the new outline is submitted now
+				RenderRasterOverlay();
 			}
 
-			if (ResponseCode == 404) 
+			UpdateReplicatedSite();
+			if (OnShown)
 			{
-				UE_LOG(LogSkycatch, Error, TEXT("Endpoint not found. Please check that the Skyverse Endpoint is correctly set in the project settings"));
+				OnShown(true);
 			}
+			return ESkycatchCommitStep::Completed;
+		}
+	};
+
+	if (bQueued)
+	{
+		//A commit cancelled or replaced before it is completed reports its tile as not shown
+		FSkycatchCommitQueue::FCancelled OnCancelled;
+		if (OnShown)
+		{
+			OnCancelled = [OnShown]()
+			{
+				OnShown(false);
+			};
 		}
-		else {
-			//If there is an error in the connection to Skycatch services, sends an error
-			switch (pRequest->GetStatus()) {
-			case EHttpRequestStatus::Failed_ConnectionError:
-				UE_LOG(LogSkycatch, Error, TEXT("Connection failed."));
-			default:
-				UE_LOG(LogSkycatch, Error, TEXT("Request failed."));
+		Subsystem->EnqueueCommit(this, MoveTemp(Step), MoveTemp(OnCancelled));
+		return;
+	}
+	if (Subsystem)
+	{
+		Subsystem->CancelCommit(this);
+	}
+	while (Step() != ESkycatchCommitStep::Completed)
+	{
+	}
+}
+
+/**
+ * @brief Updates the replicated payload from the site shown on the server.
+ */
+void ASkycatchTerrain::UpdateReplicatedSite()
+{
+	if (!ReplicateSiteResolution || !HasAuthority() || GetNetMode() == NM_Standalone)
+	{
+		return;
+	}
+
+	ReplicatedSite.TilesetUrl = SelectedTile.IsValid() ? SelectedTile->GetStringField("tilesetUrl") : FString();
+	//Every ring is replicated rather than the bridged one, so the clients keep the holes and the parts of the site
+	const FSkycatchOutline& Outline = bHasPendingOutline ? PendingOutline : OutlineGeometry;
+	TArray<TArray<TArray<FVector2D>>> Parts;
+	for (int32 Part = 0; Part < Outline.NumParts(); Part++)
+	{
+		Parts.Add(Outline.GetPartRings(Part));
+	}
+	ReplicatedSite.Outline = FSkycatchSitePayload::EncodeOutline(Parts);
+	ForceNetUpdate();
+}
+
+/**
+ * @brief Called on clients when the server resolved a new site, builds the tileset and the polygon from the
+ * replicated payload.
+ */
+void ASkycatchTerrain::OnRep_ReplicatedSite()
+{
+	if (ReplicatedSite.TilesetUrl.IsEmpty())
+	{
+		UnloadTileset();
+		return;
+	}
+
+	if (!GeoreferenceActor)
+	{
+		UE_LOG(LogSkycatch, Error, TEXT("No Georeference Actor selected in SkycatchTerrain Actor"));
+		return;
+	}
+
+	TArray<TArray<TArray<FVector2D>>> Parts;
+	if (!FSkycatchSitePayload::DecodeOutline(ReplicatedSite.Outline, Parts))
+	{
+		UE_LOG(LogSkycatch, Error, TEXT("Invalid replicated site outline"));
+		return;
+	}
+
+	//Rebuilds the tile json as it comes from Skycatch services, so the replicated site follows the same path
+	auto MakePosition = [](const FVector2D& Point)
+	{
+		TArray<TSharedPtr<FJsonValue>> Coords;
+		Coords.Add(MakeShared<FJsonValueNumber>(Point.X));
+		Coords.Add(MakeShared<FJsonValueNumber>(Point.Y));
+		return MakeShared<FJsonValueArray>(Coords);
+	};
+	TArray<TSharedPtr<FJsonValue>> Polygons;
+	for (const TArray<TArray<FVector2D>>& Rings : Parts)
+	{
+		TArray<TSharedPtr<FJsonValue>> Polygon;
+		for (const TArray<FVector2D>& Ring : Rings)
+		{
+			TArray<TSharedPtr<FJsonValue>> Positions;
+			for (const FVector2D& Point : Ring)
+			{
+				Positions.Add(MakePosition(Point));
 			}
+			if (Ring.Num() > 0)
+			{
+				Positions.Add(MakePosition(Ring[0]));
+			}
+			Polygon.Add(MakeShared<FJsonValueArray>(Positions));
 		}
-		OnTilesetRequestCompleted.Broadcast(bRequestSuccess, Cesium3DTilesetActor, CartographicPolygon);
-	});
+		Polygons.Add(MakeShared<FJsonValueArray>(Polygon));
+	}
 
-	// Finally, submit the request for processing
-	pRequest->ProcessRequest();
+	const TSharedPtr<FJsonObject> Geometry = MakeShared<FJsonObject>();
+	Geometry->SetStringField(TEXT("type"), TEXT("MultiPolygon"));
+	Geometry->SetArrayField(TEXT("coordinates"), Polygons);
+
+	const TSharedPtr<FJsonObject> Tile = MakeShared<FJsonObject>();
+	Tile->SetStringField(TEXT("tilesetUrl"), ReplicatedSite.TilesetUrl);
+	Tile->SetObjectField(TEXT("outline"), Geometry);
+
+	SiteCaptures.Reset();
+	SiteCaptures.Add(Tile);
+	ActiveCaptureIndex = 0;
+	LookupsAvoidedByReplication++;
+	//The replicated site answers the last request the client made until it is shown
+	bReplicatedSitePending = true;
+	ShowTile(Tile, false, [this](bool bShown)
+	{
+		bReplicatedSitePending = false;
+		BroadcastRequestCompleted(LastRequestSerial, bShown);
+	});
 }
 
+/**
+ * @brief Checks on a client (a PIE client or a connected game) that every terrain with a replicated site shows it, and
+ * that its lookup was avoided. Usage: Skycatch.CheckReplication
+ */
+static FAutoConsoleCommandWithWorldAndArgs CheckReplicationCommand(
+	TEXT("Skycatch.CheckReplication"),
+	TEXT("Checks that the sites replicated by the server are shown on this client without lookups. Usage: Skycatch.CheckReplication"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World || World->GetNetMode() != NM_Client)
+		{
+			UE_LOG(LogSkycatch, Warning, TEXT("Replication check: run it on a client, the sites are resolved locally here"));
+			return;
+		}
+
+		int32 Replicated = 0;
+		int32 Failed = 0;
+		for (TActorIterator<ASkycatchTerrain> It(World); It; ++It)
+		{
+			const ASkycatchTerrain* Terrain = *It;
+			if (!Terrain->ReplicateSiteResolution || Terrain->ReplicatedSite.TilesetUrl.IsEmpty())
+			{
+				continue;
+			}
+
+			Replicated++;
+			//The outline applied on this client keeps every ring of the replicated one
+			TArray<TArray<TArray<FVector2D>>> Parts;
+			const bool bDecoded = FSkycatchSitePayload::DecodeOutline(Terrain->ReplicatedSite.Outline, Parts);
+			int32 Rings = 0;
+			int32 Points = 0;
+			for (const TArray<TArray<FVector2D>>& Part : Parts)
+			{
+				Rings += Part.Num();
+				for (const TArray<FVector2D>& Ring : Part)
+				{
+					Points += Ring.Num();
+				}
+			}
+			const FSkycatchOutline& Applied = Terrain->bHasPendingOutline ? Terrain->PendingOutline : Terrain->OutlineGeometry;
+			const bool bShown = Terrain->Cesium3DTilesetActor && ASkycatchTerrain::IsSameUrl(Terrain->ShownTilesetUrl, Terrain->ReplicatedSite.TilesetUrl);
+			const bool bOutline = Applied.NumParts() == Parts.Num() && Applied.NumRings() == Rings;
+			if (!bDecoded || !bShown || !bOutline)
+			{
+				Failed++;
+			}
+			UE_LOG(LogSkycatch, Display, TEXT("Replication check: %s %s, %d outline points in %d rings and %d bytes, tileset %s, outline %s"),
+				bDecoded && bShown && bOutline ? TEXT("ok") : TEXT("FAILED"), *Terrain->GetName(), Points, Rings, Terrain->ReplicatedSite.Outline.Num(),
+				bShown ? TEXT("shown") : TEXT("not shown"), bOutline ? TEXT("applied") : TEXT("missing"));
+		}
+
+		//Every replicated site shown on this client was built without a lookup of its own
+		const int32 Avoided = ASkycatchTerrain::GetLookupsAvoidedByReplication();
+		if (Avoided < Replicated - Failed)
+		{
+			Failed++;
+		}
+		UE_LOG(LogSkycatch, Display, TEXT("Replication check: %s, %d replicated sites, %d lookups avoided by replication"),
+			Failed == 0 ? TEXT("passed") : TEXT("FAILED"), Replicated, Avoided);
+	}));
+
 /**
  * @brief Function that receives and string url from the fetched tileset and instantiates or updates the current
  * tileset from the actor.
@@ -221,328 +641,1167 @@ void ASkycatchTerrain::FindResource(FString Params, bool CalledFromEditor = fals
  */
 void ASkycatchTerrain::RenderResource(FString url)
 {
+	//A neighbouring capture that is kept warm is promoted instead of loading the tileset again
+	if (ACesium3DTileset* WarmTileset = FindWarmTileset(url))
+	{
+		WarmTilesets.Remove(WarmTileset);
+		CancelPendingTileset();
+
+		WarmTileset->MaximumCachedBytes = GetDefault<ACesium3DTileset>()->MaximumCachedBytes;
+		PendingTilesetActor = WarmTileset;
+		PendingTilesetLoadedListener.BindUFunction(this, "PendingTilesetLoadedSwap");
+		PendingTilesetActor->OnTilesetLoaded.Add(PendingTilesetLoadedListener);
+
+		//With double buffering a warm tileset that is still loading swaps in once it is ready, otherwise right away
+		const bool bWarmTilesetReady = WarmTileset->GetLoadProgress() >= 100.0f;
+		if (!DoubleBufferedSwap || !Cesium3DTilesetActor || bWarmTilesetReady)
+		{
+			SwapPendingTileset();
+		}
+		UE_LOG(LogSkycatch, Display, TEXT("Response %s (promoted warm capture)"), *url);
+		return;
+	}
+
+	//With double buffering, a new site loads into the hidden secondary tileset while the current one stays visible
+	const UWorld* World = GetWorld();
+	if (DoubleBufferedSwap && Cesium3DTilesetActor && World && World->IsGameWorld())
+	{
+		//Requesting the site that is already shown again just drops whatever was loading
+		if (IsSameUrl(Cesium3DTilesetActor->GetUrl(), url))
+		{
+			CancelPendingTileset();
+			return;
+		}
+
+		if (!PendingTilesetActor)
+		{
+			PendingTilesetActor = SpawnSkycatchTileset();
+
+			//Listen to the pending tileset on loaded event to swap it in
+			PendingTilesetLoadedListener.BindUFunction(this, "PendingTilesetLoadedSwap");
+			PendingTilesetActor->OnTilesetLoaded.Add(PendingTilesetLoadedListener);
+		}
+
+		PendingTilesetActor->SetActorHiddenInGame(true);
+		PendingTilesetActor->SetGeoreference(GeoreferenceActor);
+		PendingTilesetActor->SetTilesetSource(ETilesetSource::FromUrl);
+		PendingTilesetActor->SetUrl(url);
+		UE_LOG(LogSkycatch, Display, TEXT("Response %s (loading in secondary tileset)"), *url);
+		return;
+	}
+
 	//Checks if the global Cesium3DTilesetActor is already instantiated
 	if (!Cesium3DTilesetActor)
 	{
 		//If not, instantiates a new Cesium3DTilesetActor and sets the required properties
-		const FVector Location = FVector(0,0,0);
-		const FRotator Rotation = FRotator(0,0,0);
-		Cesium3DTilesetActor = GetWorld()->SpawnActor<ACesium3DTileset>(Location, Rotation);
-		this->Children.Add(Cesium3DTilesetActor);
-		Cesium3DTilesetActor->Tags.Add(FName("Skycatch"));
-		
-		// Change tileset configuration
-		Cesium3DTilesetActor->SetEnableOcclusionCulling(false);
-		Cesium3DTilesetActor->MaximumScreenSpaceError = 16.0;
+		Cesium3DTilesetActor = SpawnSkycatchTileset();
+
+		//Listen to the tileset on loaded event
+		CesiumTilesetLoadedListener.BindUFunction(this, "CesiumTilesetLoadedForwardBroadcast");
+		Cesium3DTilesetActor->OnTilesetLoaded.Add(CesiumTilesetLoadedListener);
+	}
+	
+	//If the actor exists, updates the actor properties to the new response from Skycatch services
+	Cesium3DTilesetActor->SetGeoreference(GeoreferenceActor);
+	Cesium3DTilesetActor->SetTilesetSource(ETilesetSource::FromUrl);
+	Cesium3DTilesetActor->SetUrl(url);
+	UE_LOG(LogSkycatch, Display, TEXT("Response %s"), *url);
+}
+
+/**
+ * @brief Spawns a Cesium3DTileset actor owned by this actor with the configuration used for Skycatch tilesets.
+ */
+ACesium3DTileset* ASkycatchTerrain::SpawnSkycatchTileset()
+{
+	const FVector Location = FVector(0,0,0);
+	const FRotator Rotation = FRotator(0,0,0);
+	ACesium3DTileset* Tileset = GetWorld()->SpawnActor<ACesium3DTileset>(Location, Rotation);
+	this->Children.Add(Tileset);
+	Tileset->Tags.Add(FName("Skycatch"));
+	
+	// Change tileset configuration
+	Tileset->SetEnableOcclusionCulling(false);
+	Tileset->MaximumScreenSpaceError = 16.0;
+	// Only the Full policy builds physics meshes for the shown tiles, the others use a collision tileset
+	Tileset->SetCreatePhysicsMeshes(GetEffectiveCollisionPolicy() == ESkycatchCollisionPolicy::Full);
+
+	// The cache size and load concurrency of the new tileset are given by the memory governor
+	if (USkycatchSubsystem* Subsystem = GetWorld()->GetSubsystem<USkycatchSubsystem>())
+	{
+		Subsystem->InvalidateTilesetBudgets();
+	}
+
+	return Tileset;
+}
+
+/**
+ * @brief Parses every ring of the geojson Polygon or MultiPolygon outline of a tile from the Skycatch services
+ * response, and bridges them into the single ring of the polygon. Returns false when the tile has no outline.
+ * Can run on any thread.
+ *
+ * @param Tile as the json object of the tile
+ * @param OutOutline as the outline of the tile
+ */
+bool ASkycatchTerrain::ParseTileOutline(const TSharedPtr<FJsonObject>& Tile, FSkycatchOutline& OutOutline)
+{
+	//Parses the response from the current tile fetched from Skycatch services
+	const TSharedPtr<FJsonObject>* Outline = nullptr;
+	if (!Tile.IsValid() || !Tile->TryGetObjectField(TEXT("outline"), Outline) || !OutOutline.Parse(*Outline))
+	{
+		UE_LOG(LogSkycatch, Error, TEXT("Tileset outline polygon not found."));
+		return false;
+	}
+
+	//Holes and extra parts are bridged into one ring, so the site is still a single polygon in the raster overlay
+	OutOutline.Build();
+	if (OutOutline.NumRings() > 1)
+	{
+		UE_LOG(LogSkycatch, Verbose, TEXT("Outline of %d parts and %d rings bridged into %d points"), OutOutline.NumParts(), OutOutline.NumRings(), OutOutline.GetLongitudeLatitudeHeight().Num());
+	}
+	return true;
+}
+
+/**
+ * @brief Function that instantiates the CesiumCartographicPolygon of the site if needed and sets its outline, or
+ * keeps the outline until the site loading in the secondary tileset is swapped in.
+ *
+ * @param Outline as the outline of the site
+ * @param SplinePoints as the bridged ring of the outline already projected to Unreal coordinates, or empty to
+ * project it
+ */
+void ASkycatchTerrain::SpawnCartographicPolygon(FSkycatchOutline Outline, TArray<FVector> SplinePoints)
+{
+	const FVector Location = FVector(0, 0, 0);
+	const FRotator Rotation = FRotator(0, 0, 0);
+
+	//Gets a reference to the world terrain actor
+	if (const UWorld* World = GetWorld())
+	{
+		WorldTerrain = UGameplayStatics::GetActorOfClass(World, ACesium3DTileset::StaticClass());
+	}
+
+	//Checks if already exists a cartographic polygon, if not instantiates a new CesiumCartographicPolygon
+	if (CartographicPolygon == nullptr)
+	{
+		CartographicPolygon = GetWorld()->SpawnActor<ACesiumCartographicPolygon>(Location, Rotation);
+		this->Children.Add(CartographicPolygon);
+		CartographicPolygon->Tags.Add(FName("Skycatch"));
+	}
+
+	//While a site is loading in the secondary tileset, the outline is kept until both are swapped together
+	if (PendingTilesetActor)
+	{
+		PendingOutline = MoveTemp(Outline);
+		bHasPendingOutline = true;
+		return;
+	}
+
+	ApplyOutline(MoveTemp(Outline), MoveTemp(SplinePoints));
+}
+
+/**
+ * @brief Sets the outline of the CartographicPolygon and keeps its geodetic coordinates, so the polygon can be
+ * re-projected when the georeference changes.
+ *
+ * @param Outline as the outline of the site
+ * @param SplinePoints as the bridged ring of the outline already projected to Unreal coordinates, or empty to
+ * project it
+ */
+void ASkycatchTerrain::ApplyOutline(FSkycatchOutline Outline, TArray<FVector> SplinePoints)
+{
+	OutlineGeometry = MoveTemp(Outline);
+	OutlineLongitudeLatitudeHeight = OutlineGeometry.GetLongitudeLatitudeHeight();
+	if (SplinePoints.Num() != OutlineLongitudeLatitudeHeight.Num())
+	{
+		SplinePoints = ProjectOutline(OutlineLongitudeLatitudeHeight);
+	}
+
+	//Sets the polygon of the CesiumCartographicPolygon, the projected points are in world space
+	CartographicPolygon->Polygon->SetSplinePoints(SplinePoints, ESplineCoordinateSpace::World);
+
+	//Registers the actor to have its polygon re-projected when the georeference changes
+	if (USkycatchSubsystem* Subsystem = GetWorld()->GetSubsystem<USkycatchSubsystem>())
+	{
+		Subsystem->RegisterTerrain(this);
+	}
+}
+
+/**
+ * @brief Transforms an outline in longitude, latitude and height to UE world coordinates using the GeoreferenceActor.
+ *
+ * @param LongitudeLatitudeHeight as the outline to transform
+ */
+TArray<FVector> ASkycatchTerrain::ProjectOutline(const TArray<FVector>& LongitudeLatitudeHeight) const
+{
+	TArray<FVector> SplinePoints;
+	SplinePoints.Reserve(LongitudeLatitudeHeight.Num());
+	for (const FVector& Point : LongitudeLatitudeHeight)
+	{
+		//Transforms the longitude, latitude to UE world coordinates
+		const glm::dvec3 UECoords = GeoreferenceActor->TransformLongitudeLatitudeHeightToUnreal(glm::dvec3(Point.X, Point.Y, Point.Z));
+		//Adds the coordinate to the vector to create the cartographic polygon
+		SplinePoints.Add(FVector(UECoords.x, UECoords.y, UECoords.z));
+	}
+	return SplinePoints;
+}
+
+/**
+ * @brief Re-projects the shown polygon from its kept geodetic outline, without refreshing the world terrain.
+ * Returns whether the polygon is registered in the world terrain, so the caller has to refresh it.
+ */
+bool ASkycatchTerrain::ReprojectOutline()
+{
+	if (!CartographicPolygon || !GeoreferenceActor || OutlineLongitudeLatitudeHeight.Num() == 0)
+	{
+		return false;
+	}
+
+	CartographicPolygon->Polygon->SetSplinePoints(ProjectOutline(OutlineLongitudeLatitudeHeight), ESplineCoordinateSpace::World);
+	return IsPolygonRegistered();
+}
+
+/**
+ * @brief Returns whether the outline of the site is currently submitted to the world terrain raster overlay, either
+ * as the CartographicPolygon or merged with the outlines of the adjacent sites.
+ */
+bool ASkycatchTerrain::IsPolygonRegistered() const
+{
+	const USkycatchSubsystem* Subsystem = GetWorld() ? GetWorld()->GetSubsystem<USkycatchSubsystem>() : nullptr;
+	return CartographicPolygon && Subsystem && Subsystem->IsSiteSubmitted(this);
+}
+
+/**
+ * @brief Computes a 64 bits content hash of the geojson outline of a tile from the Skycatch services response.
+ * Returns 0 when the tile has no outline.
+ *
+ * @param Tile as the json object of the tile
+ */
+uint64 ASkycatchTerrain::HashTileOutline(const TSharedPtr<FJsonObject>& Tile)
+{
+	const TSharedPtr<FJsonObject>* Outline = nullptr;
+	if (!Tile.IsValid() || !Tile->TryGetObjectField(TEXT("outline"), Outline) || !Outline->IsValid())
+	{
+		return 0;
+	}
+
+	//Serializes the outline without whitespace so equal geometries always produce the same string
+	FString OutlineString;
+	const TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> JsonWriter =
+		TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&OutlineString);
+	FJsonSerializer::Serialize(Outline->ToSharedRef(), JsonWriter);
+
+	//The hash is case sensitive, over the bytes of the string
+	return CityHash64(reinterpret_cast<const char*>(*OutlineString), OutlineString.Len() * sizeof(TCHAR));
+}
+
+
+/**
+ * @brief Function that takes the data from a geojson obtained over the HTTP call to create and instantiate a
+ * CesiumRasterOverlay, then this new object is added to the world overlay to avoid oclussion in the current
+ * tileset.
+ */
+void ASkycatchTerrain::RenderRasterOverlay()
+{
+	
+	//Gets a reference to the world terrain actor
+	if (const UWorld* World = GetWorld())
+	{
+		WorldTerrain = UGameplayStatics::GetActorOfClass(World, ACesium3DTileset::StaticClass());
+	}
+
+	//Checks if the world terrain exists
+	if(WorldTerrain)
+	{
+		// Checks if raster overlay component in world terrain exists, if not it creates a new one
+		RasterOverlay = WorldTerrain->FindComponentByClass<UCesiumPolygonRasterOverlay>();
+		if (!RasterOverlay)
+		{
+			// Create a new PolygonRasterOverlayComponent and add it to the World Terrain
+			const auto NewRasterOverlay = NewObject<UCesiumPolygonRasterOverlay>(WorldTerrain, FName("CesiumPolygonRasterOverlay"));
+			NewRasterOverlay->RegisterComponent();
+			RasterOverlay = NewRasterOverlay;
+			WorldTerrain->AddInstanceComponent(RasterOverlay);
+		}
+
+		// At this point we should have a valid Raster Overlay object
+		if(RasterOverlay)
+		{
+			// Submits the outline, merged with the adjacent sites, to the raster overlay to avoid occlusion.
+			// The world terrain is only refreshed when the submitted polygons change
+			if (USkycatchSubsystem* Subsystem = GetWorld()->GetSubsystem<USkycatchSubsystem>())
+			{
+				Subsystem->SubmitSitePolygon(this, RasterOverlay);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Function that changes the visibility of the owned 3Dtiles model
+ * Note* For the moment it only works properly in runtime
+ *
+ * @param isVisible as a boolean to indicate the visibility of the tileset
+ */
+void ASkycatchTerrain::SetCesium3DTilesetVisible(bool isVisible)
+{
+	if (!Cesium3DTilesetActor)
+	{
+		UE_LOG(LogSkycatch, Warning, TEXT("No Cesium 3DTileset found"));
+		return;
+	}
+	
+	//Sets the actor visibility to the requested value (true, false)
+	Cesium3DTilesetActor->SetHidden(!isVisible);
+	//Refresh the tileset
+	Cesium3DTilesetActor->RefreshTileset();
+	Cesium3DTilesetActorVisible = isVisible;
+	UE_LOG(LogSkycatch, Log, TEXT("Changed 3DTileset visibility"));
+}
+
+/**
+ * @brief Function that changes the visibility of the owned polygon raster overlay
+ * Note* For the moment it only works in runtime.
+ * 
+ * @param isVisible as a boolean to indicate the visibility of the polygon raster overlay.
+ */
+void ASkycatchTerrain::SetRasterOverlayVisible(bool isVisible)
+{
+	if (!CartographicPolygon)
+	{
+		UE_LOG(LogSkycatch, Warning, TEXT("No polygon found"));
+		return;
+	}
+	
+	//Gets a reference to the world terrain actor
+	if(const UWorld* World = GetWorld())
+	{
+		WorldTerrain = UGameplayStatics::GetActorOfClass(World, ACesium3DTileset::StaticClass());
+	}
+
+	if(WorldTerrain)
+	{
+		//Finds the CesiumPolygonRasterOverlay component from the world terrain
+		UCesiumPolygonRasterOverlay* Raster = WorldTerrain->FindComponentByClass<UCesiumPolygonRasterOverlay>();
+		USkycatchSubsystem* Subsystem = GetWorld()->GetSubsystem<USkycatchSubsystem>();
+		if(Raster && Subsystem) 
+		{
+			if (!isVisible)
+			{
+				//removes the polygon from the world terrain, the adjacent sites are merged again without it
+				Subsystem->WithdrawSitePolygon(this);
+			}
+			if (isVisible)
+			{
+				//adds the polygon from the world terrain, merged with the adjacent sites
+				RasterOverlay = Raster;
+				Subsystem->SubmitSitePolygon(this, Raster);
+			}
+
+			RasterOverlayVisible = isVisible;
+		}
+	}
+}
+
+/*
+* Creates the query params of a lookup at the given coordinates
+*/
+FString ASkycatchTerrain::MakeQueryParams(double Lat, double Lon)
+{
+	//Creates an array for making the query params used in the HTTP calling to Skycatch services
+	TArray<FStringFormatArg> args;
+	args.Add(FStringFormatArg(Lat));
+	args.Add(FStringFormatArg(Lon));
+
+	//Creates the string with the query params
+	FString Params = FString::Format(TEXT("lat={0}&lng={1}"), args);
+
+	//Asks the Skycatch services for only the properties the plugin uses. The number of sites is only limited by the
+	//services when they return the closest sites first, otherwise the site cache limits them after ranking
+	const USkycatchSettings* Settings = GetDefault<USkycatchSettings>();
+	if (!Settings->SiteLookupFields.IsEmpty())
+	{
+		Params += TEXT("&fields=") + FGenericPlatformHttp::UrlEncode(Settings->SiteLookupFields);
+	}
+	if (Settings->bServerRanksSitesByDistance && Settings->SiteLookupLimit > 0)
+	{
+		Params += FString::Printf(TEXT("&limit=%d"), Settings->SiteLookupLimit);
+	}
+	return Params;
+}
+
+void ASkycatchTerrain::MakeRequest(double Lat, double Lon) 
+{
+	QueryParams = MakeQueryParams(Lat, Lon);
+
+	//Calls the function to render the tileset over the new latitude, longitude parameters
+	FindResource(QueryParams);
+}
+
+void ASkycatchTerrain::RequestTilesetAtCoordinates(double Lat, double Lon) 
+{
+
+	MakeRequest(Lat, Lon);
+
+}
+
+/**
+ * @brief This function can be used to request a tileset at the actor's location.
+ * This actor's reference to the active Cesium Georeference must be valid,
+ * since that is used to convert from Unreal to Lat, Lon coordinates
+ */
+void ASkycatchTerrain::RequestTilesetAtActorLocation()
+{
+	//Checks if there is a Georeference Actor selected, if not the process stops and the request fails
+	if(GeoreferenceActor == nullptr)
+	{
+		UE_LOG(LogSkycatch, Error, TEXT("No Georeference Actor selected in SkycatchTerrain Actor"));
+		BroadcastRequestCompleted(++LastRequestSerial, false);
+		return;
+	}
+
+	// Get actor position
+	const auto ActorLocation = GetActorLocation();
+	
+	// Convert actor coordinates from unreal to Lat, Lon
+	const auto LatLonHeight = GeoreferenceActor->TransformUnrealToLongitudeLatitudeHeight(glm::dvec3(ActorLocation.X, ActorLocation.Y, ActorLocation.Z));
+	const auto Lat = LatLonHeight.y;
+	const auto Lon = LatLonHeight.x;
+
+	// Update Lat, Lon values
+	Latitude = FString::SanitizeFloat(Lat);
+	Longitude = FString::SanitizeFloat(Lon);
+
+	// Now make a request on the given coordinates
+	MakeRequest(Lat, Lon);
+
+}
+
+
+void ASkycatchTerrain::RequestTilesetAtActorLocationEditor()
+{
+	//Checks if there is a Georeference Actor selected, if not the process stops
+	if (GeoreferenceActor == nullptr)
+	{
+		UE_LOG(LogSkycatch, Error, TEXT("No Georeference Actor selected in SkycatchTerrain Actor"));
+		return;
+	}
+
+	// Get actor position
+	const auto ActorLocation = GetActorLocation();
+
+	// Convert actor coordinates from unreal to Lat, Lon
+	const auto LatLonHeight = GeoreferenceActor->TransformUnrealToLongitudeLatitudeHeight(glm::dvec3(ActorLocation.X, ActorLocation.Y, ActorLocation.Z));
+	const auto Lat = LatLonHeight.y;
+	const auto Lon = LatLonHeight.x;
+
+	// Update Lat, Lon values
+	Latitude = FString::SanitizeFloat(Lat);
+	Longitude = FString::SanitizeFloat(Lon);
+
+	// Now make a request on the given coordinates
+	QueryParams = MakeQueryParams(Lat, Lon);
+
+	//Calls the function to render the tileset over the new latitude, longitude parameters
+	FindResource(QueryParams, true);
+}
+
+/**
+ * @brief Returns the health and latency statistics of every configured Skycatch services endpoint.
+ */
+TArray<FSkycatchEndpointStats> ASkycatchTerrain::GetEndpointStats()
+{
+	return FSkycatchEndpointPool::Get().GetStats();
+}
+
+/**
+ * @brief Probes every configured Skycatch services endpoint to refresh its health and latency.
+ */
+void ASkycatchTerrain::ProbeEndpoints()
+{
+	FSkycatchEndpointPool::Get().ProbeEndpoints();
+}
+
+/**
+ * @brief Returns the progress and timings of the warm up of the plugin, including its time to ready.
+ */
+FSkycatchWarmUpStats ASkycatchTerrain::GetWarmUpStats()
+{
+	return FSkycatchWarmUp::Get().GetStats();
+}
+
+/*
+ * @brief This function unloads the current tileset (if any) by destroying the associated Cesium actors
+ */
+void ASkycatchTerrain::UnloadTileset()
+{
+	//A commit still queued would show the site again
+	if (USkycatchSubsystem* Subsystem = GetWorld() ? GetWorld()->GetSubsystem<USkycatchSubsystem>() : nullptr)
+	{
+		Subsystem->CancelCommit(this);
+	}
+	CancelPendingTileset();
+
+	for (ACesium3DTileset* WarmTileset : WarmTilesets)
+	{
+		if (WarmTileset)
+		{
+			this->Children.Remove(WarmTileset);
+			WarmTileset->Destroy();
+		}
+	}
+	WarmTilesets.Empty();
+	SiteCaptures.Empty();
+	ActiveCaptureIndex = INDEX_NONE;
+
+	if (Cesium3DTilesetActor)
+	{
+		Cesium3DTilesetActor->Destroy();
+		Cesium3DTilesetActor = nullptr;
+		ShownTilesetUrl.Empty();
+		ThresholdSwappedUrl.Empty();
+	}
+
+	if (CollisionTilesetActor)
+	{
+		this->Children.Remove(CollisionTilesetActor);
+		CollisionTilesetActor->Destroy();
+		CollisionTilesetActor = nullptr;
+		CollisionLoadSeconds = -1.0f;
+	}
+	HeightCache.Empty();
+
+	if (CartographicPolygon)
+	{
+		// First. unregister the polygon in the world terrain
+		SetRasterOverlayVisible(false);
+
+		// Now mark the actor for destruction
+		CartographicPolygon->Destroy();
+		CartographicPolygon = nullptr;
+		ShownOutlineHash = 0;
+	}
+
+	OutlineLongitudeLatitudeHeight.Empty();
+	OutlineGeometry.Reset();
+	SelectedTile.Reset();
+	UpdateReplicatedSite();
+	if (USkycatchSubsystem* Subsystem = GetWorld() ? GetWorld()->GetSubsystem<USkycatchSubsystem>() : nullptr)
+	{
+		Subsystem->UnregisterTerrain(this);
+	}
+}
+
+void ASkycatchTerrain::PendingTilesetLoadedSwap()
+{
+	// The secondary tileset finished loading, so it can replace the shown one
+	SwapPendingTileset();
+}
+
+/**
+ * @brief Makes the pending tileset the shown one, applies the pending polygon outline at the same moment and
+ * destroys the previous tileset.
+ */
+void ASkycatchTerrain::SwapPendingTileset()
+{
+	if (!PendingTilesetActor)
+	{
+		return;
+	}
+
+	ACesium3DTileset* PreviousTileset = Cesium3DTilesetActor;
+
+	// The pending tileset becomes the shown one and forwards its events as the main tileset from now on
+	Cesium3DTilesetActor = PendingTilesetActor;
+	PendingTilesetActor = nullptr;
+	Cesium3DTilesetActor->OnTilesetLoaded.Remove(PendingTilesetLoadedListener);
+	CesiumTilesetLoadedListener.BindUFunction(this, "CesiumTilesetLoadedForwardBroadcast");
+	Cesium3DTilesetActor->OnTilesetLoaded.Add(CesiumTilesetLoadedListener);
+	Cesium3DTilesetActor->SetActorHiddenInGame(!Cesium3DTilesetActorVisible);
+
+	// The polygon outline changes in the same frame as the tileset
+	if (bHasPendingOutline && CartographicPolygon)
+	{
+		ApplyOutline(MoveTemp(PendingOutline));
+	}
+	PendingOutline.Reset();
+	bHasPendingOutline = false;
+
+	if (PreviousTileset)
+	{
+		//The previous capture stays loaded while it is a neighbour of the active capture
+		if (ShouldKeepCaptureWarm(PreviousTileset->GetUrl()))
+		{
+			PreviousTileset->OnTilesetLoaded.Remove(CesiumTilesetLoadedListener);
+			PreviousTileset->SetActorHiddenInGame(true);
+			WarmTilesets.Add(PreviousTileset);
+		}
+		else
+		{
+			this->Children.Remove(PreviousTileset);
+			PreviousTileset->Destroy();
+		}
+	}
+
+	UE_LOG(LogSkycatch, Display, TEXT("Swapped in tileset %s"), *Cesium3DTilesetActor->GetUrl());
+
+	// The shown tileset gets the largest share of the budgets
+	if (USkycatchSubsystem* Subsystem = GetWorld()->GetSubsystem<USkycatchSubsystem>())
+	{
+		Subsystem->InvalidateTilesetBudgets();
+	}
+
+	// Registers the polygon and notifies listeners as if the shown tileset had just loaded
+	ThresholdSwappedUrl.Empty();
+	CesiumTilesetLoadedForwardBroadcast();
+
+	// A swap below the full load is followed by the loaded event of Cesium, which must not be broadcast twice
+	if (Cesium3DTilesetActor->GetLoadProgress() < 100.0f)
+	{
+		ThresholdSwappedUrl = Cesium3DTilesetActor->GetUrl();
+	}
+}
+
+/**
+ * @brief Destroys the pending tileset (if any) and discards its pending polygon outline.
+ */
+void ASkycatchTerrain::CancelPendingTileset()
+{
+	if (PendingTilesetActor)
+	{
+		this->Children.Remove(PendingTilesetActor);
+		PendingTilesetActor->Destroy();
+		PendingTilesetActor = nullptr;
+	}
+
+	PendingOutline.Reset();
+	bHasPendingOutline = false;
+}
+
+/**
+ * @brief Returns the capture date of a tile from the Skycatch services response, or the minimum date when the tile has
+ * no valid capture date.
+ *
+ * @param Tile as the json object of the tile
+ */
+FDateTime ASkycatchTerrain::GetTileCaptureDate(const TSharedPtr<FJsonObject>& Tile)
+{
+	FString CaptureDate;
+	FDateTime Date = FDateTime::MinValue();
+	if (Tile.IsValid() && Tile->TryGetStringField(TEXT("captureDate"), CaptureDate))
+	{
+		FDateTime::ParseIso8601(*CaptureDate, Date);
+	}
+	return Date;
+}
+
+/**
+ * @brief Switches the shown tileset and polygon to another capture of the current site.
+ *
+ * @param Index as the index of the capture, sorted by capture date
+ */
+bool ASkycatchTerrain::SetActiveCapture(int32 Index)
+{
+	if (!SiteCaptures.IsValidIndex(Index))
+	{
+		UE_LOG(LogSkycatch, Warning, TEXT("Invalid capture index %d"), Index);
+		return false;
+	}
+
+	if (Index != ActiveCaptureIndex)
+	{
+		ActiveCaptureIndex = Index;
+		const UWorld* World = GetWorld();
+		ShowTile(SiteCaptures[Index], World && !World->IsGameWorld(), [this](bool bShown)
+		{
+			if (bShown)
+			{
+				RefreshWarmCaptures();
+			}
+		});
+	}
+	return true;
+}
+
+/**
+ * @brief Moves the active capture forward or back in time.
+ *
+ * @param Offset as the number of captures to move, negative values move back in time
+ */
+bool ASkycatchTerrain::StepActiveCapture(int32 Offset)
+{
+	if (SiteCaptures.Num() == 0)
+	{
+		return false;
+	}
+	return SetActiveCapture(FMath::Clamp(ActiveCaptureIndex + Offset, 0, SiteCaptures.Num() - 1));
+}
+
+/**
+ * @brief Returns the capture dates of the current site, sorted from the oldest to the newest.
+ */
+TArray<FDateTime> ASkycatchTerrain::GetCaptureDates() const
+{
+	TArray<FDateTime> CaptureDates;
+	CaptureDates.Reserve(SiteCaptures.Num());
+	for (const TSharedPtr<FJsonObject>& Capture : SiteCaptures)
+	{
+		CaptureDates.Add(GetTileCaptureDate(Capture));
+	}
+	return CaptureDates;
+}
+
+/**
+ * @brief Returns whether the tileset url belongs to a capture next to the active one that has to be kept warm.
+ *
+ * @param Url as the tileset url of the capture
+ */
+bool ASkycatchTerrain::ShouldKeepCaptureWarm(const FString& Url) const
+{
+	const UWorld* World = GetWorld();
+	if (!World || !World->IsGameWorld() || !SiteCaptures.IsValidIndex(ActiveCaptureIndex))
+	{
+		return false;
+	}
+
+	const int32 Neighbours = SkycatchSettings->CaptureWarmNeighbours;
+	for (int32 Index = ActiveCaptureIndex - Neighbours; Index <= ActiveCaptureIndex + Neighbours; Index++)
+	{
+		if (Index != ActiveCaptureIndex && SiteCaptures.IsValidIndex(Index) &&
+			IsSameUrl(SiteCaptures[Index]->GetStringField("tilesetUrl"), Url))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Returns the warm tileset of a tileset url, or null.
+ *
+ * @param Url as the tileset url of the capture
+ */
+ACesium3DTileset* ASkycatchTerrain::FindWarmTileset(const FString& Url) const
+{
+	for (ACesium3DTileset* WarmTileset : WarmTilesets)
+	{
+		if (WarmTileset && IsSameUrl(WarmTileset->GetUrl(), Url))
+		{
+			return WarmTileset;
+		}
+	}
+	return nullptr;
+}
+
+/**
+ * @brief Returns whether two tileset urls are the same. Urls are case sensitive, as the keys of the storage they
+ * point to.
+ *
+ * @param A as the first url
+ * @param B as the second url
+ */
+bool ASkycatchTerrain::IsSameUrl(const FString& A, const FString& B)
+{
+	return A.Equals(B, ESearchCase::CaseSensitive);
+}
+
+/**
+ * @brief Prefetches the captures next to the active one into hidden tilesets and releases the ones that are no
+ * longer neighbours, splitting the configured memory budget between them.
+ */
+void ASkycatchTerrain::RefreshWarmCaptures()
+{
+	//Collects the neighbour captures, the closest ones in time first
+	TArray<FString> WarmUrls;
+	const UWorld* World = GetWorld();
+	if (World && World->IsGameWorld() && SiteCaptures.IsValidIndex(ActiveCaptureIndex))
+	{
+		const FString ActiveUrl = SiteCaptures[ActiveCaptureIndex]->GetStringField("tilesetUrl");
+		for (int32 Distance = 1; Distance <= SkycatchSettings->CaptureWarmNeighbours; Distance++)
+		{
+			for (const int32 Index : { ActiveCaptureIndex - Distance, ActiveCaptureIndex + Distance })
+			{
+				if (SiteCaptures.IsValidIndex(Index))
+				{
+					const FString Url = SiteCaptures[Index]->GetStringField("tilesetUrl");
+					const bool bKnown = WarmUrls.ContainsByPredicate([&Url](const FString& WarmUrl) { return IsSameUrl(WarmUrl, Url); });
+					if (!bKnown && !IsSameUrl(Url, ActiveUrl) && (!PendingTilesetActor || !IsSameUrl(PendingTilesetActor->GetUrl(), Url)))
+					{
+						WarmUrls.Add(Url);
+					}
+				}
+			}
+		}
+	}
+
+	//Releases the warm tilesets that are no longer neighbours
+	for (int32 Index = WarmTilesets.Num() - 1; Index >= 0; Index--)
+	{
+		ACesium3DTileset* WarmTileset = WarmTilesets[Index];
+		const bool bNeighbour = WarmTileset && WarmUrls.ContainsByPredicate([WarmTileset](const FString& Url)
+		{
+			return IsSameUrl(Url, WarmTileset->GetUrl());
+		});
+		if (!bNeighbour)
+		{
+			if (WarmTileset)
+			{
+				this->Children.Remove(WarmTileset);
+				WarmTileset->Destroy();
+			}
+			WarmTilesets.RemoveAt(Index);
+		}
+	}
+
+	if (WarmUrls.Num() == 0)
+	{
+		return;
+	}
 
-		//Listen to the tileset on loaded event
-		CesiumTilesetLoadedListener.BindUFunction(this, "CesiumTilesetLoadedForwardBroadcast");
-		Cesium3DTilesetActor->OnTilesetLoaded.Add(CesiumTilesetLoadedListener);
+	//Every warm tileset gets an equal share of the budget as its Cesium cache limit
+	const int64 BytesPerTileset = SkycatchSettings->CaptureWarmBudgetBytes / WarmUrls.Num();
+	for (const FString& Url : WarmUrls)
+	{
+		ACesium3DTileset* WarmTileset = FindWarmTileset(Url);
+		if (!WarmTileset)
+		{
+			WarmTileset = SpawnSkycatchTileset();
+			WarmTileset->SetActorHiddenInGame(true);
+			WarmTileset->SetGeoreference(GeoreferenceActor);
+			WarmTileset->SetTilesetSource(ETilesetSource::FromUrl);
+			WarmTileset->SetUrl(Url);
+			WarmTilesets.Add(WarmTileset);
+		}
+		WarmTileset->MaximumCachedBytes = BytesPerTileset;
 	}
-	
-	//If the actor exists, updates the actor properties to the new response from Skycatch services
-	Cesium3DTilesetActor->SetGeoreference(GeoreferenceActor);
-	Cesium3DTilesetActor->SetTilesetSource(ETilesetSource::FromUrl);
-	Cesium3DTilesetActor->SetUrl(url);
-	UE_LOG(LogSkycatch, Display, TEXT("Response %s"), *url);
 }
 
 /**
- * @brief Function that takes the data from a geojson obtained over the HTTP call to create and instantiate a
- * CesiumRasterOverlay, then this new object is added to the world overlay to avoid oclussion in the current
- * tileset.
+ * @brief Changes the collision policy of the actor and applies it to its tilesets.
+ *
+ * @param Policy as the new collision policy
  */
-void ASkycatchTerrain::SpawnCartographicPolygon() 
+void ASkycatchTerrain::SetCollisionPolicy(ESkycatchCollisionPolicy Policy)
 {
-	float altitude_m = 0;
-	const FVector Location = FVector(0, 0, 0);
-	const FRotator Rotation = FRotator(0, 0, 0);
+	CollisionPolicy = Policy;
 
-	//Gets a reference to the world terrain actor
-	if (const UWorld* World = GetWorld())
+	//Changing whether the shown tilesets build physics meshes reloads them, so it is only done when it changes
+	const bool bCreatePhysicsMeshes = GetEffectiveCollisionPolicy() == ESkycatchCollisionPolicy::Full;
+	if (Cesium3DTilesetActor && Cesium3DTilesetActor->GetCreatePhysicsMeshes() != bCreatePhysicsMeshes)
 	{
-		WorldTerrain = UGameplayStatics::GetActorOfClass(World, ACesium3DTileset::StaticClass());
+		Cesium3DTilesetActor->SetCreatePhysicsMeshes(bCreatePhysicsMeshes);
 	}
-
-	//Parses the response from the current tile fetched from Skycatch services
-	TArray<TSharedPtr<FJsonValue>> Coordinates;
-
-	auto outline = SelectedTile->GetObjectField("outline");
-	if (!outline)
+	if (PendingTilesetActor && PendingTilesetActor->GetCreatePhysicsMeshes() != bCreatePhysicsMeshes)
 	{
-		UE_LOG(LogSkycatch, Error, TEXT("Tileset outline polygon not found."));
-		return;
+		PendingTilesetActor->SetCreatePhysicsMeshes(bCreatePhysicsMeshes);
+	}
+	for (ACesium3DTileset* WarmTileset : WarmTilesets)
+	{
+		if (WarmTileset && WarmTileset->GetCreatePhysicsMeshes() != bCreatePhysicsMeshes)
+		{
+			WarmTileset->SetCreatePhysicsMeshes(bCreatePhysicsMeshes);
+		}
 	}
 
-	auto type = outline->GetStringField("type");
+	UpdateCollision();
+}
 
-	// Handle different configurations of the incoming outline
-	if (type == "Feature")
+/**
+ * @brief Returns the collision policy in effect, resolving the project default.
+ */
+ESkycatchCollisionPolicy ASkycatchTerrain::GetEffectiveCollisionPolicy() const
+{
+	if (CollisionPolicy != ESkycatchCollisionPolicy::UseProjectDefault)
 	{
-		Coordinates = outline->GetObjectField("geometry")->GetArrayField("coordinates")[0]->AsArray();
-	}
-	else {
-		Coordinates = SelectedTile->GetObjectField("outline")->GetArrayField("coordinates")[0]->AsArray();
+		return CollisionPolicy;
 	}
 
-	TArray<FVector> SplinePoints = {};
+	const ESkycatchCollisionPolicy DefaultPolicy = GetDefault<USkycatchSettings>()->DefaultCollisionPolicy;
+	return DefaultPolicy == ESkycatchCollisionPolicy::UseProjectDefault ? ESkycatchCollisionPolicy::Full : DefaultPolicy;
+}
+
+/**
+ * @brief Returns the number, memory and build time of the physics meshes of the actor.
+ */
+FSkycatchCollisionStats ASkycatchTerrain::GetCollisionStats() const
+{
+	FSkycatchCollisionStats Stats;
+	Stats.Policy = GetEffectiveCollisionPolicy();
 
-	//Iterates over the geojson data that contains the coordinates to create the Raster polygon
-	for (int i = 0; i < Coordinates.Num(); i++)
+	//The physics meshes are either in the shown tileset or in the collision tileset
+	const ACesium3DTileset* Tileset = CollisionTilesetActor ? CollisionTilesetActor :
+		(Stats.Policy == ESkycatchCollisionPolicy::Full ? Cesium3DTilesetActor : nullptr);
+	if (!Tileset)
 	{
-		TArray<TSharedPtr<FJsonValue>> Coords;
-		Coords = Coordinates[i]->AsArray();
-		FString lat;
-		FString lng;
-		//Gets the latitude and longitude of every coordinate
-		Coords[0].Get()->TryGetString(lat);
-		Coords[1].Get()->TryGetString(lng);
-		//Adds the latitude and longitude as a new vector with double-precision numbers
-		glm::dvec3 Point = glm::dvec3(FCString::Atod(*lat), FCString::Atod(*lng), altitude_m);
-		//Transforms the latitude, longitude to UE world coordinates
-		const glm::dvec3 UECoords = GeoreferenceActor->TransformLongitudeLatitudeHeightToUnreal(Point);
-		//Adds the coordinate to the vector to create the cartographic polygon
-		SplinePoints.Add(FVector(UECoords.x, UECoords.y, UECoords.z));
+		return Stats;
 	}
 
-	//Checks if already exists a cartographic polygon, if not instantiates a new CesiumCartographicPolygon
-	if (CartographicPolygon == nullptr)
+	TInlineComponentArray<UPrimitiveComponent*> Components(Tileset);
+	for (UPrimitiveComponent* Component : Components)
 	{
-		CartographicPolygon = GetWorld()->SpawnActor<ACesiumCartographicPolygon>(Location, Rotation);
-		this->Children.Add(CartographicPolygon);
-		CartographicPolygon->Tags.Add(FName("Skycatch"));
-	}
+		UBodySetup* BodySetup = Component->GetBodySetup();
+		if (!BodySetup)
+		{
+			continue;
+		}
 
-	//Sets the polygon of the CesiumCartographicPolygon
-	CartographicPolygon->Polygon->SetSplinePoints(SplinePoints, ESplineCoordinateSpace::Local);
+		Stats.CollisionMeshes++;
+		Stats.ActiveCollisionMeshes += Component->IsCollisionEnabled() ? 1 : 0;
+		Stats.CollisionBytes += BodySetup->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+	}
+	Stats.LoadSeconds = CollisionTilesetActor ? CollisionLoadSeconds : -1.0f;
+	return Stats;
 }
 
-
 /**
- * @brief Function that takes the data from a geojson obtained over the HTTP call to create and instantiate a
- * CesiumRasterOverlay, then this new object is added to the world overlay to avoid oclussion in the current
- * tileset.
+ * @brief Spawns, retargets or releases the collision tileset for the collision policy and the player views, and
+ * enables the collision of the tiles close to a player with the NearPlayer policy.
  */
-void ASkycatchTerrain::RenderRasterOverlay()
+void ASkycatchTerrain::UpdateCollision()
 {
-	
-	//Gets a reference to the world terrain actor
-	if (const UWorld* World = GetWorld())
+	const USkycatchSettings* Settings = GetDefault<USkycatchSettings>();
+	const ESkycatchCollisionPolicy Policy = GetEffectiveCollisionPolicy();
+	const FString Url = Cesium3DTilesetActor ? Cesium3DTilesetActor->GetUrl() : FString();
+	const TArray<FVector> PlayerLocations = GetPlayerLocations();
+
+	//Without players, as on a dedicated server before anyone joins, the whole site keeps its collision
+	double DistanceToPlayers = PlayerLocations.Num() > 0 ? TNumericLimits<double>::Max() : 0.0;
+	if (Policy == ESkycatchCollisionPolicy::NearPlayer && OutlineLongitudeLatitudeHeight.Num() > 0 && GeoreferenceActor)
 	{
-		WorldTerrain = UGameplayStatics::GetActorOfClass(World, ACesium3DTileset::StaticClass());
+		const FBox SiteBounds(ProjectOutline(OutlineLongitudeLatitudeHeight));
+		for (const FVector& Location : PlayerLocations)
+		{
+			DistanceToPlayers = FMath::Min(DistanceToPlayers, FMath::Sqrt(SiteBounds.ComputeSquaredDistanceToPoint(Location)));
+		}
+	}
+	else
+	{
+		DistanceToPlayers = 0.0;
 	}
 
-	//Checks if the world terrain exists
-	if(WorldTerrain)
+	bool bWantsCollisionTileset = false;
+	if (GetWorld()->IsGameWorld() && !Url.IsEmpty())
 	{
-		// Checks if raster overlay component in world terrain exists, if not it creates a new one
-		RasterOverlay = WorldTerrain->FindComponentByClass<UCesiumPolygonRasterOverlay>();
-		if (!RasterOverlay)
+		if (Policy == ESkycatchCollisionPolicy::SimplifiedProxy)
 		{
-			// Create a new PolygonRasterOverlayComponent and add it to the World Terrain
-			const auto NewRasterOverlay = NewObject<UCesiumPolygonRasterOverlay>(WorldTerrain, FName("CesiumPolygonRasterOverlay"));
-			NewRasterOverlay->RegisterComponent();
-			RasterOverlay = NewRasterOverlay;
-			WorldTerrain->AddInstanceComponent(RasterOverlay);
+			bWantsCollisionTileset = true;
 		}
-
-		// At this point we should have a valid Raster Overlay object
-		if(RasterOverlay)
+		else if (Policy == ESkycatchCollisionPolicy::NearPlayer)
 		{
-			bool PolygonAlreadyRegistered = false;
-			// Search the polygon in the raster overlay polygons array
-			for (auto* OverlayPolygon : RasterOverlay->Polygons)
-			{
-				if (OverlayPolygon == CartographicPolygon)
-				{
-					UE_LOG(LogSkycatch, Display, TEXT("Polygon already registered"));
-					PolygonAlreadyRegistered = true;
-					break;
-				}
-			}
-
-			if (!PolygonAlreadyRegistered)
-			{
-				// Adds the cartographic polygon to the raster overlay to avoid occlusion
-				RasterOverlay->Polygons.Add(CartographicPolygon);
-				// Refresh the world terrain tilesets
-				Cast<ACesium3DTileset>(WorldTerrain)->RefreshTileset();
-			}
+			//A spawned collision tileset is kept a bit further away, so it isn't rebuilt at the edge of the distance
+			const double ReleaseDistance = Settings->CollisionDistance * (CollisionTilesetActor ? 1.5 : 1.0);
+			bWantsCollisionTileset = DistanceToPlayers <= ReleaseDistance;
 		}
 	}
-}
 
-/**
- * @brief Function that changes the visibility of the owned 3Dtiles model
- * Note* For the moment it only works properly in runtime
- *
- * @param isVisible as a boolean to indicate the visibility of the tileset
- */
-void ASkycatchTerrain::SetCesium3DTilesetVisible(bool isVisible)
-{
-	if (!Cesium3DTilesetActor)
+	if (!bWantsCollisionTileset)
 	{
-		UE_LOG(LogSkycatch, Warning, TEXT("No Cesium 3DTileset found"));
+		if (CollisionTilesetActor)
+		{
+			this->Children.Remove(CollisionTilesetActor);
+			CollisionTilesetActor->Destroy();
+			CollisionTilesetActor = nullptr;
+			CollisionLoadSeconds = -1.0f;
+		}
 		return;
 	}
-	
-	//Sets the actor visibility to the requested value (true, false)
-	Cesium3DTilesetActor->SetHidden(!isVisible);
-	//Refresh the tileset
-	Cesium3DTilesetActor->RefreshTileset();
-	Cesium3DTilesetActorVisible = isVisible;
-	UE_LOG(LogSkycatch, Log, TEXT("Changed 3DTileset visibility"));
-}
 
-/**
- * @brief Function that changes the visibility of the owned polygon raster overlay
- * Note* For the moment it only works in runtime.
- * 
- * @param isVisible as a boolean to indicate the visibility of the polygon raster overlay.
- */
-void ASkycatchTerrain::SetRasterOverlayVisible(bool isVisible)
-{
-	if (!CartographicPolygon)
+	if (!CollisionTilesetActor)
 	{
-		UE_LOG(LogSkycatch, Warning, TEXT("No polygon found"));
-		return;
+		//The collision tileset is never rendered, Cesium cooks its physics meshes on its worker threads. Its tiles
+		//are selected by distance only, as a player collides with the terrain behind the camera or in the fog too
+		CollisionTilesetActor = SpawnSkycatchTileset();
+		CollisionTilesetActor->EnableFrustumCulling = false;
+		CollisionTilesetActor->EnableFogCulling = false;
+		CollisionTilesetActor->SetCreatePhysicsMeshes(true);
+		CollisionTilesetActor->SetActorHiddenInGame(true);
+		CollisionTilesetActor->SetGeoreference(GeoreferenceActor);
+		CollisionTilesetActor->SetTilesetSource(ETilesetSource::FromUrl);
 	}
-	
-	//Gets a reference to the world terrain actor
-	if(const UWorld* World = GetWorld())
+
+	const double ScreenSpaceError = Policy == ESkycatchCollisionPolicy::NearPlayer ?
+		Settings->NearPlayerCollisionScreenSpaceError : Settings->CollisionProxyScreenSpaceError;
+	if (CollisionTilesetActor->MaximumScreenSpaceError != ScreenSpaceError)
 	{
-		WorldTerrain = UGameplayStatics::GetActorOfClass(World, ACesium3DTileset::StaticClass());
+		CollisionTilesetActor->SetMaximumScreenSpaceError(ScreenSpaceError);
 	}
 
-	if(WorldTerrain)
+	if (!IsSameUrl(CollisionTilesetActor->GetUrl(), Url))
 	{
-		//Finds the CesiumPolygonRasterOverlay component from the world terrain
-		UCesiumPolygonRasterOverlay* Raster = WorldTerrain->FindComponentByClass<UCesiumPolygonRasterOverlay>();
-		if(Raster) 
+		CollisionTilesetActor->SetUrl(Url);
+		CollisionLoadStartTime = FPlatformTime::Seconds();
+		CollisionLoadSeconds = -1.0f;
+	}
+	else if (CollisionLoadSeconds < 0.0f)
+	{
+		const Cesium3DTilesSelection::Tileset* Tileset = CollisionTilesetActor->GetTileset();
+		if (Tileset && Tileset->getRootTile() && CollisionTilesetActor->GetLoadProgress() >= 100.0f)
 		{
-			if (!isVisible)
+			CollisionLoadSeconds = FPlatformTime::Seconds() - CollisionLoadStartTime;
+			const FSkycatchCollisionStats Stats = GetCollisionStats();
+			UE_LOG(LogSkycatch, Display, TEXT("Collision of %s: %d physics meshes, %.1f MB, loaded and cooked in %.2f s"),
+				*Url, Stats.CollisionMeshes, Stats.CollisionBytes / (1024.0 * 1024.0), CollisionLoadSeconds);
+		}
+	}
+
+	//With the NearPlayer policy only the tiles close to a player collide
+	if (Policy == ESkycatchCollisionPolicy::NearPlayer && PlayerLocations.Num() > 0)
+	{
+		const double CollisionDistanceSquared = FMath::Square((double)Settings->CollisionDistance);
+		TInlineComponentArray<UPrimitiveComponent*> Components(CollisionTilesetActor);
+		for (UPrimitiveComponent* Component : Components)
+		{
+			if (!Component->GetBodySetup())
 			{
-				//removes the polygon from the world terrain
-				Raster->Polygons.Remove(CartographicPolygon);
+				continue;
 			}
-			if (isVisible)
+
+			const FBox Bounds = Component->Bounds.GetBox();
+			const bool bNear = PlayerLocations.ContainsByPredicate([&Bounds, CollisionDistanceSquared](const FVector& Location)
 			{
-				//adds the polygon from the world terrain
-				Raster->Polygons.Add(CartographicPolygon);
+				return Bounds.ComputeSquaredDistanceToPoint(Location) <= CollisionDistanceSquared;
+			});
+			const ECollisionEnabled::Type CollisionEnabled = bNear ? ECollisionEnabled::QueryAndPhysics : ECollisionEnabled::NoCollision;
+			if (Component->GetCollisionEnabled() != CollisionEnabled)
+			{
+				Component->SetCollisionEnabled(CollisionEnabled);
 			}
-
-			Cast<ACesium3DTileset>(WorldTerrain)->RefreshTileset();
-			RasterOverlayVisible = isVisible;
 		}
 	}
 }
 
-void ASkycatchTerrain::MakeRequest(double Lat, double Lon) 
+/**
+ * @brief Finds the height of the survey surface at a batch of points. The points are traced in parallel against
+ * the loaded tiles, and the heights found are cached per tile. Points without a loaded tile under them are
+ * answered once their tile loads, so the callback may be called on a later frame, once for the whole batch.
+ *
+ * @param LongitudeLatitude as the points, with the longitude in X and the latitude in Y
+ * @param OnQueried as the callback receiving a sample per point, in the same order
+ */
+void ASkycatchTerrain::QueryHeights(const TArray<FVector2D>& LongitudeLatitude, const FOnSkycatchHeightsQueried& OnQueried)
 {
-	//Creates an array for making the query params used in the HTTP calling to Skycatch services
-	TArray<FStringFormatArg> args;
-	args.Add(FStringFormatArg(Lat));
-	args.Add(FStringFormatArg(Lon));
+	FPendingHeightQuery Query;
+	Query.LongitudeLatitude = LongitudeLatitude;
+	Query.Samples.SetNum(LongitudeLatitude.Num());
+	Query.Deadline = FPlatformTime::Seconds() + GetDefault<USkycatchSettings>()->HeightQueryTimeoutSeconds;
+	Query.OnQueried = OnQueried;
+
+	TArray<int32> Indices;
+	Indices.Reserve(LongitudeLatitude.Num());
+	for (int32 Index = 0; Index < LongitudeLatitude.Num(); Index++)
+	{
+		Indices.Add(Index);
+	}
 
-	//Creates the string with the query params
-	QueryParams = FString::Format(TEXT("lat={0}&lng={1}"), args);
+	const double StartTime = FPlatformTime::Seconds();
+	HeightCache.Resolve(GetHeightQueryTileset(), GeoreferenceActor, Query.LongitudeLatitude, Indices, Query.Samples, Query.Unresolved);
+	UE_LOG(LogSkycatch, Verbose, TEXT("Queried %d heights in %.2f ms, %d waiting for their tile"),
+		LongitudeLatitude.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0, Query.Unresolved.Num());
 
-	//Calls the function to render the tileset over the new latitude, longitude parameters
-	FindResource(QueryParams);
+	if (Query.Unresolved.Num() == 0)
+	{
+		OnQueried.ExecuteIfBound(Query.Samples);
+		return;
+	}
+	PendingHeightQueries.Add(MoveTemp(Query));
 }
 
-void ASkycatchTerrain::RequestTilesetAtCoordinates(double Lat, double Lon) 
+/**
+ * @brief Computes the cut and fill volumes of the loaded survey surface inside a polygon against a reference
+ * surface. The level of detail is the one of the loaded tiles with physics meshes, the collision tileset when the
+ * collision policy uses one, and the cell size sets the resolution of the integration.
+ *
+ * @param PolygonLongitudeLatitude as the polygon, with the longitude in X and the latitude in Y
+ * @param Reference as the reference surface
+ * @param ReferenceHeight as the height in meters above the WGS84 ellipsoid of the FixedHeight reference
+ * @param CellSizeMeters as the size of the raster cells in meters
+ */
+FSkycatchVolumeResult ASkycatchTerrain::ComputeVolume(const TArray<FVector2D>& PolygonLongitudeLatitude, ESkycatchVolumeReference Reference,
+	double ReferenceHeight, double CellSizeMeters) const
 {
-
-	MakeRequest(Lat, Lon);
-
+	return FSkycatchVolume::Compute(GetHeightQueryTileset(), GeoreferenceActor, PolygonLongitudeLatitude, Reference, ReferenceHeight, CellSizeMeters);
 }
 
 /**
- * @brief This function can be used to request a tileset at the actor's location.
- * This actor's reference to the active Cesium Georeference must be valid,
- * since that is used to convert from Unreal to Lat, Lon coordinates
+ * @brief Computes the cut and fill volumes of the loaded survey surface inside the outline of the site.
+ *
+ * @param Reference as the reference surface
+ * @param ReferenceHeight as the height in meters above the WGS84 ellipsoid of the FixedHeight reference
+ * @param CellSizeMeters as the size of the raster cells in meters
  */
-void ASkycatchTerrain::RequestTilesetAtActorLocation()
+FSkycatchVolumeResult ASkycatchTerrain::ComputeSiteVolume(ESkycatchVolumeReference Reference, double ReferenceHeight, double CellSizeMeters) const
 {
-	//Checks if there is a Georeference Actor selected, if not the process stops
-	if(GeoreferenceActor == nullptr)
+	TArray<FVector2D> Polygon;
+	Polygon.Reserve(OutlineLongitudeLatitudeHeight.Num());
+	for (const FVector& Point : OutlineLongitudeLatitudeHeight)
 	{
-		UE_LOG(LogSkycatch, Error, TEXT("No Georeference Actor selected in SkycatchTerrain Actor"));
-		return;
+		Polygon.Add(FVector2D(Point.X, Point.Y));
 	}
-
-	// Get actor position
-	const auto ActorLocation = GetActorLocation();
-	
-	// Convert actor coordinates from unreal to Lat, Lon
-	const auto LatLonHeight = GeoreferenceActor->TransformUnrealToLongitudeLatitudeHeight(glm::dvec3(ActorLocation.X, ActorLocation.Y, ActorLocation.Z));
-	const auto Lat = LatLonHeight.y;
-	const auto Lon = LatLonHeight.x;
-
-	// Update Lat, Lon values
-	Latitude = FString::SanitizeFloat(Lat);
-	Longitude = FString::SanitizeFloat(Lon);
-
-	// Now make a request on the given coordinates
-	MakeRequest(Lat, Lon);
-
+	return ComputeVolume(Polygon, Reference, ReferenceHeight, CellSizeMeters);
 }
 
+/**
+ * @brief Returns the tileset the height queries trace, the collision tileset when there is one.
+ */
+ACesium3DTileset* ASkycatchTerrain::GetHeightQueryTileset() const
+{
+	return CollisionTilesetActor ? CollisionTilesetActor : Cesium3DTilesetActor;
+}
 
-void ASkycatchTerrain::RequestTilesetAtActorLocationEditor()
+/**
+ * @brief Retries the points of the pending height queries, and answers the queries that are complete or timed out.
+ */
+void ASkycatchTerrain::ResolvePendingHeightQueries()
 {
-	//Checks if there is a Georeference Actor selected, if not the process stops
-	if (GeoreferenceActor == nullptr)
+	if (PendingHeightQueries.Num() == 0)
 	{
-		UE_LOG(LogSkycatch, Error, TEXT("No Georeference Actor selected in SkycatchTerrain Actor"));
 		return;
 	}
 
-	// Get actor position
-	const auto ActorLocation = GetActorLocation();
-
-	// Convert actor coordinates from unreal to Lat, Lon
-	const auto LatLonHeight = GeoreferenceActor->TransformUnrealToLongitudeLatitudeHeight(glm::dvec3(ActorLocation.X, ActorLocation.Y, ActorLocation.Z));
-	const auto Lat = LatLonHeight.y;
-	const auto Lon = LatLonHeight.x;
-
-	// Update Lat, Lon values
-	Latitude = FString::SanitizeFloat(Lat);
-	Longitude = FString::SanitizeFloat(Lon);
-
-	// Now make a request on the given coordinates
-	TArray<FStringFormatArg> args;
-	args.Add(FStringFormatArg(Lat));
-	args.Add(FStringFormatArg(Lon));
+	//The queries are moved out, so a callback can start a new query
+	TArray<FPendingHeightQuery> Queries = MoveTemp(PendingHeightQueries);
+	PendingHeightQueries.Reset();
 
-	//Creates the string with the query params
-	QueryParams = FString::Format(TEXT("lat={0}&lng={1}"), args);
+	const double Now = FPlatformTime::Seconds();
+	ACesium3DTileset* Tileset = GetHeightQueryTileset();
+	for (FPendingHeightQuery& Query : Queries)
+	{
+		TArray<int32> Unresolved;
+		HeightCache.Resolve(Tileset, GeoreferenceActor, Query.LongitudeLatitude, Query.Unresolved, Query.Samples, Unresolved);
+		Query.Unresolved = MoveTemp(Unresolved);
 
-	//Calls the function to render the tileset over the new latitude, longitude parameters
-	FindResource(QueryParams, true);
+		//Points whose tile never loaded are answered as misses
+		if (Query.Unresolved.Num() == 0 || Now >= Query.Deadline)
+		{
+			if (Query.Unresolved.Num() > 0)
+			{
+				UE_LOG(LogSkycatch, Warning, TEXT("%d height query points had no loaded tile"), Query.Unresolved.Num());
+			}
+			Query.OnQueried.ExecuteIfBound(Query.Samples);
+		}
+		else
+		{
+			PendingHeightQueries.Add(MoveTemp(Query));
+		}
+	}
 }
 
-/*
- * @brief This function unloads the current tileset (if any) by destroying the associated Cesium actors
+/**
+ * @brief Returns the view locations of all the players, including the remote ones on a server.
  */
-void ASkycatchTerrain::UnloadTileset()
+TArray<FVector> ASkycatchTerrain::GetPlayerLocations() const
 {
-	if (Cesium3DTilesetActor)
-	{
-		Cesium3DTilesetActor->Destroy();
-		Cesium3DTilesetActor = nullptr;
-	}
-
-	if (CartographicPolygon)
+	TArray<FVector> Locations;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
 	{
-		// First. unregister the polygon in the world terrain
-		SetRasterOverlayVisible(false);
-
-		// Now mark the actor for destruction
-		CartographicPolygon->Destroy();
-		CartographicPolygon = nullptr;
+		if (const APlayerController* PlayerController = It->Get())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			Locations.Add(ViewLocation);
+		}
 	}
+	return Locations;
 }
 
 void ASkycatchTerrain::CesiumTilesetLoadedForwardBroadcast()
@@ -553,6 +1812,17 @@ void ASkycatchTerrain::CesiumTilesetLoadedForwardBroadcast()
 		RenderRasterOverlay();
 	}
 
+	// The height queries waiting for tiles are answered as soon as the tileset is loaded
+	ResolvePendingHeightQueries();
+
+	// The full load of a tileset swapped in at the load progress threshold was already broadcast at the swap
+	if (Cesium3DTilesetActor && !ThresholdSwappedUrl.IsEmpty() && IsSameUrl(Cesium3DTilesetActor->GetUrl(), ThresholdSwappedUrl))
+	{
+		ThresholdSwappedUrl.Empty();
+		return;
+	}
+	ThresholdSwappedUrl.Empty();
+
 	// This function is called whenever the instanced Cesium3DTiles Actor fires its "OnLoaded" event, so we just broadcast a new event with a reference to the tileset
 	OnTilesetLoaded.Broadcast(Cesium3DTilesetActor);
 }
@@ -566,7 +1836,8 @@ URequestSkycatchTilesetAtCoordinates::URequestSkycatchTilesetAtCoordinates(const
 	SkycatchTerrain(nullptr),
 	Lat(0.0),
 	Lon(0.0),
-	AutoRegisterPolygon(true)
+	AutoRegisterPolygon(true),
+	RequestSerial(0)
 {
 
 }
@@ -584,6 +1855,8 @@ URequestSkycatchTilesetAtCoordinates* URequestSkycatchTilesetAtCoordinates::Requ
 
 void URequestSkycatchTilesetAtCoordinates::Activate()
 {
+	// The request may complete before the request function returns, so its serial is known before listening
+	this->RequestSerial = this->SkycatchTerrain->GetNextRequestSerial();
 	this->SkycatchTerrainEventListener.BindUFunction(this, "Execute");
 	this->SkycatchTerrain->OnTilesetRequestCompleted.Add(this->SkycatchTerrainEventListener);
 
@@ -596,8 +1869,14 @@ void URequestSkycatchTilesetAtCoordinates::Activate()
 
 void URequestSkycatchTilesetAtCoordinates::Execute(bool success, ACesium3DTileset* CesiumTileset, ACesiumCartographicPolygon* CesiumPolygon)
 {
+	//Completions of older requests are ignored, a newer request completing first means this one was superseded
+	const int32 BroadcastSerial = this->SkycatchTerrain->GetBroadcastRequestSerial();
+	if (BroadcastSerial < RequestSerial)
+	{
+		return;
+	}
 	if (OnTilesetRequestCompleted.IsBound())
-		OnTilesetRequestCompleted.Broadcast(success, CesiumTileset, CesiumPolygon);
+		OnTilesetRequestCompleted.Broadcast(success && BroadcastSerial == RequestSerial, CesiumTileset, CesiumPolygon);
 
 	this->SkycatchTerrain->OnTilesetRequestCompleted.Remove(this->SkycatchTerrainEventListener);
 }
@@ -609,7 +1888,8 @@ URequestSkycatchTilesetAtActorLocation::URequestSkycatchTilesetAtActorLocation(c
 	Super(ObjectInitializer),
 	WorldContextObject(nullptr),
 	SkycatchTerrain(nullptr),
-	AutoRegisterPolygon(true)
+	AutoRegisterPolygon(true),
+	RequestSerial(0)
 {
 
 }
@@ -625,6 +1905,8 @@ URequestSkycatchTilesetAtActorLocation* URequestSkycatchTilesetAtActorLocation::
 
 void URequestSkycatchTilesetAtActorLocation::Activate()
 {
+	// The request may complete before the request function returns, so its serial is known before listening
+	this->RequestSerial = this->SkycatchTerrain->GetNextRequestSerial();
 	this->SkycatchTerrainEventListener.BindUFunction(this, "Execute");
 	this->SkycatchTerrain->OnTilesetRequestCompleted.Add(this->SkycatchTerrainEventListener);
 
@@ -637,7 +1919,13 @@ void URequestSkycatchTilesetAtActorLocation::Activate()
 
 void URequestSkycatchTilesetAtActorLocation::Execute(bool success, ACesium3DTileset* CesiumTileset, ACesiumCartographicPolygon* CesiumPolygon)
 {
-	OnTilesetRequestCompleted.Broadcast(success, CesiumTileset, CesiumPolygon);
+	//Completions of older requests are ignored, a newer request completing first means this one was superseded
+	const int32 BroadcastSerial = this->SkycatchTerrain->GetBroadcastRequestSerial();
+	if (BroadcastSerial < RequestSerial)
+	{
+		return;
+	}
+	OnTilesetRequestCompleted.Broadcast(success && BroadcastSerial == RequestSerial, CesiumTileset, CesiumPolygon);
 
 	this->SkycatchTerrain->OnTilesetRequestCompleted.Remove(this->SkycatchTerrainEventListener);
 }
\ No newline at end of file
@@ -0,0 +1,491 @@
+/**
+ * Including the Header libraries and files required
+ **/
+#include "SkycatchVolume.h"
+#include "Cesium3DTileset.h"
+#include "CesiumGeoreference.h"
+#include "Components/PrimitiveComponent.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "Chaos/TriangleMeshImplicitObject.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "SkycatchHeightQuery.h"
+#include "SkycatchSettings.h"
+
+/**
+ * @brief Maximum number of cells of the raster grid, the cells are enlarged above it.
+ */
+static constexpr int64 MaxVolumeCells = 16 * 1024 * 1024;
+
+/**
+ * @brief Height of the cells without geometry.
+ */
+static constexpr float NoHeight = -MAX_FLT;
+
+namespace
+{
+	/**
+	 * @brief Appends the x of the crossings of the polygon edges with the horizontal line at y, sorted.
+	 */
+	void GetPolygonCrossings(const TArray<FVector2D>& Polygon, double Y, TArray<double, TInlineAllocator<16>>& OutCrossings)
+	{
+		OutCrossings.Reset();
+		for (int32 Index = 0, Previous = Polygon.Num() - 1; Index < Polygon.Num(); Previous = Index++)
+		{
+			const FVector2D& A = Polygon[Previous];
+			const FVector2D& B = Polygon[Index];
+			if ((A.Y > Y) != (B.Y > Y))
+			{
+				OutCrossings.Add(A.X + (Y - A.Y) / (B.Y - A.Y) * (B.X - A.X));
+			}
+		}
+		OutCrossings.Sort();
+	}
+}
+
+/**
+ * @brief Integrates the volume of triangles given in a local frame, X and Y horizontal and Z up, all in meters.
+ *
+ * @param TriangleVertices as the vertices of the triangles, three per triangle
+ * @param Polygon as the polygon in the local frame
+ * @param Reference as the reference surface
+ * @param ReferenceHeight as the height of the FixedHeight reference in the local frame
+ * @param CellSize as the size of the raster cells in meters, enlarged when the grid would be too large
+ * @param bSingleThreaded as whether to run on the calling thread only, used to measure the parallel speedup
+ */
+FSkycatchVolumeResult FSkycatchVolume::Integrate(const TArray<FVector3f>& TriangleVertices, const TArray<FVector2D>& Polygon,
+	ESkycatchVolumeReference Reference, double ReferenceHeight, double CellSize, bool bSingleThreaded)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	const EParallelForFlags Flags = bSingleThreaded ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None;
+
+	FSkycatchVolumeResult Result;
+	if (Polygon.Num() < 3 || TriangleVertices.Num() < 3 || CellSize <= 0.0)
+	{
+		return Result;
+	}
+
+	//Lays a grid over the polygon
+	FBox2D Bounds(Polygon);
+	const FVector2D Size = Bounds.GetSize();
+	const double MinCellSize = FMath::Sqrt(Size.X * Size.Y / MaxVolumeCells);
+	CellSize = FMath::Max(CellSize, MinCellSize);
+	const int32 Columns = FMath::Max(1, FMath::CeilToInt(Size.X / CellSize));
+	const int32 Rows = FMath::Max(1, FMath::CeilToInt(Size.Y / CellSize));
+	//Rows are padded to a multiple of 4 cells for the vector accumulation
+	const int32 Stride = Align(Columns, 4);
+	const FVector2D Origin = Bounds.Min;
+
+	//Buckets the triangles by the rows of cell centers they span
+	TArray<TArray<int32>> RowTriangles;
+	RowTriangles.SetNum(Rows);
+	const int32 NumTriangles = TriangleVertices.Num() / 3;
+	for (int32 Triangle = 0; Triangle < NumTriangles; Triangle++)
+	{
+		const FVector3f& A = TriangleVertices[Triangle * 3];
+		const FVector3f& B = TriangleVertices[Triangle * 3 + 1];
+		const FVector3f& C = TriangleVertices[Triangle * 3 + 2];
+		const double MinX = FMath::Min3(A.X, B.X, C.X);
+		const double MaxX = FMath::Max3(A.X, B.X, C.X);
+		if (MaxX < Bounds.Min.X || MinX > Bounds.Max.X)
+		{
+			continue;
+		}
+
+		const int32 FirstRow = FMath::Max(0, FMath::CeilToInt((FMath::Min3(A.Y, B.Y, C.Y) - Origin.Y) / CellSize - 0.5));
+		const int32 LastRow = FMath::Min(Rows - 1, FMath::FloorToInt((FMath::Max3(A.Y, B.Y, C.Y) - Origin.Y) / CellSize - 0.5));
+		for (int32 Row = FirstRow; Row <= LastRow; Row++)
+		{
+			RowTriangles[Row].Add(Triangle);
+		}
+		Result.Triangles += FirstRow <= LastRow ? 1 : 0;
+	}
+
+	//Rasterizes the triangles, every row is written by a single task so no synchronization is needed.
+	//Overlapping triangles keep the highest surface
+	TArray<float> Heights;
+	Heights.Init(NoHeight, Stride * Rows);
+	TArray<uint8> Inside;
+	Inside.SetNumZeroed(Stride * Rows);
+	ParallelFor(Rows, [&](int32 Row)
+	{
+		const double Y = Origin.Y + (Row + 0.5) * CellSize;
+		float* RowHeights = Heights.GetData() + Row * Stride;
+
+		for (const int32 Triangle : RowTriangles[Row])
+		{
+			const FVector3f& A = TriangleVertices[Triangle * 3];
+			const FVector3f& B = TriangleVertices[Triangle * 3 + 1];
+			const FVector3f& C = TriangleVertices[Triangle * 3 + 2];
+			const double Denominator = (B.Y - C.Y) * (A.X - C.X) + (C.X - B.X) * (A.Y - C.Y);
+			if (FMath::Abs(Denominator) < UE_SMALL_NUMBER)
+			{
+				//Vertical triangles have no area to rasterize
+				continue;
+			}
+
+			//Span of the triangle along the row
+			double MinX = MAX_dbl;
+			double MaxX = -MAX_dbl;
+			const FVector3f* Vertices[3] = { &A, &B, &C };
+			for (int32 Edge = 0; Edge < 3; Edge++)
+			{
+				const FVector3f& P = *Vertices[Edge];
+				const FVector3f& Q = *Vertices[(Edge + 1) % 3];
+				if ((P.Y > Y) != (Q.Y > Y))
+				{
+					const double X = P.X + (Y - P.Y) / (Q.Y - P.Y) * (Q.X - P.X);
+					MinX = FMath::Min(MinX, X);
+					MaxX = FMath::Max(MaxX, X);
+				}
+			}
+			const int32 FirstColumn = FMath::Max(0, FMath::CeilToInt((MinX - Origin.X) / CellSize - 0.5));
+			const int32 LastColumn = FMath::Min(Columns - 1, FMath::FloorToInt((MaxX - Origin.X) / CellSize - 0.5));
+
+			for (int32 Column = FirstColumn; Column <= LastColumn; Column++)
+			{
+				const double X = Origin.X + (Column + 0.5) * CellSize;
+				const double WeightA = ((B.Y - C.Y) * (X - C.X) + (C.X - B.X) * (Y - C.Y)) / Denominator;
+				const double WeightB = ((C.Y - A.Y) * (X - C.X) + (A.X - C.X) * (Y - C.Y)) / Denominator;
+				const float Height = WeightA * A.Z + WeightB * B.Z + (1.0 - WeightA - WeightB) * C.Z;
+				RowHeights[Column] = FMath::Max(RowHeights[Column], Height);
+			}
+		}
+
+		//Marks the cells whose center is inside the polygon
+		TArray<double, TInlineAllocator<16>> Crossings;
+		GetPolygonCrossings(Polygon, Y, Crossings);
+		uint8* RowInside = Inside.GetData() + Row * Stride;
+		for (int32 Span = 0; Span + 1 < Crossings.Num(); Span += 2)
+		{
+			const int32 FirstColumn = FMath::Max(0, FMath::CeilToInt((Crossings[Span] - Origin.X) / CellSize - 0.5));
+			const int32 LastColumn = FMath::Min(Columns - 1, FMath::FloorToInt((Crossings[Span + 1] - Origin.X) / CellSize - 0.5));
+			for (int32 Column = FirstColumn; Column <= LastColumn; Column++)
+			{
+				RowInside[Column] = 1;
+			}
+		}
+	}, Flags);
+
+	//Samples the surface along the polygon to fit the reference
+	auto SampleHeight = [&](const FVector2D& Point, float& OutHeight)
+	{
+		const int32 Column = FMath::Clamp(FMath::FloorToInt((Point.X - Origin.X) / CellSize), 0, Columns - 1);
+		const int32 Row = FMath::Clamp(FMath::FloorToInt((Point.Y - Origin.Y) / CellSize), 0, Rows - 1);
+		OutHeight = Heights[Row * Stride + Column];
+		return OutHeight != NoHeight;
+	};
+
+	//Reference plane as Z = PlaneX * X + PlaneY * Y + PlaneZ
+	double PlaneX = 0.0;
+	double PlaneY = 0.0;
+	double PlaneZ = ReferenceHeight;
+	if (Reference != ESkycatchVolumeReference::FixedHeight)
+	{
+		TArray<FVector> Samples;
+		for (int32 Index = 0, Previous = Polygon.Num() - 1; Index < Polygon.Num(); Previous = Index++)
+		{
+			const FVector2D& A = Polygon[Previous];
+			const FVector2D& B = Polygon[Index];
+			const int32 Steps = FMath::Max(1, FMath::CeilToInt(FVector2D::Distance(A, B) / CellSize));
+			for (int32 Step = 0; Step < Steps; Step++)
+			{
+				const FVector2D Point = FMath::Lerp(A, B, (double)Step / Steps);
+				float Height;
+				if (SampleHeight(Point, Height))
+				{
+					Samples.Add(FVector(Point.X, Point.Y, Height));
+				}
+			}
+		}
+		if (Samples.Num() == 0)
+		{
+			UE_LOG(LogSkycatch, Warning, TEXT("No loaded geometry along the polygon to fit the volume reference"));
+			return Result;
+		}
+
+		double Lowest = MAX_dbl;
+		for (const FVector& Sample : Samples)
+		{
+			Lowest = FMath::Min(Lowest, Sample.Z);
+		}
+		PlaneZ = Lowest;
+
+		//Least squares fit of the plane, relative to the center of the samples for a well conditioned system
+		if (Reference == ESkycatchVolumeReference::BoundaryPlane && Samples.Num() >= 3)
+		{
+			FVector Center = FVector::ZeroVector;
+			for (const FVector& Sample : Samples)
+			{
+				Center += Sample;
+			}
+			Center /= Samples.Num();
+
+			double XX = 0.0, XY = 0.0, YY = 0.0, XZ = 0.0, YZ = 0.0;
+			for (const FVector& Sample : Samples)
+			{
+				const FVector Offset = Sample - Center;
+				XX += Offset.X * Offset.X;
+				XY += Offset.X * Offset.Y;
+				YY += Offset.Y * Offset.Y;
+				XZ += Offset.X * Offset.Z;
+				YZ += Offset.Y * Offset.Z;
+			}
+			const double Determinant = XX * YY - XY * XY;
+			if (FMath::Abs(Determinant) > UE_SMALL_NUMBER)
+			{
+				PlaneX = (XZ * YY - YZ * XY) / Determinant;
+				PlaneY = (YZ * XX - XZ * XY) / Determinant;
+				PlaneZ = Center.Z - PlaneX * Center.X - PlaneY * Center.Y;
+			}
+		}
+	}
+
+	//Integrates the rows, four cells at a time. Cells outside the polygon or without geometry are set to the
+	//reference so they add nothing
+	struct FRowSums
+	{
+		double Cut = 0.0;
+		double Fill = 0.0;
+		double Reference = 0.0;
+		int32 Covered = 0;
+		int32 Inside = 0;
+	};
+	TArray<FRowSums> RowSums;
+	RowSums.SetNum(Rows);
+	ParallelFor(Rows, [&](int32 Row)
+	{
+		const double Y = Origin.Y + (Row + 0.5) * CellSize;
+		float* RowHeights = Heights.GetData() + Row * Stride;
+		const uint8* RowInside = Inside.GetData() + Row * Stride;
+		FRowSums& Sums = RowSums[Row];
+
+		TArray<float, TInlineAllocator<1024>> RowReference;
+		RowReference.SetNumUninitialized(Stride);
+		for (int32 Column = 0; Column < Stride; Column++)
+		{
+			const double X = Origin.X + (Column + 0.5) * CellSize;
+			RowReference[Column] = PlaneX * X + PlaneY * Y + PlaneZ;
+
+			const bool bInside = Column < Columns && RowInside[Column];
+			const bool bCovered = bInside && RowHeights[Column] != NoHeight;
+			Sums.Inside += bInside ? 1 : 0;
+			Sums.Covered += bCovered ? 1 : 0;
+			Sums.Reference += bCovered ? RowReference[Column] : 0.0;
+			if (!bCovered)
+			{
+				RowHeights[Column] = RowReference[Column];
+			}
+		}
+
+		VectorRegister4Float Cut = VectorZeroFloat();
+		VectorRegister4Float Fill = VectorZeroFloat();
+		const VectorRegister4Float Zero = VectorZeroFloat();
+		for (int32 Column = 0; Column < Stride; Column += 4)
+		{
+			const VectorRegister4Float Difference = VectorSubtract(VectorLoad(RowHeights + Column), VectorLoad(RowReference.GetData() + Column));
+			Cut = VectorAdd(Cut, VectorMax(Difference, Zero));
+			Fill = VectorAdd(Fill, VectorMax(VectorNegate(Difference), Zero));
+		}
+
+		alignas(16) float CutLanes[4];
+		alignas(16) float FillLanes[4];
+		VectorStoreAligned(Cut, CutLanes);
+		VectorStoreAligned(Fill, FillLanes);
+		Sums.Cut = (double)CutLanes[0] + CutLanes[1] + CutLanes[2] + CutLanes[3];
+		Sums.Fill = (double)FillLanes[0] + FillLanes[1] + FillLanes[2] + FillLanes[3];
+	}, Flags);
+
+	double Cut = 0.0;
+	double Fill = 0.0;
+	double ReferenceSum = 0.0;
+	int64 Covered = 0;
+	int64 InsideCells = 0;
+	for (const FRowSums& Sums : RowSums)
+	{
+		Cut += Sums.Cut;
+		Fill += Sums.Fill;
+		ReferenceSum += Sums.Reference;
+		Covered += Sums.Covered;
+		InsideCells += Sums.Inside;
+	}
+
+	const double CellArea = CellSize * CellSize;
+	Result.bValid = Covered > 0;
+	Result.CutVolume = Cut * CellArea;
+	Result.FillVolume = Fill * CellArea;
+	Result.NetVolume = Result.CutVolume - Result.FillVolume;
+	Result.Area = Covered * CellArea;
+	Result.Coverage = InsideCells > 0 ? (float)Covered / InsideCells : 0.0f;
+	Result.ReferenceHeight = Covered > 0 ? ReferenceSum / Covered : PlaneZ;
+	Result.CellSize = CellSize;
+	Result.ComputeMilliseconds = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	return Result;
+}
+
+/**
+ * @brief Computes the volume of the loaded tiles of a tileset inside a polygon. The tiles are measured in a plane
+ * tangent to the ellipsoid at the center of the polygon, from the physics meshes of the tiles that are shown.
+ *
+ * @param Tileset as the tileset to measure
+ * @param Georeference as the georeference of the polygon
+ * @param PolygonLongitudeLatitude as the polygon, with the longitude in X and the latitude in Y
+ * @param Reference as the reference surface
+ * @param ReferenceHeight as the height in meters above the WGS84 ellipsoid of the FixedHeight reference
+ * @param CellSize as the size of the raster cells in meters
+ */
+FSkycatchVolumeResult FSkycatchVolume::Compute(const ACesium3DTileset* Tileset, const ACesiumGeoreference* Georeference,
+	const TArray<FVector2D>& PolygonLongitudeLatitude, ESkycatchVolumeReference Reference, double ReferenceHeight, double CellSize)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	if (!Tileset || !Georeference || PolygonLongitudeLatitude.Num() < 3)
+	{
+		return FSkycatchVolumeResult();
+	}
+
+	//Local frame tangent to the ellipsoid at the center of the polygon, in meters
+	const FVector2D Center = FBox2D(PolygonLongitudeLatitude).GetCenter();
+	TArray<FVector> FramePoints = {
+		FVector(Center.X, Center.Y, 0.0), FVector(Center.X, Center.Y, 1.0), FVector(Center.X, Center.Y + 0.0001, 0.0) };
+	for (const FVector2D& Point : PolygonLongitudeLatitude)
+	{
+		FramePoints.Add(FVector(Point.X, Point.Y, 0.0));
+	}
+	TArray<FVector> FrameLocations;
+	FSkycatchHeightCache::TransformToUnreal(Georeference, FramePoints, FrameLocations);
+
+	const FVector Origin = FrameLocations[0];
+	const FVector Up = (FrameLocations[1] - Origin).GetSafeNormal();
+	const FVector North = FVector::VectorPlaneProject(FrameLocations[2] - Origin, Up).GetSafeNormal();
+	const FVector East = FVector::CrossProduct(North, Up);
+	auto ToLocal = [&Origin, &Up, &North, &East](const FVector& Location)
+	{
+		const FVector Offset = (Location - Origin) / 100.0;
+		return FVector3f(FVector::DotProduct(Offset, East), FVector::DotProduct(Offset, North), FVector::DotProduct(Offset, Up));
+	};
+
+	TArray<FVector2D> Polygon;
+	for (int32 Index = 3; Index < FrameLocations.Num(); Index++)
+	{
+		const FVector3f Local = ToLocal(FrameLocations[Index]);
+		Polygon.Add(FVector2D(Local.X, Local.Y));
+	}
+	if (Polygon.Num() > 1 && Polygon[0].Equals(Polygon.Last(), 1e-3))
+	{
+		Polygon.Pop();
+	}
+	const FBox2D PolygonBounds(Polygon);
+
+	//Gathers the triangles of the physics meshes of the tiles shown over the polygon
+	TArray<const UPrimitiveComponent*> Tiles;
+	TInlineComponentArray<UPrimitiveComponent*> Components(Tileset);
+	for (UPrimitiveComponent* Component : Components)
+	{
+		if (Component->IsVisible() && Component->GetBodySetup())
+		{
+			Tiles.Add(Component);
+		}
+	}
+
+	TArray<TArray<FVector3f>> TileTriangles;
+	TileTriangles.SetNum(Tiles.Num());
+	ParallelFor(Tiles.Num(), [&](int32 Tile)
+	{
+		const FTransform Transform = Tiles[Tile]->GetComponentTransform();
+		UBodySetup* BodySetup = const_cast<UPrimitiveComponent*>(Tiles[Tile])->GetBodySetup();
+		for (const auto& TriMesh : BodySetup->ChaosTriMeshes)
+		{
+			const auto& Particles = TriMesh->Particles();
+			auto AddTriangles = [&](const auto& Indices)
+			{
+				for (const auto& Triangle : Indices)
+				{
+					const FVector3f A = ToLocal(Transform.TransformPosition(FVector(Particles.X(Triangle[0]))));
+					const FVector3f B = ToLocal(Transform.TransformPosition(FVector(Particles.X(Triangle[1]))));
+					const FVector3f C = ToLocal(Transform.TransformPosition(FVector(Particles.X(Triangle[2]))));
+					if (FMath::Max3(A.X, B.X, C.X) >= PolygonBounds.Min.X && FMath::Min3(A.X, B.X, C.X) <= PolygonBounds.Max.X &&
+						FMath::Max3(A.Y, B.Y, C.Y) >= PolygonBounds.Min.Y && FMath::Min3(A.Y, B.Y, C.Y) <= PolygonBounds.Max.Y)
+					{
+						TileTriangles[Tile].Append({ A, B, C });
+					}
+				}
+			};
+			if (TriMesh->Elements().RequiresLargeIndices())
+			{
+				AddTriangles(TriMesh->Elements().GetLargeIndexBuffer());
+			}
+			else
+			{
+				AddTriangles(TriMesh->Elements().GetSmallIndexBuffer());
+			}
+		}
+	});
+
+	TArray<FVector3f> Triangles;
+	for (TArray<FVector3f>& Tile : TileTriangles)
+	{
+		Triangles.Append(MoveTemp(Tile));
+	}
+
+	//The fixed height is above the ellipsoid, which is the local origin at the center of the polygon
+	FSkycatchVolumeResult Result = Integrate(Triangles, Polygon, Reference, ReferenceHeight, CellSize);
+	Result.ComputeMilliseconds = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	UE_LOG(LogSkycatch, Display, TEXT("Volume over %d triangles: cut %.1f m3, fill %.1f m3, %.0f%% covered, in %.1f ms"),
+		Result.Triangles, Result.CutVolume, Result.FillVolume, Result.Coverage * 100.0f, Result.ComputeMilliseconds);
+	return Result;
+}
+
+/**
+ * @brief Measures the volume computation over a synthetic mesh: a cone shaped stockpile on flat ground, whose volume
+ * is known. Usage: Skycatch.BenchmarkVolume [QuadsPerSide=1000] [CellSize=0.25]
+ */
+static FAutoConsoleCommand BenchmarkVolumeCommand(
+	TEXT("Skycatch.BenchmarkVolume"),
+	TEXT("Measures the volume computation over a synthetic stockpile mesh. Usage: Skycatch.BenchmarkVolume [QuadsPerSide=1000] [CellSize=0.25]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 QuadsPerSide = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000;
+		const double CellSize = Args.Num() > 1 ? FCString::Atod(*Args[1]) : 0.25;
+		const double Extent = 250.0;
+		const double Radius = 100.0;
+		const double PeakHeight = 20.0;
+
+		//Heightfield of a cone on flat ground, two triangles per quad
+		auto HeightAt = [=](double X, double Y)
+		{
+			return FMath::Max(0.0, PeakHeight * (1.0 - FMath::Sqrt(X * X + Y * Y) / Radius));
+		};
+		const double QuadSize = 2.0 * Extent / QuadsPerSide;
+		TArray<FVector3f> Triangles;
+		Triangles.Reserve(QuadsPerSide * QuadsPerSide * 6);
+		for (int32 Row = 0; Row < QuadsPerSide; Row++)
+		{
+			for (int32 Column = 0; Column < QuadsPerSide; Column++)
+			{
+				const double X0 = -Extent + Column * QuadSize;
+				const double Y0 = -Extent + Row * QuadSize;
+				const FVector3f A(X0, Y0, HeightAt(X0, Y0));
+				const FVector3f B(X0 + QuadSize, Y0, HeightAt(X0 + QuadSize, Y0));
+				const FVector3f C(X0 + QuadSize, Y0 + QuadSize, HeightAt(X0 + QuadSize, Y0 + QuadSize));
+				const FVector3f D(X0, Y0 + QuadSize, HeightAt(X0, Y0 + QuadSize));
+				Triangles.Append({ A, B, C, A, C, D });
+			}
+		}
+
+		TArray<FVector2D> Polygon;
+		for (int32 Index = 0; Index < 64; Index++)
+		{
+			const double Angle = 2.0 * PI * Index / 64;
+			Polygon.Add(FVector2D(FMath::Cos(Angle), FMath::Sin(Angle)) * Radius * 1.5);
+		}
+
+		const double Expected = PI * Radius * Radius * PeakHeight / 3.0;
+		const FSkycatchVolumeResult Serial = FSkycatchVolume::Integrate(Triangles, Polygon, ESkycatchVolumeReference::BoundaryPlane, 0.0, CellSize, true);
+		const FSkycatchVolumeResult Parallel = FSkycatchVolume::Integrate(Triangles, Polygon, ESkycatchVolumeReference::BoundaryPlane, 0.0, CellSize);
+
+		UE_LOG(LogSkycatch, Display, TEXT("Volume benchmark: %d triangles, %.2f m cells"), Parallel.Triangles, Parallel.CellSize);
+		UE_LOG(LogSkycatch, Display, TEXT("  single threaded: %.1f ms, parallel: %.1f ms (%.1fx)"),
+			Serial.ComputeMilliseconds, Parallel.ComputeMilliseconds, Serial.ComputeMilliseconds / FMath::Max(Parallel.ComputeMilliseconds, 0.001f));
+		UE_LOG(LogSkycatch, Display, TEXT("  cut %.1f m3, expected %.1f m3 (%.2f%% error)"),
+			Parallel.CutVolume, Expected, 100.0 * FMath::Abs(Parallel.CutVolume - Expected) / Expected);
+	}));
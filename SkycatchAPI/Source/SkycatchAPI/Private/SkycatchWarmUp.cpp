@@ -0,0 +1,176 @@
+/**
+ * Including the Header libraries and files required
+ **/
+#include "SkycatchWarmUp.h"
+#include "CesiumRuntime.h"
+#include "CesiumAsync/AsyncSystem.h"
+#include "CesiumAsync/IAssetAccessor.h"
+#include "CesiumAsync/IAssetRequest.h"
+#include "CesiumAsync/IAssetResponse.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "SkycatchEndpoints.h"
+#include "SkycatchSiteCache.h"
+#include "SkycatchSettings.h"
+#include "SkycatchTerrain.h"
+
+/**
+ * @brief Returns the process wide warm up.
+ */
+FSkycatchWarmUp& FSkycatchWarmUp::Get()
+{
+	static FSkycatchWarmUp WarmUp;
+	return WarmUp;
+}
+
+/**
+ * @brief Starts the warm up on the next tick of the engine. Does nothing when it already started.
+ */
+void FSkycatchWarmUp::Start()
+{
+	if (Stats.bStarted || StartTickerHandle.IsValid())
+	{
+		return;
+	}
+
+	//The modules load before the engine ticks, the warm up waits for it so the startup isn't delayed
+	StartTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([this](float)
+	{
+		StartTickerHandle.Reset();
+		Run();
+		return false;
+	}));
+}
+
+/**
+ * @brief Cancels the warm up if it didn't start yet. Called when the plugin stops.
+ */
+void FSkycatchWarmUp::Shutdown()
+{
+	if (StartTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(StartTickerHandle);
+		StartTickerHandle.Reset();
+	}
+}
+
+/**
+ * @brief Runs the steps of the warm up.
+ */
+void FSkycatchWarmUp::Run()
+{
+	const USkycatchSettings* Settings = GetDefault<USkycatchSettings>();
+	Stats.bStarted = true;
+	StartTime = FPlatformTime::Seconds();
+
+	//The connections and the saved sites are warmed up at the same time
+	PendingSteps = 2;
+	FSkycatchEndpointPool::Get().ProbeEndpoints([this]()
+	{
+		Stats.ConnectSeconds = GetElapsedSeconds();
+		CompleteStep();
+	});
+
+	if (Settings->bPersistSiteCache)
+	{
+		FSkycatchSiteCache::Get().LoadAsync([this](int32 LoadedSites)
+		{
+			Stats.LoadSeconds = GetElapsedSeconds();
+			Stats.LoadedSites = LoadedSites;
+
+			//The home sites saved by the previous session are served from the cache
+			PrefetchHomeSites();
+			CompleteStep();
+		});
+	}
+	else
+	{
+		PrefetchHomeSites();
+		CompleteStep();
+	}
+}
+
+/**
+ * @brief Looks up the home sites, and fetches their root tilesets.
+ */
+void FSkycatchWarmUp::PrefetchHomeSites()
+{
+	const USkycatchSettings* Settings = GetDefault<USkycatchSettings>();
+	for (const FVector2D& HomeSite : Settings->HomeSites)
+	{
+		PendingSteps++;
+		const FString Params = ASkycatchTerrain::MakeQueryParams(HomeSite.Y, HomeSite.X);
+		FSkycatchSiteCache::Get().Lookup(Params, FOnSiteLookupCompleted::CreateLambda([this](bool bConnected, int32 ResponseCode, const FString& Content)
+		{
+			if (bConnected && ResponseCode == 200)
+			{
+				Stats.HomeSites++;
+
+				//The site cache ranked the tiles, the first one is the tileset shown for the site
+				TArray<TSharedPtr<FJsonValue>> Tiles;
+				const TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(Content);
+				FString TilesetUrl;
+				if (GetDefault<USkycatchSettings>()->bPrefetchHomeTilesets && FJsonSerializer::Deserialize(JsonReader, Tiles) && Tiles.Num() > 0 &&
+					Tiles[0]->AsObject().IsValid() && Tiles[0]->AsObject()->TryGetStringField(TEXT("tilesetUrl"), TilesetUrl))
+				{
+					PrefetchTileset(TilesetUrl);
+				}
+			}
+			CompleteStep();
+		}));
+	}
+}
+
+/**
+ * @brief Fetches the root tileset.json of a site through the Cesium asset accessor, so it lands in the Cesium
+ * request cache the tileset reads from.
+ *
+ * @param Url as the url of the tileset
+ */
+void FSkycatchWarmUp::PrefetchTileset(const FString& Url)
+{
+	PendingSteps++;
+	getAssetAccessor()->get(getAsyncSystem(), TCHAR_TO_UTF8(*Url))
+		.thenInMainThread([this, Url](std::shared_ptr<CesiumAsync::IAssetRequest>&& pRequest)
+		{
+			const CesiumAsync::IAssetResponse* pResponse = pRequest->response();
+			if (pResponse && pResponse->statusCode() >= 200 && pResponse->statusCode() < 300)
+			{
+				Stats.HomeTilesets++;
+			}
+			else
+			{
+				UE_LOG(LogSkycatch, Warning, TEXT("Warm up could not fetch tileset %s"), *Url);
+			}
+			CompleteStep();
+		})
+		.catchInMainThread([this, Url](std::exception&& Exception)
+		{
+			UE_LOG(LogSkycatch, Warning, TEXT("Warm up could not fetch tileset %s: %s"), *Url, UTF8_TO_TCHAR(Exception.what()));
+			CompleteStep();
+		});
+}
+
+/**
+ * @brief Marks a step of the warm up as completed, and the warm up as ready once none is left.
+ */
+void FSkycatchWarmUp::CompleteStep()
+{
+	if (--PendingSteps > 0 || Stats.bReady)
+	{
+		return;
+	}
+
+	Stats.bReady = true;
+	Stats.TimeToReadySeconds = GetElapsedSeconds();
+	UE_LOG(LogSkycatch, Display, TEXT("Warm up ready in %.2f s: endpoints connected in %.2f s, %d saved sites loaded, %d home sites and %d tilesets prefetched"),
+		Stats.TimeToReadySeconds, Stats.ConnectSeconds, Stats.LoadedSites, Stats.HomeSites, Stats.HomeTilesets);
+}
+
+/**
+ * @brief Returns the seconds since the warm up started.
+ */
+float FSkycatchWarmUp::GetElapsedSeconds() const
+{
+	return FPlatformTime::Seconds() - StartTime;
+}
@@ -19,4 +19,11 @@ public:
 	 ** @brief Function executed when the plugin stops 
 	 **/
 	virtual void ShutdownModule() override;
+
+private:
+
+	/**
+	 ** @brief Handle of the function that saves the site cache before the engine exits
+	 **/
+	FDelegateHandle PreExitHandle;
 };
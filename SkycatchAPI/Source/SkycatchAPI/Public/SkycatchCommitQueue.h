@@ -0,0 +1,162 @@
+#pragma once
+
+/**
+ * Including the Header libraries and files required
+ **/
+#include "CoreMinimal.h"
+#include "SkycatchCommitQueue.generated.h"
+
+/**
+ * @brief Time spent committing resolved sites to the world and the depth of the commit queue.
+ */
+USTRUCT(BlueprintType)
+struct SKYCATCHAPI_API FSkycatchCommitStats
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief Commits waiting or in progress.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchCommit)
+	int32 QueueDepth = 0;
+
+	/**
+	 * @brief Largest number of commits that were waiting at the same time.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchCommit)
+	int32 PeakQueueDepth = 0;
+
+	/**
+	 * @brief Commits completed since the world started.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchCommit)
+	int32 CompletedCommits = 0;
+
+	/**
+	 * @brief Frames in which the commits took more than twice the budget, because a step could not be split.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchCommit)
+	int32 Hitches = 0;
+
+	/**
+	 * @brief Milliseconds spent committing in the last frame that had commits.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchCommit)
+	float LastFrameMilliseconds = 0.0f;
+
+	/**
+	 * @brief Longest time in milliseconds a single step of a commit took.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchCommit)
+	float MaxStepMilliseconds = 0.0f;
+
+	/**
+	 * @brief Average seconds from the enqueue of a commit to its completion.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchCommit)
+	float AverageLatencySeconds = 0.0f;
+};
+
+/**
+ * @brief Result of a step of a commit.
+ */
+enum class ESkycatchCommitStep : uint8
+{
+	/** The commit has more steps to run */
+	Continue,
+	/** The commit waits for work running on other threads, the next commits run until the next frame */
+	Wait,
+	/** The commit is completed */
+	Completed
+};
+
+/**
+ * @brief Spreads the game thread work of the resolved sites over frames. A commit is split in steps, and every
+ * frame the steps of the commits closest to the player views run until the budget of the frame is spent.
+ */
+class SKYCATCHAPI_API FSkycatchCommitQueue
+{
+public:
+
+	/**
+	 * @brief Step of a commit, returns whether the commit continues, waits or is completed.
+	 */
+	typedef TFunction<ESkycatchCommitStep()> FStep;
+
+	/**
+	 * @brief Called when a commit is cancelled or replaced before it is completed.
+	 */
+	typedef TFunction<void()> FCancelled;
+
+	/**
+	 * @brief Adds a commit, replacing the commit of the same owner that is still queued.
+	 *
+	 * @param Owner as the object the commit works on, the commit is dropped when it is destroyed
+	 * @param Location as the location of the commit in Unreal coordinates, the closest to the views run first
+	 * @param Step as the step run until the commit is completed
+	 * @param OnCancelled as the function called if the commit is cancelled or replaced before it is completed
+	 */
+	void Enqueue(UObject* Owner, const FVector& Location, FStep Step, FCancelled OnCancelled = nullptr);
+
+	/**
+	 * @brief Drops the commit of an owner, calling its cancel function.
+	 *
+	 * @param Owner as the owner of the commit
+	 */
+	void Cancel(const UObject* Owner);
+
+	/**
+	 * @brief Runs the steps of the commits until the budget is spent. At least one step runs every frame, so the
+	 * queue always makes progress.
+	 *
+	 * @param ViewLocations as the locations of the player views
+	 * @param BudgetMilliseconds as the time the commits can take this frame
+	 */
+	void Run(const TArray<FVector>& ViewLocations, float BudgetMilliseconds);
+
+	/**
+	 * @brief Returns the number of commits waiting or in progress.
+	 */
+	int32 Num() const { return Commits.Num(); }
+
+	/**
+	 * @brief Returns the stats of the queue.
+	 */
+	const FSkycatchCommitStats& GetStats() const { return Stats; }
+
+private:
+
+	/**
+	 * @brief Commit waiting or in progress.
+	 */
+	struct FCommit
+	{
+		TWeakObjectPtr<UObject> Owner;
+		FVector Location;
+		FStep Step;
+		FCancelled OnCancelled;
+		double EnqueueTime = 0.0;
+	};
+
+	/**
+	 * @brief Runs one step of a commit and removes it once completed.
+	 *
+	 * @param Index as the index of the commit
+	 */
+	ESkycatchCommitStep RunStep(int32 Index);
+
+	/**
+	 * @brief Commits waiting or in progress.
+	 */
+	TArray<FCommit> Commits;
+
+	/**
+	 * @brief Stats of the queue.
+	 */
+	FSkycatchCommitStats Stats;
+
+	/**
+	 * @brief Sum of the latencies of the completed commits, to average them.
+	 */
+	double TotalLatencySeconds = 0.0;
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+/**
+ * Including the Header libraries and files required
+ **/
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "SkycatchEndpoints.generated.h"
+
+/**
+ * @brief Health and latency statistics of one of the configured Skycatch services endpoints.
+ */
+USTRUCT(BlueprintType)
+struct SKYCATCHAPI_API FSkycatchEndpointStats
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief Endpoint route as configured in the plugin settings.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchEndpoints)
+	FString Endpoint;
+
+	/**
+	 * @brief Whether the endpoint is currently selectable for lookups.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchEndpoints)
+	bool bHealthy = true;
+
+	/**
+	 * @brief Exponentially weighted moving average of the response latency, in milliseconds.
+	 * Negative while the endpoint has not answered yet.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchEndpoints)
+	float LatencyMs = -1.0f;
+
+	/**
+	 * @brief Number of lookups and probes answered by the endpoint.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchEndpoints)
+	int32 Successes = 0;
+
+	/**
+	 * @brief Number of lookups and probes that failed to connect or got a server error.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchEndpoints)
+	int32 Failures = 0;
+
+	/**
+	 * @brief Number of failures since the last success.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchEndpoints)
+	int32 ConsecutiveFailures = 0;
+
+	/**
+	 * @brief Platform time of the last failure, used to retry unhealthy endpoints after a cooldown.
+	 */
+	double LastFailureTime = 0.0;
+};
+
+/**
+ * @brief Keeps track of the configured Skycatch services endpoints (the main one and its mirrors), probes their
+ * health, tracks their latency and selects the fastest healthy one for every lookup.
+ */
+class SKYCATCHAPI_API FSkycatchEndpointPool
+{
+public:
+
+	/**
+	 * @brief Returns the process wide endpoint pool.
+	 */
+	static FSkycatchEndpointPool& Get();
+
+	/**
+	 * @brief Stops the periodic health probing. Called when the plugin stops.
+	 */
+	void Shutdown();
+
+	/**
+	 * @brief Selects the healthy endpoint with the lowest latency. Endpoints that have not answered yet are tried
+	 * first, and unhealthy ones become selectable again once the retry cooldown elapsed.
+	 * Returns an empty string when every endpoint is excluded.
+	 *
+	 * @param Excluded as the endpoints already tried for the current lookup
+	 */
+	FString SelectEndpoint(const TArray<FString>& Excluded = TArray<FString>());
+
+	/**
+	 * @brief Records an answer of an endpoint and updates its latency average.
+	 *
+	 * @param Endpoint as the endpoint that answered
+	 * @param LatencySeconds as the time it took to answer
+	 */
+	void ReportSuccess(const FString& Endpoint, double LatencySeconds);
+
+	/**
+	 * @brief Records a connection failure or server error of an endpoint, marking it unhealthy.
+	 *
+	 * @param Endpoint as the endpoint that failed
+	 */
+	void ReportFailure(const FString& Endpoint);
+
+	/**
+	 * @brief Sends a lightweight request to every configured endpoint to refresh its health and latency. This also
+	 * resolves and opens the connections to the endpoints, which the following lookups reuse.
+	 *
+	 * @param OnProbed as the callback executed once every endpoint answered or failed
+	 */
+	void ProbeEndpoints(TFunction<void()> OnProbed = nullptr);
+
+	/**
+	 * @brief Returns the statistics of every configured endpoint, in the order of the plugin settings.
+	 */
+	TArray<FSkycatchEndpointStats> GetStats();
+
+private:
+
+	/**
+	 * @brief Rebuilds the endpoint list from the plugin settings, keeping the statistics of known endpoints.
+	 */
+	void SyncWithSettings();
+
+	/**
+	 * @brief Starts or stops the periodic health probing according to the plugin settings.
+	 */
+	void UpdateProbeTicker();
+
+	/**
+	 * @brief Statistics of the configured endpoints, in the order of the plugin settings.
+	 */
+	TArray<FSkycatchEndpointStats> Endpoints;
+
+	/**
+	 * @brief Handle of the periodic health probing ticker.
+	 */
+	FTSTicker::FDelegateHandle ProbeTickerHandle;
+
+	/**
+	 * @brief Probe interval the ticker was registered with.
+	 */
+	float ProbeTickerInterval = 0.0f;
+};
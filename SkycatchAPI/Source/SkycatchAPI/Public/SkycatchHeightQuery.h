@@ -0,0 +1,114 @@
+#pragma once
+
+/**
+ * Including the Header libraries and files required
+ **/
+#include "CoreMinimal.h"
+#include "GenericQuadTree.h"
+#include "SkycatchHeightQuery.generated.h"
+
+class ACesium3DTileset;
+class ACesiumGeoreference;
+class UPrimitiveComponent;
+
+/**
+ * @brief Height of the survey surface at a longitude, latitude.
+ */
+USTRUCT(BlueprintType)
+struct SKYCATCHAPI_API FSkycatchHeightSample
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief Whether the surface was found under the point.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	bool bHit = false;
+
+	/**
+	 * @brief Location of the surface in UE world coordinates.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	FVector Location = FVector::ZeroVector;
+
+	/**
+	 * @brief Height of the surface in meters above the WGS84 ellipsoid.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	double Height = 0.0;
+};
+
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnSkycatchHeightsQueried, const TArray<FSkycatchHeightSample>&, Samples);
+
+/**
+ * @brief Answers height queries with vertical traces against the loaded tiles of a tileset. The answers are cached in
+ * a quadtree per tile, dropped when the tile unloads.
+ */
+class SKYCATCHAPI_API FSkycatchHeightCache
+{
+public:
+
+	/**
+	 * @brief Transforms longitude, latitude and height points to UE world coordinates in one batch, computing the
+	 * transform of the georeference once for all of them.
+	 *
+	 * @param Georeference as the georeference of the points
+	 * @param LongitudeLatitudeHeight as the points to transform
+	 * @param OutLocations as the transformed points
+	 */
+	static void TransformToUnreal(const ACesiumGeoreference* Georeference, const TArray<FVector>& LongitudeLatitudeHeight, TArray<FVector>& OutLocations);
+
+	/**
+	 * @brief Finds the surface under the given points among the tiles of the tileset that are shown and collide.
+	 * Points without such a tile under them are left unresolved, to be retried once more tiles are loaded.
+	 *
+	 * @param Tileset as the tileset to trace
+	 * @param Georeference as the georeference of the points
+	 * @param LongitudeLatitude as the points of the query, in longitude, latitude
+	 * @param Indices as the indices of the points to resolve
+	 * @param Samples as the samples of the query, written for the resolved points
+	 * @param OutUnresolved as the indices of the points without a loaded tile under them
+	 */
+	void Resolve(const ACesium3DTileset* Tileset, const ACesiumGeoreference* Georeference, const TArray<FVector2D>& LongitudeLatitude,
+		const TArray<int32>& Indices, TArray<FSkycatchHeightSample>& Samples, TArray<int32>& OutUnresolved);
+
+	/**
+	 * @brief Drops the cached heights of the tiles that were unloaded.
+	 */
+	void Prune();
+
+	/**
+	 * @brief Drops all the cached heights.
+	 */
+	void Empty();
+
+	/**
+	 * @brief Returns the number of cached heights.
+	 */
+	int32 GetNumCached() const;
+
+private:
+
+	/**
+	 * @brief Surface found under a point.
+	 */
+	struct FCachedHeight
+	{
+		FVector2D Point;
+		FSkycatchHeightSample Sample;
+	};
+
+	/**
+	 * @brief Heights found on a tile.
+	 */
+	struct FTileHeights
+	{
+		TUniquePtr<TQuadTree<FCachedHeight>> Heights;
+		int32 Num = 0;
+	};
+
+	/**
+	 * @brief Cached heights by tile primitive.
+	 */
+	TMap<TWeakObjectPtr<UPrimitiveComponent>, FTileHeights> Tiles;
+};
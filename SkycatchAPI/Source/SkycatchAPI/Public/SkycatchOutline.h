@@ -0,0 +1,136 @@
+#pragma once
+
+/**
+ * Including the Header libraries and files required
+ **/
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+
+/**
+ * @brief Outline of a site with every ring of its GeoJSON Polygon or MultiPolygon, in longitude and latitude. The
+ * rings are kept back to back in one buffer, the outer ring of each part first. Build bridges the holes and the
+ * parts into one ring, which a single CesiumCartographicPolygon clips with the holes respected.
+ */
+class SKYCATCHAPI_API FSkycatchOutline
+{
+public:
+
+	/**
+	 * @brief Parses a GeoJSON Feature, Polygon or MultiPolygon. Returns false when the geometry has no ring.
+	 *
+	 * @param Geometry as the json object of the geometry
+	 */
+	bool Parse(const TSharedPtr<FJsonObject>& Geometry);
+
+	/**
+	 * @brief Parses a single ring in longitude, latitude and height, as kept by the actors and replicated.
+	 *
+	 * @param LongitudeLatitudeHeight as the ring
+	 */
+	void SetRing(const TArray<FVector>& LongitudeLatitudeHeight);
+
+	/**
+	 * @brief Orients the rings, computes the bounds of the parts and bridges the rings into one. Can run on any thread.
+	 */
+	void Build();
+
+	/**
+	 * @brief Removes all the rings.
+	 */
+	void Reset();
+
+	/**
+	 * @brief Returns the number of parts, each being an outer ring and its holes.
+	 */
+	int32 NumParts() const { return FMath::Max(0, PartStarts.Num() - 1); }
+
+	/**
+	 * @brief Returns the number of rings of all the parts.
+	 */
+	int32 NumRings() const { return FMath::Max(0, RingStarts.Num() - 1); }
+
+	/**
+	 * @brief Returns the points of a ring, without the closing point.
+	 *
+	 * @param Ring as the index of the ring
+	 */
+	TArrayView<const FVector2D> GetRing(int32 Ring) const;
+
+	/**
+	 * @brief Returns every ring as its own array, to be combined with the even-odd rule.
+	 */
+	TArray<TArray<FVector2D>> GetRings() const;
+
+	/**
+	 * @brief Returns the rings of a part as their own arrays, the outer ring first.
+	 *
+	 * @param Part as the index of the part
+	 */
+	TArray<TArray<FVector2D>> GetPartRings(int32 Part) const;
+
+	/**
+	 * @brief Returns the bounds of each part, computed by Build.
+	 */
+	const TArray<FBox2D>& GetPartBounds() const { return PartBounds; }
+
+	/**
+	 * @brief Returns the bounds of all the parts, computed by Build.
+	 */
+	FBox2D GetBounds() const;
+
+	/**
+	 * @brief Returns the single ring bridging every ring in longitude, latitude and height, computed by Build. Its
+	 * bridges are traversed once in each direction, so it encloses the same area as the rings with the even-odd rule.
+	 */
+	const TArray<FVector>& GetLongitudeLatitudeHeight() const { return Bridged; }
+
+private:
+
+	/**
+	 * @brief Adds the points of a GeoJSON ring as a new ring of the current part.
+	 *
+	 * @param Coordinates as the json array of the positions of the ring
+	 */
+	void AddRing(const TArray<TSharedPtr<FJsonValue>>& Coordinates);
+
+	/**
+	 * @brief Adds the rings of a GeoJSON Polygon as a new part.
+	 *
+	 * @param Rings as the json array of the rings of the polygon
+	 */
+	void AddPart(const TArray<TSharedPtr<FJsonValue>>& Rings);
+
+	/**
+	 * @brief Returns the index of the point of a ring that a bridge from a point on its left reaches without crossing
+	 * the ring, or INDEX_NONE when the ray to the right of the point misses the ring.
+	 *
+	 * @param Ring as the ring to bridge to
+	 * @param Point as the point the bridge starts from
+	 */
+	static int32 FindBridge(const TArray<FVector2D>& Ring, const FVector2D& Point);
+
+	/**
+	 * @brief Points of all the rings back to back.
+	 */
+	TArray<FVector2D> Points;
+
+	/**
+	 * @brief First point of each ring, followed by the number of points.
+	 */
+	TArray<int32> RingStarts;
+
+	/**
+	 * @brief First ring of each part, followed by the number of rings.
+	 */
+	TArray<int32> PartStarts;
+
+	/**
+	 * @brief Bounds of each part.
+	 */
+	TArray<FBox2D> PartBounds;
+
+	/**
+	 * @brief Single ring bridging every ring, in longitude, latitude and height.
+	 */
+	TArray<FVector> Bridged;
+};
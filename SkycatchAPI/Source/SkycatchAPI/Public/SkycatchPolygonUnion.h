@@ -0,0 +1,72 @@
+#pragma once
+
+/**
+ * Including the Header libraries and files required
+ **/
+#include "CoreMinimal.h"
+
+/**
+ * @brief Planar polygon operations used to merge the outlines of adjacent Skycatch sites before they are submitted
+ * to the world terrain raster overlay. Outlines are rings of longitude, latitude points without a closing point.
+ */
+struct SKYCATCHAPI_API FSkycatchPolygonUnion
+{
+	/**
+	 * @brief Returns whether two outlines overlap or touch within the given tolerance.
+	 *
+	 * @param A as the first outline
+	 * @param B as the second outline
+	 * @param Tolerance as the distance under which the outlines are considered touching, in degrees of latitude
+	 */
+	static bool Overlaps(const TArray<FVector2D>& A, const TArray<FVector2D>& B, double Tolerance);
+
+	/**
+	 * @brief Merges a group of outlines into the outer rings of their union. Vertices closer than the tolerance are
+	 * welded so touching outlines join, and the intersections are computed once and shared by both outlines.
+	 * Returns false when the union has holes, since they can't be expressed as clipping polygons, or when its boundary
+	 * can't be traced into closed rings, in which case the outlines have to be used as they are.
+	 *
+	 * @param Outlines as the outlines to merge
+	 * @param Tolerance as the distance under which vertices are welded, in degrees of latitude
+	 * @param OutRings as the counter-clockwise outer rings of the union
+	 */
+	static bool Union(const TArray<TArray<FVector2D>>& Outlines, double Tolerance, TArray<TArray<FVector2D>>& OutRings);
+
+	/**
+	 * @brief Returns the signed area of a ring, positive for counter-clockwise rings.
+	 *
+	 * @param Ring as the ring
+	 */
+	static double SignedArea(const TArray<FVector2D>& Ring);
+
+	/**
+	 * @brief Returns whether a point is inside a ring, using the even-odd rule.
+	 *
+	 * @param Ring as the ring
+	 * @param Point as the point to test
+	 */
+	static bool IsPointInside(const TArray<FVector2D>& Ring, const FVector2D& Point);
+
+	/**
+	 * @brief Returns the length of a degree of longitude relative to a degree of latitude at a latitude.
+	 *
+	 * @param Latitude as the latitude, in degrees
+	 */
+	static double GetLongitudeScale(double Latitude);
+
+	/**
+	 * @brief Expands bounds of longitude, latitude points by a tolerance in degrees of latitude, scaling it on the
+	 * longitude by the cosine of the latitude.
+	 *
+	 * @param Bounds as the bounds to expand
+	 * @param Tolerance as the distance to expand by, in degrees of latitude
+	 */
+	static FBox2D ExpandBounds(const FBox2D& Bounds, double Tolerance);
+
+	/**
+	 * @brief Returns the bounds of a ring.
+	 *
+	 * @param Ring as the ring
+	 */
+	static FBox2D GetBounds(const TArray<FVector2D>& Ring);
+};
@@ -0,0 +1,279 @@
+#pragma once
+
+/**
+ * Including the Header libraries and files required
+ **/
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "SkycatchPrewarm.generated.h"
+
+class ACesium3DTileset;
+class ACameraActor;
+class ALevelSequenceActor;
+class USplineComponent;
+
+/**
+ * @brief Time spent prewarming the tiles along a camera path, and the tile loading left to the playback that follows.
+ */
+USTRUCT(BlueprintType)
+struct SKYCATCHAPI_API FSkycatchPrewarmStats
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief Whether every sample of the path was prewarmed, even if some timed out. It doesn't mean every tile of the
+	 * path is still loaded, the tiles of a path that need more than the prewarm cache size are evicted.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchPrewarm)
+	bool bCompleted = false;
+
+	/**
+	 * @brief Poses sampled along the path.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchPrewarm)
+	int32 Samples = 0;
+
+	/**
+	 * @brief Batches of poses whose tiles didn't load before the timeout.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchPrewarm)
+	int32 TimedOutBatches = 0;
+
+	/**
+	 * @brief Skycatch tilesets of the sites along the path, waited for.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchPrewarm)
+	int32 Tilesets = 0;
+
+	/**
+	 * @brief Seconds spent prewarming.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchPrewarm)
+	float PrewarmSeconds = 0.0f;
+
+	/**
+	 * @brief Seconds the tilesets were loading while the poses were prewarmed.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchPrewarm)
+	float LoadingSeconds = 0.0f;
+
+	/**
+	 * @brief Seconds the tilesets were still loading during the playback that followed the prewarm.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchPrewarm)
+	float PlaybackLoadingSeconds = 0.0f;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnSkycatchPrewarmCompleted, const FSkycatchPrewarmStats&, Stats);
+
+/**
+ * @brief Loads the tiles a camera path will need before it is played or rendered. The poses of the path are added
+ * as extra cameras of the Cesium camera manager a few at a time, so every tileset selects and loads the tiles those
+ * views need at its screen space error, and the next poses are added once the Skycatch tilesets along the path
+ * finished loading. After the prewarm, the next playback of a level sequence is watched to log the loading left.
+ *
+ * The poses of a batch stop selecting their tiles once the next batch is added, so the tilesets along the path keep
+ * a cache of PrewarmTilesetBytes from the start of the prewarm, and the memory governor leaves it alone. The cache is
+ * released when that playback ends, when the prewarm is ended, or PrewarmReleaseSeconds after the prewarm completed
+ * if no playback started by then. The tiles of a path that need more are still evicted, as well as the tiles of the
+ * tilesets that aren't Skycatch sites.
+ */
+class SKYCATCHAPI_API FSkycatchTilePrewarm
+{
+public:
+
+	/**
+	 * @brief Samples the poses of a camera while a level sequence plays from its start to its end. The playback
+	 * position of the sequence is restored afterwards.
+	 *
+	 * @param SequenceActor as the level sequence to sample
+	 * @param Camera as the camera bound to the camera track of the sequence
+	 * @param NumSamples as the number of poses to sample
+	 * @param OutPoses as the sampled poses
+	 * @param OutFieldOfView as the horizontal field of view of the camera, in degrees
+	 */
+	static void SampleSequence(ALevelSequenceActor* SequenceActor, ACameraActor* Camera, int32 NumSamples, TArray<FTransform>& OutPoses, float& OutFieldOfView);
+
+	/**
+	 * @brief Samples poses at regular distances along a spline, looking along it.
+	 *
+	 * @param Spline as the spline to sample
+	 * @param NumSamples as the number of poses to sample
+	 * @param OutPoses as the sampled poses
+	 */
+	static void SampleSpline(const USplineComponent* Spline, int32 NumSamples, TArray<FTransform>& OutPoses);
+
+	/**
+	 * @brief Starts prewarming the tiles seen from the given poses, cancelling any prewarm running.
+	 *
+	 * @param World as the world of the tilesets
+	 * @param InPoses as the poses of the camera
+	 * @param InTilesets as the Skycatch tilesets of the sites along the path, waited for before the next poses
+	 * @param InFieldOfView as the horizontal field of view of the camera, in degrees
+	 * @param InResolution as the resolution the path is rendered at
+	 * @param bInWatchPlayback whether the path is played by a level sequence, whose playback is watched
+	 * @param InOnCompleted as the callback executed when the prewarm completes or is cancelled
+	 */
+	void Start(UWorld* World, TArray<FTransform> InPoses, const TArray<ACesium3DTileset*>& InTilesets, float InFieldOfView, FVector2D InResolution, bool bInWatchPlayback, TFunction<void(const FSkycatchPrewarmStats&)> InOnCompleted);
+
+	/**
+	 * @brief Adds the next poses once the tilesets finished loading the current ones, and watches the playback that
+	 * follows the prewarm.
+	 *
+	 * @param World as the world of the tilesets
+	 */
+	void Tick(UWorld* World);
+
+	/**
+	 * @brief Stops the prewarm, removes its cameras and releases the cache size kept for its tilesets.
+	 *
+	 * @param World as the world of the tilesets
+	 */
+	void Cancel(UWorld* World);
+
+	/**
+	 * @brief Returns whether poses are being prewarmed.
+	 */
+	bool IsRunning() const { return bRunning; }
+
+	/**
+	 * @brief Returns the stats of the last prewarm.
+	 */
+	const FSkycatchPrewarmStats& GetStats() const { return Stats; }
+
+	/**
+	 * @brief Returns whether a tileset keeps the cache size of the prewarm.
+	 *
+	 * @param Tileset as the tileset
+	 */
+	bool IsPinned(const ACesium3DTileset* Tileset) const;
+
+private:
+
+	/**
+	 * @brief Raises the cache size of the tilesets along the path to the one of the prewarm.
+	 */
+	void Pin();
+
+	/**
+	 * @brief Restores the cache size the tilesets had before the prewarm.
+	 */
+	void Unpin();
+
+	/**
+	 * @brief Returns whether every watched tileset finished loading.
+	 */
+	bool AreTilesetsLoaded() const;
+
+	/**
+	 * @brief Removes the cameras of the current batch from the Cesium camera manager.
+	 */
+	void RemoveCameras(UWorld* World);
+
+	/**
+	 * @brief Poses of the camera, their field of view and the resolution of the views.
+	 */
+	TArray<FTransform> Poses;
+	float FieldOfView = 90.0f;
+	FVector2D Resolution = FVector2D(1920.0, 1080.0);
+
+	/**
+	 * @brief Skycatch tilesets of the sites along the path.
+	 */
+	TArray<TWeakObjectPtr<ACesium3DTileset>> Tilesets;
+
+	/**
+	 * @brief Cache sizes of the tilesets before the prewarm, and whether they keep the cache size of the prewarm.
+	 */
+	TArray<int64> UnpinnedCachedBytes;
+	bool bPinned = false;
+
+	/**
+	 * @brief Ids of the Cesium cameras of the current batch.
+	 */
+	TArray<int32> CameraIds;
+
+	/**
+	 * @brief Index of the first pose not prewarmed yet.
+	 */
+	int32 NextPose = 0;
+
+	/**
+	 * @brief Frames since the current batch was added, the tilesets select its tiles on the next frame.
+	 */
+	int32 BatchFrames = 0;
+
+	/**
+	 * @brief Platform times the prewarm and the current batch started, and of the last tick.
+	 */
+	double StartTime = 0.0;
+	double BatchStartTime = 0.0;
+	double LastTickTime = 0.0;
+
+	/**
+	 * @brief Platform time the prewarm completed, from which the cache size of the prewarm is released.
+	 */
+	double CompletedTime = 0.0;
+
+	/**
+	 * @brief Whether poses are being prewarmed.
+	 */
+	bool bRunning = false;
+
+	/**
+	 * @brief Whether the path is played by a level sequence, whether its playback is watched, and whether it started.
+	 */
+	bool bWatchPlayback = false;
+	bool bWatchingPlayback = false;
+	bool bPlaybackStarted = false;
+
+	/**
+	 * @brief Stats of the last prewarm.
+	 */
+	FSkycatchPrewarmStats Stats;
+
+	/**
+	 * @brief Callback executed when the prewarm completes or is cancelled.
+	 */
+	TFunction<void(const FSkycatchPrewarmStats&)> OnCompleted;
+};
+
+/*
+* This class implements a blueprint function with async response for prewarming the tiles along a camera path, to be
+* awaited before playing or rendering the path with Movie Render Queue
+*/
+UCLASS()
+class SKYCATCHAPI_API UPrewarmSkycatchTilesAlongPath : public UBlueprintAsyncActionBase
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	UPROPERTY(BlueprintAssignable)
+	FOnSkycatchPrewarmCompleted OnPrewarmCompleted;
+
+	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject"), Category = SkycatchPrewarm)
+	static UPrewarmSkycatchTilesAlongPath* PrewarmSkycatchTilesAlongSequence(UObject* WorldContextObject,
+		ALevelSequenceActor* SequenceActor,
+		ACameraActor* Camera,
+		int32 Samples = 120,
+		FVector2D Resolution = FVector2D(1920, 1080));
+
+	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject"), Category = SkycatchPrewarm)
+	static UPrewarmSkycatchTilesAlongPath* PrewarmSkycatchTilesAlongSpline(UObject* WorldContextObject,
+		USplineComponent* Spline,
+		float FieldOfView = 90.0f,
+		int32 Samples = 120,
+		FVector2D Resolution = FVector2D(1920, 1080));
+
+	virtual void Activate() override;
+
+private:
+	UObject* WorldContextObject;
+	TArray<FTransform> Poses;
+	float FieldOfView;
+	FVector2D Resolution;
+	bool bWatchPlayback;
+
+	UFUNCTION()
+	void Execute(const FSkycatchPrewarmStats& Stats);
+};
@@ -7,6 +7,26 @@
 #include "UObject/NoExportTypes.h"
 #include "SkycatchSettings.generated.h"
 
+/**
+ * @brief How the collision of the Skycatch tilesets is built.
+ */
+UENUM(BlueprintType)
+enum class ESkycatchCollisionPolicy : uint8
+{
+	/** Uses the collision policy of the project settings */
+	UseProjectDefault,
+	/** Cesium builds a physics mesh for every loaded tile of the shown tileset */
+	Full,
+	/** No physics mesh is built */
+	None,
+	/** Physics meshes are built at a coarser level of detail, only while a player is close to the site, and only the
+	 * tiles close to a player collide */
+	NearPlayer,
+	/** Physics meshes are built at a much coarser level of detail on Cesium worker threads, and used as a simplified
+	 * collision proxy of the site */
+	SimplifiedProxy
+};
+
 UCLASS(config = Engine, DefaultConfig, meta = ( DisplayName = "SkycatchAPI" ), Blueprintable)
 class SKYCATCHAPI_API USkycatchSettings : public UObject
 {
@@ -33,7 +53,402 @@ public:
 	 **/
 	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = API)
 		FString SKYVERSE_ENDPOINT;
-	
+
+	/**
+	 ** @brief Additional endpoint routes (regional mirrors, on-prem caches) serving the same Skycatch services.
+	 * Every lookup goes to the fastest healthy endpoint and fails over to the next one on connection or server errors.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = API)
+		TArray<FString> SKYVERSE_MIRROR_ENDPOINTS;
+
+	/**
+	 ** @brief Seconds between health probes of the endpoints. 0 disables the periodic probing.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = API, meta = ( ClampMin = "0.0" ))
+		float EndpointProbeIntervalSeconds = 60.0f;
+
+	/**
+	 ** @brief Seconds an unhealthy endpoint is skipped before it is tried again.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = API, meta = ( ClampMin = "0.0" ))
+		float EndpointRetryCooldownSeconds = 30.0f;
+
+	/**
+	 ** @brief Weight (0-1) of the newest sample in the moving average of the endpoint latency.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = API, meta = ( ClampMin = "0.0", ClampMax = "1.0" ))
+		float EndpointLatencySmoothing = 0.2f;
+
+	/**
+	 ** @brief Number of captures before and after the active capture of a site that are prefetched and kept loaded,
+	 * so stepping through the survey history is near-instant. 0 disables the prefetch.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = History, meta = ( ClampMin = "0" ))
+		int32 CaptureWarmNeighbours = 1;
+
+	/**
+	 ** @brief Total Cesium cache size in bytes shared by the prefetched captures of a site.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = History, meta = ( ClampMin = "0" ))
+		int64 CaptureWarmBudgetBytes = 512 * 1024 * 1024;
+
+	/**
+	 ** @brief Seconds a site lookup response is kept in the site cache before it is requested again.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Streaming, meta = ( ClampMin = "0.0" ))
+		float SiteCacheLifetimeSeconds = 3600.0f;
+
+	/**
+	 ** @brief Maximum number of site lookup responses kept in the site cache.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Streaming, meta = ( ClampMin = "1" ))
+		int32 SiteCacheMaxEntries = 256;
+
+	/**
+	 ** @brief Distance in Unreal units from a player view to a known site under which its lookup is fetched ahead,
+	 * so it is already cached when the level or World Partition cell of the site streams in. Should be larger than
+	 * the loading range of the cells. 0 disables the prefetch.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Streaming, meta = ( ClampMin = "0.0" ))
+		float SitePrefetchDistance = 0.0f;
+
+	/**
+	 ** @brief Seconds between two checks of the distance from the player views to the known sites.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Streaming, meta = ( ClampMin = "0.0" ))
+		float SitePrefetchIntervalSeconds = 1.0f;
+
+	/**
+	 ** @brief Milliseconds per frame the resolved sites can spend spawning their tilesets, setting their outlines and
+	 * registering them in the raster overlay. The sites closest to the player views are committed first, the others
+	 * wait for the next frames. 0 commits every site in the frame it resolves.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Streaming, meta = ( ClampMin = "0.0" ))
+		float CommitBudgetMilliseconds = 2.0f;
+
+	/**
+	 ** @brief Outline points projected to Unreal coordinates in one step of a commit, so large outlines are set over
+	 * several steps.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Streaming, meta = ( ClampMin = "1" ))
+		int32 CommitChunkPoints = 1024;
+
+	/**
+	 ** @brief Whether the SkycatchTerrain actors are relevant to every client. The actor covers a whole site but is
+	 * usually placed at the georeference origin, so relevancy by distance to the actor would stop replicating the
+	 * resolved site to players standing on it far from the origin. Disable it when every terrain actor is placed on
+	 * its site and the net cull distance covers the site.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Replication)
+		bool bTerrainAlwaysRelevant = true;
+
+	/**
+	 ** @brief Comma separated properties of the sites requested from the Skycatch services with the fields query
+	 * param. The responses are also stripped of any other property. Empty requests and keeps every property.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = API)
+		FString SiteLookupFields = TEXT("tilesetUrl,outline,captureDate");
+
+	/**
+	 ** @brief Maximum number of sites kept from the responses of the Skycatch services after ranking them by distance
+	 * to the point. Also requested with the limit query param when the services rank the sites themselves. Should
+	 * cover the captures of a site. 0 means no limit.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = API, meta = ( ClampMin = "0" ))
+		int32 SiteLookupLimit = 32;
+
+	/**
+	 ** @brief Whether the Skycatch services return the sites closest to the point first. Only then the limit query
+	 * param is sent, otherwise the services could cut the site that contains the point from the response, and the
+	 * limit is only applied once the plugin ranked the sites.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = API)
+		bool bServerRanksSitesByDistance = false;
+
+	/**
+	 ** @brief Whether the outlines of adjacent or overlapping sites are merged before they are submitted to the world
+	 * terrain raster overlay, so the overlay clips fewer polygons and vertices.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Overlay)
+		bool bMergeOverlayPolygons = true;
+
+	/**
+	 ** @brief Distance in meters under which the outlines of two sites are considered touching and their vertices
+	 * are welded when merging them.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Overlay, meta = ( ClampMin = "0.0" ))
+		float PolygonMergeToleranceMeters = 0.5f;
+
+	/**
+	 ** @brief Whether the outline of a site is only submitted to the world terrain raster overlay while the site is
+	 * close to a player view or inside its field of view, so far away sites don't cost raster overlay work.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Overlay)
+		bool bAutoActivateOverlayPolygons = true;
+
+	/**
+	 ** @brief Distance in Unreal units from a player view to the edge of a site under which its outline is submitted,
+	 * whatever the direction of the view. 0 only submits the sites a player view is over.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Overlay, meta = ( ClampMin = "0.0" ))
+		float OverlayActivationDistance = 500000.0f;
+
+	/**
+	 ** @brief Whether the outline of a site inside the field of view of a player is submitted, so the sites seen from
+	 * far away, as in aerial views, are clipped too. Turning the camera then changes the submitted sites, the raster
+	 * overlay refreshes are limited by OverlayRefreshIntervalSeconds.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Overlay)
+		bool bActivateOverlayInView = true;
+
+	/**
+	 ** @brief Distance in Unreal units from a player view to the edge of a site beyond which its outline is not
+	 * submitted even inside the field of view. 0 means no limit.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Overlay, meta = ( ClampMin = "0.0" ))
+		float OverlayViewDistance = 5000000.0f;
+
+	/**
+	 ** @brief Fraction by which the distances and the field of view are enlarged before an active site is withdrawn,
+	 * so sites at the edge don't flip every update.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Overlay, meta = ( ClampMin = "0.0" ))
+		float OverlayActivationHysteresis = 0.2f;
+
+	/**
+	 ** @brief Seconds between two updates of the active sites. The changes of an update are applied to the raster
+	 * overlay in one batch.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Overlay, meta = ( ClampMin = "0.0" ))
+		float OverlayActivationIntervalSeconds = 0.25f;
+
+	/**
+	 ** @brief Minimum seconds between two refreshes of the world terrain raster overlay. The polygon changes made in
+	 * between are applied together by the next refresh, which waits until the queued commits are done. Only the raster overlay is refreshed, the tiles of the world
+	 * terrain stay loaded.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Overlay, meta = ( ClampMin = "0.0" ))
+		float OverlayRefreshIntervalSeconds = 1.0f;
+
+	/**
+	 ** @brief Collision policy of the Skycatch Terrain actors that use the project default. Full keeps the Cesium
+	 * behaviour of building a physics mesh for every loaded tile.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Collision)
+		ESkycatchCollisionPolicy DefaultCollisionPolicy = ESkycatchCollisionPolicy::Full;
+
+	/**
+	 ** @brief Distance in Unreal units from a player view under which a site, and its tiles, collide with the
+	 * NearPlayer policy.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Collision, meta = ( ClampMin = "0.0" ))
+		float CollisionDistance = 50000.0f;
+
+	/**
+	 ** @brief Maximum screen space error of the tiles built for collision with the NearPlayer policy. Larger values
+	 * build coarser physics meshes.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Collision, meta = ( ClampMin = "0.0" ))
+		float NearPlayerCollisionScreenSpaceError = 32.0f;
+
+	/**
+	 ** @brief Maximum screen space error of the tiles built for collision with the SimplifiedProxy policy.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Collision, meta = ( ClampMin = "0.0" ))
+		float CollisionProxyScreenSpaceError = 128.0f;
+
+	/**
+	 ** @brief Seconds between two updates of the collision of a Skycatch Terrain actor.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Collision, meta = ( ClampMin = "0.0" ))
+		float CollisionUpdateIntervalSeconds = 0.5f;
+
+	/**
+	 ** @brief Height in meters above the WGS84 ellipsoid from which the height queries trace down.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = HeightQuery)
+		float HeightQueryMaxHeight = 9000.0f;
+
+	/**
+	 ** @brief Height in meters above the WGS84 ellipsoid down to which the height queries trace.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = HeightQuery)
+		float HeightQueryMinHeight = -500.0f;
+
+	/**
+	 ** @brief Distance in meters under which a height query reuses a height found before on the same tile.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = HeightQuery, meta = ( ClampMin = "0.0" ))
+		float HeightCacheToleranceMeters = 0.01f;
+
+	/**
+	 ** @brief Seconds between two attempts to answer the points of the height queries that had no loaded tile.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = HeightQuery, meta = ( ClampMin = "0.0" ))
+		float HeightQueryRetryIntervalSeconds = 0.25f;
+
+	/**
+	 ** @brief Seconds after which the points of a height query that still have no loaded tile are answered as misses.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = HeightQuery, meta = ( ClampMin = "0.0" ))
+		float HeightQueryTimeoutSeconds = 30.0f;
+
+	/**
+	 ** @brief Whether the Cesium cache size and tile load concurrency of the Skycatch tilesets of a world are split
+	 * from the budgets below by priority, instead of every tileset using the Cesium defaults.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Memory)
+		bool bGovernTilesetMemory = true;
+
+	/**
+	 ** @brief Total Cesium cache size in bytes shared by the Skycatch tilesets of a world. The prefetched captures of
+	 * the sites keep their own budget, which is taken out of this one.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Memory, meta = ( ClampMin = "0" ))
+		int64 TilesetMemoryBudgetBytes = 2048ll * 1024 * 1024;
+
+	/**
+	 ** @brief Cesium cache size in bytes every Skycatch tileset keeps whatever its priority.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Memory, meta = ( ClampMin = "0" ))
+		int64 MinimumTilesetBytes = 32 * 1024 * 1024;
+
+	/**
+	 ** @brief Total number of tiles loaded at the same time by the Skycatch tilesets of a world. Every tileset loads
+	 * at least one tile at a time.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Memory, meta = ( ClampMin = "1" ))
+		int32 TilesetLoadBudget = 40;
+
+	/**
+	 ** @brief Distance in Unreal units from a player view to a site at which the priority of its tilesets is halved.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Memory, meta = ( ClampMin = "1.0" ))
+		float TilesetPriorityDistance = 100000.0f;
+
+	/**
+	 ** @brief Factor applied to the priority of the tilesets of a site in a player view.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Memory, meta = ( ClampMin = "1.0" ))
+		float TilesetFocusPriority = 4.0f;
+
+	/**
+	 ** @brief Seconds between two splits of the budgets across the Skycatch tilesets.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Memory, meta = ( ClampMin = "0.0" ))
+		float TilesetBudgetIntervalSeconds = 1.0f;
+
+	/**
+	 ** @brief Whether the plugin warms up once the engine started: it opens the connections to the endpoints, loads
+	 * the sites saved by the previous session and prefetches the home sites, without blocking the startup.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = WarmUp)
+		bool bWarmUpOnStartup = true;
+
+	/**
+	 ** @brief Whether the site cache is saved to the saved folder of the project when the engine exits, and loaded
+	 * again by the warm up of the next session. Read when the plugin starts.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = WarmUp)
+		bool bPersistSiteCache = true;
+
+	/**
+	 ** @brief Sites looked up by the warm up, with the longitude in X and the latitude in Y.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = WarmUp)
+		TArray<FVector2D> HomeSites;
+
+	/**
+	 ** @brief Whether the warm up also fetches the root tileset.json of the home sites into the Cesium request cache.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = WarmUp)
+		bool bPrefetchHomeTilesets = true;
+
+	/**
+	 ** @brief Poses of a camera path added at the same time as Cesium cameras while prewarming its tiles.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Prewarm, meta = ( ClampMin = "1" ))
+		int32 PrewarmParallelCameras = 4;
+
+	/**
+	 ** @brief Seconds a batch of poses waits for its tiles to load before the prewarm moves to the next poses.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Prewarm, meta = ( ClampMin = "0.0" ))
+		float PrewarmBatchTimeoutSeconds = 30.0f;
+
+	/**
+	 ** @brief Distance in Unreal units from a camera path to a site at which the prewarm waits for its tileset.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Prewarm, meta = ( ClampMin = "0.0" ))
+		float PrewarmSiteDistance = 500000.0f;
+
+	/**
+	 ** @brief Cesium cache size in bytes every Skycatch tileset along a prewarmed path keeps from the start of the
+	 * prewarm until the playback that follows ends, the prewarm is ended or PrewarmReleaseSeconds passed, so the tiles
+	 * of the first poses aren't evicted before they are rendered. The tiles of a path that need more are still evicted.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Prewarm, meta = ( ClampMin = "0" ))
+		int64 PrewarmTilesetBytes = 1024ll * 1024 * 1024;
+
+	/**
+	 ** @brief Seconds the tilesets along a prewarmed path keep the cache size of the prewarm once it completed, unless
+	 * a level sequence playback started by then. Paths sampled from a spline always release it after these seconds,
+	 * or when the prewarm is ended. 0 releases it as soon as the prewarm completes.
+	 * Can be edited over Project Settings>Plugins>Skycatch Skyverse.
+	 **/
+	UPROPERTY(Config, BlueprintReadWrite, EditAnywhere, Category = Prewarm, meta = ( ClampMin = "0.0" ))
+		float PrewarmReleaseSeconds = 120.0f;
+
 };
 
 DECLARE_LOG_CATEGORY_EXTERN(LogSkycatch, Log, All);
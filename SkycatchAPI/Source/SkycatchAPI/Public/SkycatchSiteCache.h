@@ -0,0 +1,158 @@
+#pragma once
+
+/**
+ * Including the Header libraries and files required
+ **/
+#include "CoreMinimal.h"
+
+/**
+ * @brief Delegate called when a site lookup completes, with whether the endpoint could be reached, the HTTP response
+ * code and the response content.
+ */
+DECLARE_DELEGATE_ThreeParams(FOnSiteLookupCompleted, bool, int32, const FString&);
+
+/**
+ * @brief Lookup response of a site kept in the site cache.
+ */
+struct SKYCATCHAPI_API FSkycatchCachedSite
+{
+	/**
+	 * @brief Query params of the lookup, used as the cache key.
+	 */
+	FString Params;
+
+	/**
+	 * @brief Latitude of the lookup, used to prefetch the site when a player gets close.
+	 */
+	double Latitude = 0.0;
+
+	/**
+	 * @brief Longitude of the lookup, used to prefetch the site when a player gets close.
+	 */
+	double Longitude = 0.0;
+
+	/**
+	 * @brief Content of the Skycatch services response.
+	 */
+	FString Response;
+
+	/**
+	 * @brief Platform time the response was received.
+	 */
+	double FetchTime = 0.0;
+};
+
+/**
+ * @brief Process wide cache of the Skycatch services site lookups. Lookups are sent to the endpoint pool with
+ * failover, concurrent lookups of the same site share one request, and successful responses are kept so that
+ * actors streaming in again, or other actors over the same site, resolve without network traffic.
+ */
+class SKYCATCHAPI_API FSkycatchSiteCache
+{
+public:
+
+	/**
+	 * @brief Returns the process wide site cache.
+	 */
+	static FSkycatchSiteCache& Get();
+
+	/**
+	 * @brief Resolves a site lookup from the cache, or sends it to the Skycatch services when it is not cached or
+	 * expired. The callback is executed immediately on a cache hit.
+	 *
+	 * @param Params as the query params of the lookup
+	 * @param OnCompleted as the callback executed with the response
+	 */
+	void Lookup(const FString& Params, FOnSiteLookupCompleted OnCompleted);
+
+	/**
+	 * @brief Fetches a site lookup into the cache without doing anything with the response.
+	 *
+	 * @param Params as the query params of the lookup
+	 */
+	void Prefetch(const FString& Params);
+
+	/**
+	 * @brief Returns whether a lookup has a cached response that has not expired.
+	 *
+	 * @param Params as the query params of the lookup
+	 */
+	bool IsCached(const FString& Params) const;
+
+	/**
+	 * @brief Returns whether a lookup is being sent to the Skycatch services.
+	 *
+	 * @param Params as the query params of the lookup
+	 */
+	bool IsInFlight(const FString& Params) const;
+
+	/**
+	 * @brief Returns all the cached sites, including the expired ones.
+	 */
+	TArray<FSkycatchCachedSite> GetSites() const;
+
+	/**
+	 * @brief Removes all the cached sites.
+	 */
+	void Empty();
+
+	/**
+	 * @brief Ranks the tiles of a lookup response, the tiles whose outline contains the point first and then by the
+	 * distance from the point to the center of their outline, keeps only the configured number of tiles and only the
+	 * properties the plugin reads. Returns the response unchanged when it can't be parsed.
+	 *
+	 * @param Response as the content of the Skycatch services response
+	 * @param Latitude as the latitude of the lookup
+	 * @param Longitude as the longitude of the lookup
+	 */
+	static FString ShapeResponse(const FString& Response, double Latitude, double Longitude);
+
+	/**
+	 * @brief Writes the cached sites to the saved folder of the project, so the next session starts with them.
+	 */
+	void Save() const;
+
+	/**
+	 * @brief Reads the sites saved by a previous session on a worker thread, then adds them to the cache on the game
+	 * thread without replacing the responses received meanwhile.
+	 *
+	 * @param OnLoaded as the callback executed on the game thread with the number of sites added
+	 */
+	void LoadAsync(TFunction<void(int32)> OnLoaded);
+
+	/**
+	 * @brief Returns the path of the file the cached sites are saved to.
+	 */
+	static FString GetSavePath();
+
+private:
+
+	/**
+	 * @brief Evicts the oldest responses above the configured number of entries.
+	 */
+	void EvictOldest();
+
+	/**
+	 * @brief Sends a lookup to the fastest healthy endpoint, failing over to the next endpoint on connection or
+	 * server errors.
+	 *
+	 * @param Params as the query params of the lookup
+	 * @param TriedEndpoints as the endpoints that already failed for this lookup
+	 */
+	void SendRequest(const FString& Params, TArray<FString> TriedEndpoints);
+
+	/**
+	 * @brief Stores a successful response and executes all the callbacks waiting for the lookup.
+	 */
+	void CompleteLookup(const FString& Params, bool bConnected, int32 ResponseCode, const FString& Content);
+
+	/**
+	 * @brief Cached responses by query params.
+	 */
+	TMap<FString, FSkycatchCachedSite> Sites;
+
+	/**
+	 * @brief Callbacks waiting for the lookups being sent, by query params.
+	 */
+	TMap<FString, TArray<FOnSiteLookupCompleted>> InFlight;
+};
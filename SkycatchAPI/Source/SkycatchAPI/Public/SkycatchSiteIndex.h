@@ -0,0 +1,112 @@
+#pragma once
+
+/**
+ * Including the Header libraries and files required
+ **/
+#include "CoreMinimal.h"
+
+/**
+ * @brief Answers which site contains each of a batch of points. The rings of the sites are kept as edges four at a
+ * time in a uniform grid over their bounds, so a point is only tested against the sites of its cell, four edges per
+ * instruction. Large batches are split across the task graph.
+ */
+class SKYCATCHAPI_API FSkycatchSiteIndex
+{
+public:
+
+	/**
+	 * @brief Removes all the sites.
+	 */
+	void Reset();
+
+	/**
+	 * @brief Adds a site. The rings are combined with the even-odd rule, so holes are given as rings inside the outer
+	 * ring. When sites overlap, points are given to the smallest one. Build has to be called after adding the sites.
+	 *
+	 * @param SiteId as the id returned for the points inside the site
+	 * @param Rings as the rings of the site, without a closing point
+	 */
+	void AddSite(int32 SiteId, const TArray<TArray<FVector2D>>& Rings);
+
+	/**
+	 * @brief Builds the grid over the added sites. The sites added before are kept.
+	 */
+	void Build();
+
+	/**
+	 * @brief Returns the id of the site containing a point, or INDEX_NONE.
+	 *
+	 * @param Point as the point to locate
+	 */
+	int32 FindSite(const FVector2D& Point) const;
+
+	/**
+	 * @brief Finds the site containing each of the locations, using their X and Y.
+	 *
+	 * @param Locations as the locations to find
+	 * @param OutSiteIds as the id of the site containing each location, or INDEX_NONE
+	 * @param bParallel as whether large batches are split across worker threads
+	 */
+	void FindSites(TArrayView<const FVector> Locations, TArrayView<int32> OutSiteIds, bool bParallel = true) const;
+
+	/**
+	 * @brief Returns the number of sites.
+	 */
+	int32 Num() const { return AddedSites.Num(); }
+
+private:
+
+	/**
+	 * @brief Edges of a site, stored from the origin of the index.
+	 */
+	struct FSite
+	{
+		int32 SiteId = INDEX_NONE;
+		FBox2f Bounds;
+		/** Edges of the site, always a multiple of four starting at a multiple of four */
+		int32 FirstEdge = 0;
+		int32 NumEdges = 0;
+	};
+
+	/**
+	 * @brief Returns whether a point relative to the origin is inside a site.
+	 */
+	bool IsInside(const FSite& Site, const FVector2f& Point) const;
+
+	/**
+	 * @brief Rings of the sites added since the last build, by site id.
+	 */
+	TArray<TPair<int32, TArray<TArray<FVector2D>>>> AddedSites;
+
+	/**
+	 * @brief Sites sorted by area.
+	 */
+	TArray<FSite> Sites;
+
+	/**
+	 * @brief Coordinates of the ends of the edges of the sites, relative to the origin, so they fit in floats.
+	 */
+	TArray<float> EdgeX0;
+	TArray<float> EdgeY0;
+	TArray<float> EdgeX1;
+	TArray<float> EdgeY1;
+
+	/**
+	 * @brief Center of the bounds of the sites when the index was built.
+	 */
+	FVector2D Origin = FVector2D::ZeroVector;
+
+	/**
+	 * @brief Corner of the grid relative to the origin, size of its cells and number of cells along X and Y.
+	 */
+	FVector2f GridMin = FVector2f::ZeroVector;
+	float CellSize = 1.0f;
+	int32 GridSizeX = 0;
+	int32 GridSizeY = 0;
+
+	/**
+	 * @brief Sites overlapping every cell: the sites of a cell start at its entry in CellStart and end at the next.
+	 */
+	TArray<int32> CellStart;
+	TArray<int32> CellSites;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+/**
+ * Including the Header libraries and files required
+ **/
+#include "CoreMinimal.h"
+#include "SkycatchSitePayload.generated.h"
+
+/**
+ * @brief Compact description of a resolved site that the server replicates to the clients, so they can build the
+ * tileset and the polygon without calling the Skycatch services.
+ */
+USTRUCT()
+struct SKYCATCHAPI_API FSkycatchSitePayload
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief Url of the tileset of the site.
+	 */
+	UPROPERTY()
+	FString TilesetUrl;
+
+	/**
+	 * @brief Outline of the site with every ring of every part. The number of parts, the number of rings of each part
+	 * and the number of points of each ring come first, then the longitude, latitude pairs of the rings quantized to
+	 * 1e-7 degrees and delta encoded, all written as zigzag variable length integers.
+	 */
+	UPROPERTY()
+	TArray<uint8> Outline;
+
+	/**
+	 * @brief Quantizes and encodes the parts of an outline, each being an outer ring and its holes in longitude and
+	 * latitude, without a closing point.
+	 *
+	 * @param Parts as the parts of the outline to encode
+	 */
+	static TArray<uint8> EncodeOutline(const TArray<TArray<TArray<FVector2D>>>& Parts);
+
+	/**
+	 * @brief Decodes the parts of an outline. Returns false when the data is malformed.
+	 *
+	 * @param Data as the encoded outline
+	 * @param OutParts as the decoded parts, each being an outer ring and its holes in longitude and latitude
+	 */
+	static bool DecodeOutline(const TArray<uint8>& Data, TArray<TArray<TArray<FVector2D>>>& OutParts);
+};
@@ -0,0 +1,539 @@
+#pragma once
+
+/**
+ * Including the Header libraries and files required
+ **/
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "CesiumGeoreference.h"
+#include "SkycatchSiteIndex.h"
+#include "SkycatchPrewarm.h"
+#include "SkycatchCommitQueue.h"
+#include "SkycatchSubsystem.generated.h"
+
+class ASkycatchTerrain;
+class ACesium3DTileset;
+class ACesiumCartographicPolygon;
+class UCesiumPolygonRasterOverlay;
+
+/**
+ * @brief Number of sites and of the polygons and vertices submitted for them to the world terrain raster overlay.
+ */
+USTRUCT(BlueprintType)
+struct SKYCATCHAPI_API FSkycatchOverlayStats
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief Sites whose outline is submitted to the raster overlay.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	int32 Sites = 0;
+
+	/**
+	 * @brief Sites whose outline is submitted but kept out of the raster overlay, since they are far from the views.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	int32 InactiveSites = 0;
+
+	/**
+	 * @brief Polygons in the raster overlay for those sites, after merging the adjacent outlines.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	int32 Polygons = 0;
+
+	/**
+	 * @brief Vertices of those polygons.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	int32 Vertices = 0;
+};
+
+/**
+ * @brief Share of the memory and load budgets given to a Skycatch tileset, and the memory it currently uses.
+ */
+USTRUCT(BlueprintType)
+struct SKYCATCHAPI_API FSkycatchTilesetMemory
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief Skycatch Terrain actor the tileset belongs to.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	ASkycatchTerrain* Terrain = nullptr;
+
+	/**
+	 * @brief Governed tileset.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	ACesium3DTileset* Tileset = nullptr;
+
+	/**
+	 * @brief Priority of the tileset, from the distance of its site to the player views and whether it is seen.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	float Priority = 0.0f;
+
+	/**
+	 * @brief Bytes of the tiles of the tileset currently in memory.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	int64 ResidentBytes = 0;
+
+	/**
+	 * @brief Cesium cache size in bytes given to the tileset.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	int64 BudgetBytes = 0;
+
+	/**
+	 * @brief Number of tiles the tileset may load at the same time.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	int32 SimultaneousTileLoads = 0;
+};
+
+/**
+ * @brief World subsystem that manages the state shared by all the Skycatch Terrain actors of a world.
+ */
+UCLASS()
+class SKYCATCHAPI_API USkycatchSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * @brief Fetches the lookups of the known sites close to the player views ahead of their streaming, so they are
+	 * cached when the actors of the sites stream in.
+	 */
+	void PrefetchNearbySites();
+
+	/**
+	 * @brief Adds the outlines of the sites that came close to or into the player views to the raster overlay, and
+	 * removes those of the sites that left them, in one batch.
+	 */
+	void UpdateOverlayActivation();
+
+	/**
+	 * @brief Fetches the lookup of a site into the site cache, so a Skycatch Terrain actor streaming in over it later
+	 * resolves without waiting for the Skycatch services.
+	 *
+	 * @param Lat is the Latitude value
+	 * @param Lon is the Longitude value
+	 */
+	UFUNCTION(BlueprintCallable, Category = SkycatchTerrain)
+	void PrefetchSite(double Lat, double Lon);
+
+	/**
+	 * @brief Registers a Skycatch Terrain actor with a polygon outline, and listens to the changes of its georeference.
+	 *
+	 * @param Terrain as the actor to register
+	 */
+	void RegisterTerrain(ASkycatchTerrain* Terrain);
+
+	/**
+	 * @brief Unregisters a Skycatch Terrain actor.
+	 *
+	 * @param Terrain as the actor to unregister
+	 */
+	void UnregisterTerrain(ASkycatchTerrain* Terrain);
+
+	/**
+	 * @brief Re-projects the polygons of all the registered Skycatch Terrain actors from their kept geodetic outlines
+	 * in one batch, then refreshes every affected world terrain once. No request is made to Skycatch services.
+	 */
+	UFUNCTION(BlueprintCallable, Category = SkycatchTerrain)
+	void ReprojectOutlines();
+
+	/**
+	 * @brief Submits the outline of a Skycatch Terrain actor to the world terrain raster overlay. The outline is
+	 * merged with the outlines of the adjacent sites, and only the group of sites it touches is merged again.
+	 *
+	 * @param Terrain as the actor whose outline is submitted
+	 * @param Overlay as the raster overlay of the world terrain
+	 */
+	void SubmitSitePolygon(ASkycatchTerrain* Terrain, UCesiumPolygonRasterOverlay* Overlay);
+
+	/**
+	 * @brief Removes the outline of a Skycatch Terrain actor from the world terrain raster overlay.
+	 *
+	 * @param Terrain as the actor whose outline is removed
+	 */
+	void WithdrawSitePolygon(ASkycatchTerrain* Terrain);
+
+	/**
+	 * @brief Returns whether the outline of a Skycatch Terrain actor is submitted to the world terrain raster overlay.
+	 *
+	 * @param Terrain as the actor to check
+	 */
+	bool IsSiteSubmitted(const ASkycatchTerrain* Terrain) const;
+
+	/**
+	 * @brief Returns the number of sites and of the polygons and vertices submitted to the raster overlay.
+	 */
+	UFUNCTION(BlueprintPure, Category = SkycatchTerrain)
+	FSkycatchOverlayStats GetOverlayStats() const { return OverlayStats; }
+
+	/**
+	 * @brief Splits the Cesium cache size and tile load concurrency budgets across the Skycatch tilesets of the world
+	 * by priority. Tilesets close to or seen by the player views get the largest shares.
+	 */
+	UFUNCTION(BlueprintCallable, Category = SkycatchTerrain)
+	void RebalanceTilesetBudgets();
+
+	/**
+	 * @brief Requests the budgets to be split again on the next tick, after a tileset was spawned or changed role.
+	 */
+	void InvalidateTilesetBudgets() { bTilesetBudgetsDirty = true; }
+
+	/**
+	 * @brief Returns the budgets given to the Skycatch tilesets of the world, with the bytes they currently use.
+	 */
+	UFUNCTION(BlueprintPure, Category = SkycatchTerrain)
+	TArray<FSkycatchTilesetMemory> GetTilesetMemory() const;
+
+	/**
+	 * @brief Returns the bytes of the tiles of all the Skycatch tilesets of the world currently in memory.
+	 */
+	UFUNCTION(BlueprintPure, Category = SkycatchTerrain)
+	int64 GetResidentTilesetBytes() const;
+
+	/**
+	 * @brief Returns the bytes of the tiles of a tileset currently in memory.
+	 *
+	 * @param Tileset as the tileset to measure
+	 */
+	static int64 GetResidentBytes(const ACesium3DTileset* Tileset);
+
+	/**
+	 * @brief Finds the Skycatch site containing each of the given world locations, from the horizontal position of
+	 * the locations against the projected outlines of the sites. Meant to be called every frame for many agents.
+	 *
+	 * @param Locations as the world locations to find
+	 * @param OutSiteIds as the id of the site containing each location, or -1 when none does
+	 */
+	UFUNCTION(BlueprintCallable, Category = SkycatchTerrain)
+	void FindSitesAtLocations(const TArray<FVector>& Locations, TArray<int32>& OutSiteIds);
+
+	/**
+	 * @brief Finds the Skycatch site containing each of the given world locations, writing into a caller owned buffer.
+	 *
+	 * @param Locations as the world locations to find
+	 * @param OutSiteIds as the id of the site containing each location, or INDEX_NONE, as many as the locations
+	 */
+	void FindSites(TArrayView<const FVector> Locations, TArrayView<int32> OutSiteIds);
+
+	/**
+	 * @brief Returns the id of the site of a Skycatch Terrain actor, which stays the same while the actor lives, or
+	 * -1 when the actor has no outline.
+	 *
+	 * @param Terrain as the actor of the site
+	 */
+	UFUNCTION(BlueprintPure, Category = SkycatchTerrain)
+	int32 GetSiteId(const ASkycatchTerrain* Terrain) const;
+
+	/**
+	 * @brief Returns the Skycatch Terrain actor of a site id, or null.
+	 *
+	 * @param SiteId as the id of the site
+	 */
+	UFUNCTION(BlueprintPure, Category = SkycatchTerrain)
+	ASkycatchTerrain* GetSiteTerrain(int32 SiteId) const;
+
+	/**
+	 * @brief Returns whether the commits of the resolved sites are spread over frames, which is the case in game
+	 * worlds with a commit budget.
+	 */
+	bool ShouldQueueCommits() const;
+
+	/**
+	 * @brief Queues the commit of a resolved site, or runs it to completion right away when commits are not queued.
+	 *
+	 * @param Terrain as the actor of the site, replacing its commit still queued
+	 * @param Step as the step run until the commit is completed
+	 * @param OnCancelled as the function called if the commit is cancelled or replaced before it is completed
+	 */
+	void EnqueueCommit(ASkycatchTerrain* Terrain, FSkycatchCommitQueue::FStep Step, FSkycatchCommitQueue::FCancelled OnCancelled = nullptr);
+
+	/**
+	 * @brief Drops the commit of a site still queued, reporting it as cancelled.
+	 *
+	 * @param Terrain as the actor of the site
+	 */
+	void CancelCommit(const ASkycatchTerrain* Terrain);
+
+	/**
+	 * @brief Returns the time spent committing the resolved sites and the depth of the commit queue.
+	 */
+	UFUNCTION(BlueprintPure, Category = SkycatchTerrain)
+	FSkycatchCommitStats GetCommitStats() const;
+
+	/**
+	 * @brief Starts prewarming the tiles seen from the poses of a camera path, waiting on the Skycatch tilesets of
+	 * the sites within the prewarm distance of the path. Cancels the prewarm running.
+	 *
+	 * @param Poses as the poses of the camera
+	 * @param FieldOfView as the horizontal field of view of the camera, in degrees
+	 * @param Resolution as the resolution the path is rendered at
+	 * @param bWatchPlayback whether the path is played by a level sequence, whose playback is watched
+	 * @param OnCompleted as the callback executed when the prewarm completes or is cancelled
+	 */
+	void StartPrewarm(TArray<FTransform> Poses, float FieldOfView, FVector2D Resolution, bool bWatchPlayback, TFunction<void(const FSkycatchPrewarmStats&)> OnCompleted);
+
+	/**
+	 * @brief Stops the prewarm running and removes its cameras.
+	 */
+	UFUNCTION(BlueprintCallable, Category = SkycatchPrewarm)
+	void CancelPrewarm();
+
+	/**
+	 * @brief Ends the last prewarm once its path was rendered, giving the cache size kept for its tilesets back to
+	 * the memory governor.
+	 */
+	UFUNCTION(BlueprintCallable, Category = SkycatchPrewarm)
+	void EndPrewarm();
+
+	/**
+	 * @brief Returns the stats of the last prewarm, including the loading of the playback that followed it.
+	 */
+	UFUNCTION(BlueprintPure, Category = SkycatchPrewarm)
+	FSkycatchPrewarmStats GetPrewarmStats() const;
+
+private:
+
+	/**
+	 * @brief Outline of a site submitted to the raster overlay.
+	 */
+	struct FOverlaySite
+	{
+		TArray<FVector2D> Outline;
+		FBox2D Bounds;
+		int32 Group = INDEX_NONE;
+		/** Whether the outline is in the raster overlay, only active sites are grouped */
+		bool bActive = true;
+		/** Whether the outline bridges holes or several parts, which the union can't merge */
+		bool bHasHoles = false;
+		/** Center and radius of the site in Unreal coordinates */
+		FVector Location = FVector::ZeroVector;
+		double Radius = 0.0;
+	};
+
+	/**
+	 * @brief Location, direction and field of view of a player view.
+	 */
+	struct FPlayerView
+	{
+		FVector Location;
+		FVector Direction;
+		/** Half angle in radians of the cone containing the field of view */
+		double HalfAngle;
+	};
+
+	/**
+	 * @brief Collects the views of the local players.
+	 */
+	TArray<FPlayerView> GetPlayerViews() const;
+
+	/**
+	 * @brief Computes the center and radius of a site in Unreal coordinates.
+	 *
+	 * @param Terrain as the actor of the site
+	 * @param Site as the site to locate
+	 */
+	static void LocateSite(const ASkycatchTerrain* Terrain, FOverlaySite& Site);
+
+	/**
+	 * @brief Returns whether a site has to be in the raster overlay for the given views. The thresholds are enlarged
+	 * by the hysteresis for a site that is already active.
+	 *
+	 * @param Site as the site to check
+	 * @param Views as the player views
+	 */
+	bool ShouldActivateSite(const FOverlaySite& Site, const TArray<FPlayerView>& Views) const;
+
+	/**
+	 * @brief Group of sites whose outlines touch, submitted as the polygons of their union.
+	 */
+	struct FOverlayGroup
+	{
+		TArray<TWeakObjectPtr<ASkycatchTerrain>> Sites;
+		FBox2D Bounds;
+		/** Outer rings of the union in longitude, latitude, empty when the outlines of the sites are used as they are */
+		TArray<TArray<FVector2D>> Rings;
+		/** Polygons spawned for the rings */
+		TArray<TWeakObjectPtr<ACesiumCartographicPolygon>> Polygons;
+	};
+
+	/**
+	 * @brief Merges again the groups of sites touched by the given sites, then submits the polygons to the overlay.
+	 *
+	 * @param ChangedSites as the sites that were submitted, changed or withdrawn
+	 */
+	void MergeSites(const TArray<TWeakObjectPtr<ASkycatchTerrain>>& ChangedSites);
+
+	/**
+	 * @brief Creates a group from sites whose outlines touch, merging their outlines when possible.
+	 *
+	 * @param Sites as the sites of the group
+	 */
+	void CreateGroup(const TArray<TWeakObjectPtr<ASkycatchTerrain>>& Sites);
+
+	/**
+	 * @brief Destroys the polygons spawned for a group and forgets it.
+	 *
+	 * @param GroupId as the group to remove
+	 */
+	void RemoveGroup(int32 GroupId);
+
+	/**
+	 * @brief Projects the rings of a group to the polygons spawned for it.
+	 *
+	 * @param Group as the group to project
+	 */
+	void ProjectGroup(FOverlayGroup& Group);
+
+	/**
+	 * @brief Replaces the polygons previously submitted to the raster overlay with the current ones, and refreshes
+	 * the world terrain once.
+	 */
+	void CommitOverlay();
+
+	/**
+	 * @brief Called when any of the georeferences used by the registered actors changes its origin.
+	 */
+	UFUNCTION()
+	void HandleGeoreferenceUpdated();
+
+	/**
+	 * @brief Commits of the resolved sites spread over frames.
+	 */
+	FSkycatchCommitQueue CommitQueue;
+
+	/**
+	 * @brief Whether the polygons of the raster overlay changed since it was last refreshed.
+	 */
+	bool bOverlayRefreshPending = false;
+
+	/**
+	 * @brief Seconds since the last refresh of the raster overlay.
+	 */
+	float TimeSinceOverlayRefresh = 0.0f;
+
+	/**
+	 * @brief Asks for a refresh of the raster overlay. In game worlds the refresh waits for the refresh interval,
+	 * so the changes made in between are applied together.
+	 */
+	void RequestOverlayRefresh();
+
+	/**
+	 * @brief Refreshes the raster overlay with its current polygons. The world terrain tiles stay loaded, only the
+	 * overlay is rasterized again.
+	 */
+	void RefreshOverlay();
+
+	/**
+	 * @brief Prewarm of the tiles along a camera path.
+	 */
+	FSkycatchTilePrewarm TilePrewarm;
+
+	/**
+	 * @brief Skycatch Terrain actors that have a polygon outline.
+	 */
+	TArray<TWeakObjectPtr<ASkycatchTerrain>> Terrains;
+
+	/**
+	 * @brief Georeferences the subsystem listens to.
+	 */
+	TArray<TWeakObjectPtr<ACesiumGeoreference>> BoundGeoreferences;
+
+	/**
+	 * @brief Seconds since the last check of the distance from the player views to the known sites.
+	 */
+	float TimeSincePrefetch = 0.0f;
+
+	/**
+	 * @brief Seconds since the last update of the active sites.
+	 */
+	float TimeSinceActivation = 0.0f;
+
+	/**
+	 * @brief Sites submitted to the raster overlay.
+	 */
+	TMap<TWeakObjectPtr<ASkycatchTerrain>, FOverlaySite> OverlaySites;
+
+	/**
+	 * @brief Groups of touching sites by id.
+	 */
+	TMap<int32, FOverlayGroup> OverlayGroups;
+
+	/**
+	 * @brief Id of the next group.
+	 */
+	int32 NextOverlayGroupId = 0;
+
+	/**
+	 * @brief Raster overlay of the world terrain the polygons are submitted to.
+	 */
+	TWeakObjectPtr<UCesiumPolygonRasterOverlay> RasterOverlay;
+
+	/**
+	 * @brief Polygons currently in the raster overlay on behalf of the sites.
+	 */
+	TArray<TWeakObjectPtr<ACesiumCartographicPolygon>> SubmittedPolygons;
+
+	/**
+	 * @brief Stats of the last submission to the raster overlay.
+	 */
+	FSkycatchOverlayStats OverlayStats;
+
+	/**
+	 * @brief Budgets given to the Skycatch tilesets on the last split.
+	 */
+	UPROPERTY(Transient)
+	TArray<FSkycatchTilesetMemory> TilesetMemory;
+
+	/**
+	 * @brief Seconds since the last split of the budgets across the Skycatch tilesets.
+	 */
+	float TimeSinceTilesetBudget = 0.0f;
+
+	/**
+	 * @brief Whether the budgets have to be split again on the next tick.
+	 */
+	bool bTilesetBudgetsDirty = false;
+
+	/**
+	 * @brief Rebuilds the site index from the projected outlines of the registered Skycatch Terrain actors.
+	 */
+	void RebuildSiteIndex();
+
+	/**
+	 * @brief Projected outlines of the registered sites, queried by location.
+	 */
+	FSkycatchSiteIndex SiteIndex;
+
+	/**
+	 * @brief Whether the site index has to be rebuilt before the next query.
+	 */
+	bool bSiteIndexDirty = true;
+
+	/**
+	 * @brief Ids of the sites by actor, and actors by id.
+	 */
+	TMap<TWeakObjectPtr<ASkycatchTerrain>, int32> SiteIds;
+	TMap<int32, TWeakObjectPtr<ASkycatchTerrain>> SiteTerrains;
+
+	/**
+	 * @brief Id of the next site.
+	 */
+	int32 NextSiteId = 0;
+};
@@ -14,11 +14,58 @@
 #include "CesiumCartographicPolygon.h"
 #include "CesiumPolygonRasterOverlay.h"
 #include "SkycatchSettings.h"
+#include "SkycatchEndpoints.h"
+#include "SkycatchSitePayload.h"
+#include "SkycatchHeightQuery.h"
+#include "SkycatchVolume.h"
+#include "SkycatchWarmUp.h"
+#include "SkycatchOutline.h"
 #include "SkycatchTerrain.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnTilesetRequestCompleted, bool, bSuccess, ACesium3DTileset*, CesiumTileset, ACesiumCartographicPolygon*, CesiumPolygon);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnTilesetLoaded, ACesium3DTileset*, CesiumTileset);
 
+/**
+ * @brief Cost of the collision of a Skycatch Terrain actor.
+ */
+USTRUCT(BlueprintType)
+struct SKYCATCHAPI_API FSkycatchCollisionStats
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief Collision policy in effect.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	ESkycatchCollisionPolicy Policy = ESkycatchCollisionPolicy::Full;
+
+	/**
+	 * @brief Tile meshes with a physics mesh.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	int32 CollisionMeshes = 0;
+
+	/**
+	 * @brief Tile meshes that currently collide.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	int32 ActiveCollisionMeshes = 0;
+
+	/**
+	 * @brief Estimated memory of the physics meshes in bytes.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	int64 CollisionBytes = 0;
+
+	/**
+	 * @brief Seconds from setting the url of the collision tileset until it is loaded, -1 while it loads or when the
+	 * collision is built by the shown tileset. Includes the download of the tiles, as Cesium cooks the physics
+	 * meshes of a tile on its worker threads right after it is downloaded.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	float LoadSeconds = -1.0f;
+};
+
 UCLASS(Blueprintable)
 class SKYCATCHAPI_API ASkycatchTerrain : public AActor
 {
@@ -93,6 +140,83 @@ public:
 		Category=SkycatchTerrainProperties)
 	bool RasterOverlayVisible = true;
 
+	/**
+	 * @brief When enabled, a new site is loaded into a hidden secondary tileset that replaces the shown one only once
+	 * it is ready, so there are no blank frames while switching sites. Only applies in game worlds.
+	 * This property can be edited over Blueprints in UE editor.
+	 */
+	UPROPERTY(EditAnywhere,
+		BlueprintReadWrite,
+		Category=SkycatchTerrainProperties)
+	bool DoubleBufferedSwap = false;
+
+	/**
+	 * @brief Load progress (0-100) the secondary tileset has to reach before it is swapped in. At 100 the swap waits
+	 * for the OnTilesetLoaded event of the secondary tileset.
+	 * This property can be edited over Blueprints in UE editor.
+	 */
+	UPROPERTY(EditAnywhere,
+		BlueprintReadWrite,
+		Category=SkycatchTerrainProperties,
+		meta=(ClampMin="0.0", ClampMax="100.0", EditCondition="DoubleBufferedSwap"))
+	float SwapLoadProgressThreshold = 100.0f;
+
+	/**
+	 * @brief How the collision of the tilesets of the actor is built. NearPlayer and SimplifiedProxy build the physics
+	 * meshes in a hidden collision tileset and only apply in game worlds.
+	 * This property can be edited over Blueprints in UE editor.
+	 */
+	UPROPERTY(EditAnywhere,
+		BlueprintReadOnly,
+		Category=SkycatchCollision)
+	ESkycatchCollisionPolicy CollisionPolicy = ESkycatchCollisionPolicy::UseProjectDefault;
+
+	/**
+	 * @brief Hidden tileset that only provides the collision of the site.
+	 */
+	UPROPERTY(VisibleAnywhere,
+		BlueprintReadOnly,
+		Transient,
+		Category=SkycatchCollision)
+	ACesium3DTileset* CollisionTilesetActor = nullptr;
+
+	/**
+	 * @brief When enabled, the actor requests the tileset at its location as soon as it begins play, which happens when
+	 * its streamed level or World Partition cell streams in.
+	 * This property can be edited over Blueprints in UE editor.
+	 */
+	UPROPERTY(EditAnywhere,
+		BlueprintReadWrite,
+		Category=SkycatchStreaming)
+	bool ResolveOnStreamIn = false;
+
+	/**
+	 * @brief When enabled, the tilesets and the polygon spawned by the actor are released when its streamed level or
+	 * World Partition cell streams out. The site lookup stays cached, so streaming in again is cheap.
+	 * This property can be edited over Blueprints in UE editor.
+	 */
+	UPROPERTY(EditAnywhere,
+		BlueprintReadWrite,
+		Category=SkycatchStreaming)
+	bool ReleaseOnStreamOut = true;
+
+	/**
+	 * @brief When enabled, in multiplayer sessions only the server calls the Skycatch services. The resolved site is
+	 * replicated to the clients as a compact payload, and the clients build the tileset and the polygon from it.
+	 * Lookups requested on clients are ignored.
+	 * This property can be edited over Blueprints in UE editor.
+	 */
+	UPROPERTY(EditAnywhere,
+		BlueprintReadWrite,
+		Category=SkycatchReplication)
+	bool ReplicateSiteResolution = true;
+
+	/**
+	 * @brief Site resolved by the server, replicated to the clients.
+	 */
+	UPROPERTY(ReplicatedUsing=OnRep_ReplicatedSite)
+	FSkycatchSitePayload ReplicatedSite;
+
 	/**
 	 * @brief Global property for managing the latitude of the tileset to be retrieved
 	 * This property can be edited over Blueprints in UE editor.
@@ -116,11 +240,39 @@ public:
 protected:
 	
 	virtual void BeginPlay() override;
-	
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:	
 	
 	virtual void Tick(float DeltaTime) override;
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/**
+	 * @brief Called on clients when the server resolved a new site, builds the tileset and the polygon from the
+	 * replicated payload.
+	 */
+	UFUNCTION()
+	void OnRep_ReplicatedSite();
+
+	/**
+	 * @brief Updates the replicated payload from the site shown on the server.
+	 */
+	void UpdateReplicatedSite();
+
+	/**
+	 * @brief Returns the number of lookups clients of this process did not send because the site was replicated by the
+	 * server.
+	 */
+	UFUNCTION(BlueprintPure, Category = SkycatchTerrain)
+	static int32 GetLookupsAvoidedByReplication() { return LookupsAvoidedByReplication; }
+
+	/**
+	 * @brief Number of lookups clients of this process did not send because the site was replicated by the server.
+	 */
+	static int32 LookupsAvoidedByReplication;
+
 	/**
 	 * @brief Function that takes the (Latitude, Longitude) parameters and makes an HTTP call to Skycatch
 	 * services, then parses the response and continues the process of rendering.
@@ -129,6 +281,41 @@ public:
 	 */
 	void FindResource(FString Params, bool CalledFromEditor);
 
+	/**
+	 * @brief Function that parses the response of a site lookup and continues the process of rendering.
+	 * 
+	 * @param connectedSuccessfully whether the Skycatch services could be reached
+	 * @param ResponseCode as the HTTP response code
+	 * @param Content as the content of the response
+	 * @param CalledFromEditor whether the polygon has to be registered immediately
+	 * @param RequestSerial as the serial of the request the response answers
+	 */
+	void HandleResourceResponse(bool connectedSuccessfully, int32 ResponseCode, const FString& Content, bool CalledFromEditor, int32 RequestSerial);
+
+	/**
+	 * @brief Broadcasts the completion of a request.
+	 *
+	 * @param RequestSerial as the serial of the completed request
+	 * @param bSuccess whether the tile of the request was shown
+	 */
+	void BroadcastRequestCompleted(int32 RequestSerial, bool bSuccess);
+
+	/**
+	 * @brief Serial of the last request made on this actor.
+	 */
+	int32 LastRequestSerial = 0;
+
+	/**
+	 * @brief Serial of the request being reported by the current OnTilesetRequestCompleted broadcast.
+	 */
+	int32 BroadcastRequestSerial = 0;
+
+	/**
+	 * @brief Whether a site replicated by the server is being committed on this client, which completes the requests
+	 * made meanwhile.
+	 */
+	bool bReplicatedSitePending = false;
+
 	/**
 	 * @brief Function that receives a string url from the fetched tileset and instantiates or updates the current
 	 * tileset from the actor.
@@ -136,16 +323,66 @@ public:
 	 * @param url as a string used to render the Cesium3DTileset
 	 */
 	void RenderResource(FString url);
+
+	/**
+	 * @brief Function that shows a tile from the Skycatch services response, rebuilding only the tileset and the
+	 * polygon parts that differ from what is currently shown. In game worlds the commit is split in steps queued in
+	 * the subsystem, so the sites that resolve together are committed over several frames.
+	 * 
+	 * @param Tile as the json object of the tile to show
+	 * @param CalledFromEditor whether the polygon has to be registered immediately
+	 * @param OnShown as the callback executed once the tile is shown, or with false if the commit is cancelled or
+	 * replaced by another tile before
+	 */
+	void ShowTile(const TSharedPtr<FJsonObject>& Tile, bool CalledFromEditor, TFunction<void(bool)> OnShown = nullptr);
 	
 	/*
 	* @brief Adds a CesiumPolygonRasterOverlay component into the World Terrain Actor. Internal use only
 	*/
 	void AddRasterOverlayComponentToWorldTerrain();
 
+	/**
+	 * @brief Parses every ring of the geojson Polygon or MultiPolygon outline of a tile from the Skycatch services
+	 * response, and bridges them into the single ring of the polygon. Returns false when the tile has no outline.
+	 * Can run on any thread.
+	 *
+	 * @param Tile as the json object of the tile
+	 * @param OutOutline as the outline of the tile
+	 */
+	static bool ParseTileOutline(const TSharedPtr<FJsonObject>& Tile, FSkycatchOutline& OutOutline);
+
 	/*
-	* @brief Functions that takes info from a request response to spawn a cartographic polygon
+	* @brief Functions that spawns the cartographic polygon of the site if needed and sets its outline
+	*
+	* @param Outline as the outline of the site
+	* @param SplinePoints as the bridged ring of the outline already projected to Unreal coordinates, or empty to
+	* project it
 	*/
-	void SpawnCartographicPolygon();
+	void SpawnCartographicPolygon(FSkycatchOutline Outline, TArray<FVector> SplinePoints = TArray<FVector>());
+
+	/**
+	 * @brief Sets the outline of the CartographicPolygon and keeps its geodetic coordinates, so the polygon can be
+	 * re-projected when the georeference changes.
+	 *
+	 * @param Outline as the outline of the site
+	 * @param SplinePoints as the bridged ring of the outline already projected to Unreal coordinates, or empty to
+	 * project it
+	 */
+	void ApplyOutline(FSkycatchOutline Outline, TArray<FVector> SplinePoints = TArray<FVector>());
+
+	/**
+	 * @brief Transforms an outline in longitude, latitude and height to UE world coordinates using the
+	 * GeoreferenceActor.
+	 *
+	 * @param LongitudeLatitudeHeight as the outline to transform
+	 */
+	TArray<FVector> ProjectOutline(const TArray<FVector>& LongitudeLatitudeHeight) const;
+
+	/**
+	 * @brief Re-projects the shown polygon from its kept geodetic outline, without refreshing the world terrain.
+	 * Returns whether the polygon is registered in the world terrain, so the caller has to refresh it.
+	 */
+	bool ReprojectOutline();
 
 
 	/**
@@ -154,6 +391,12 @@ public:
 	 * tileset.
 	 */
 	void RenderRasterOverlay();
+
+	/**
+	 * @brief Returns whether the outline of the site is currently submitted to the world terrain raster overlay,
+	 * either as the CartographicPolygon or merged with the outlines of the adjacent sites.
+	 */
+	bool IsPolygonRegistered() const;
 	
 	/**
 	 * @brief function to evaluate if any of the public properties of the tile (Latitude, Longitude) change
@@ -190,6 +433,23 @@ public:
 	UPROPERTY(BlueprintAssignable)
 	FOnTilesetRequestCompleted OnTilesetRequestCompleted;
 
+	/**
+	 * @brief Returns the serial of the last request made on this actor.
+	 */
+	int32 GetLastRequestSerial() const { return LastRequestSerial; }
+
+	/**
+	 * @brief Returns the serial the next request made on this actor gets, so a listener can know it before the
+	 * request completes, which may happen before the request function returns.
+	 */
+	int32 GetNextRequestSerial() const { return LastRequestSerial + 1; }
+
+	/**
+	 * @brief Returns the serial of the request being reported by the current OnTilesetRequestCompleted broadcast,
+	 * so a listener can ignore the completion of a request older than its own.
+	 */
+	int32 GetBroadcastRequestSerial() const { return BroadcastRequestSerial; }
+
 	/*
 	* Event called when a tileset is loaded (it automatically binds to the Cesium3DTileset actor every time a new request is made)
 	*/
@@ -201,11 +461,49 @@ public:
 	UFUNCTION(Category = SkycatchTerrain)
 	void CesiumTilesetLoadedForwardBroadcast();
 
+	/**
+	 * @brief Url of the tileset swapped in before it was fully loaded. Its loaded event was already broadcast at the
+	 * swap, so the one Cesium fires on the full load is not broadcast again.
+	 */
+	FString ThresholdSwappedUrl;
+
+	/**
+	 * @brief Hidden secondary tileset that loads the next site while double buffered swapping is enabled.
+	 */
+	UPROPERTY(Transient)
+	ACesium3DTileset* PendingTilesetActor = nullptr;
+
+	TScriptDelegate <FWeakObjectPtr> PendingTilesetLoadedListener;
+
+	UFUNCTION(Category = SkycatchTerrain)
+	void PendingTilesetLoadedSwap();
+
+	/**
+	 * @brief Makes the pending tileset the shown one, applies the pending polygon outline at the same moment and
+	 * destroys the previous tileset.
+	 */
+	void SwapPendingTileset();
+
+	/**
+	 * @brief Destroys the pending tileset (if any) and discards its pending polygon outline.
+	 */
+	void CancelPendingTileset();
+
+	/**
+	 * @brief Spawns a Cesium3DTileset actor owned by this actor with the configuration used for Skycatch tilesets.
+	 */
+	ACesium3DTileset* SpawnSkycatchTileset();
+
 	/*
 	* Makes a request using lat and lon values. Internal C++ Use only
 	*/
 	void MakeRequest(double Lat, double Lon);
 
+	/*
+	* Creates the query params of a lookup at the given coordinates
+	*/
+	static FString MakeQueryParams(double Lat, double Lon);
+
 	/*
 	* @brief This function can be used to request a tileset in specific Latitude and Longitude coordinates
 	* 
@@ -233,6 +531,127 @@ public:
 	UFUNCTION(BlueprintCallable, CallInEditor, Category = SkycatchTerrain)
 	void UnloadTileset();
 
+	/**
+	 * @brief Returns the health and latency statistics of every configured Skycatch services endpoint.
+	 */
+	UFUNCTION(BlueprintPure, Category = SkycatchTerrain)
+	static TArray<FSkycatchEndpointStats> GetEndpointStats();
+
+	/**
+	 * @brief Probes every configured Skycatch services endpoint to refresh its health and latency.
+	 */
+	UFUNCTION(BlueprintCallable, Category = SkycatchTerrain)
+	static void ProbeEndpoints();
+
+	/**
+	 * @brief Returns the progress and timings of the warm up of the plugin, including its time to ready.
+	 */
+	UFUNCTION(BlueprintPure, Category = SkycatchTerrain)
+	static FSkycatchWarmUpStats GetWarmUpStats();
+
+	/**
+	 * @brief Switches the shown tileset and polygon to another capture of the current site. Neighbouring captures
+	 * are kept warm, so stepping through the survey history does not reload the tileset from scratch.
+	 *
+	 * @param Index as the index of the capture, sorted by capture date
+	 */
+	UFUNCTION(BlueprintCallable, Category = SkycatchTerrain)
+	bool SetActiveCapture(int32 Index);
+
+	/**
+	 * @brief Moves the active capture forward or back in time.
+	 *
+	 * @param Offset as the number of captures to move, negative values move back in time
+	 */
+	UFUNCTION(BlueprintCallable, Category = SkycatchTerrain)
+	bool StepActiveCapture(int32 Offset);
+
+	/**
+	 * @brief Returns the number of captures of the current site.
+	 */
+	UFUNCTION(BlueprintPure, Category = SkycatchTerrain)
+	int32 GetCaptureCount() const { return SiteCaptures.Num(); }
+
+	/**
+	 * @brief Returns the index of the shown capture, sorted by capture date.
+	 */
+	UFUNCTION(BlueprintPure, Category = SkycatchTerrain)
+	int32 GetActiveCaptureIndex() const { return ActiveCaptureIndex; }
+
+	/**
+	 * @brief Returns the capture dates of the current site, sorted from the oldest to the newest.
+	 */
+	UFUNCTION(BlueprintPure, Category = SkycatchTerrain)
+	TArray<FDateTime> GetCaptureDates() const;
+
+	/**
+	 * @brief Changes the collision policy of the actor and applies it to its tilesets.
+	 *
+	 * @param Policy as the new collision policy
+	 */
+	UFUNCTION(BlueprintCallable, Category = SkycatchTerrain)
+	void SetCollisionPolicy(ESkycatchCollisionPolicy Policy);
+
+	/**
+	 * @brief Returns the collision policy in effect, resolving the project default.
+	 */
+	UFUNCTION(BlueprintPure, Category = SkycatchTerrain)
+	ESkycatchCollisionPolicy GetEffectiveCollisionPolicy() const;
+
+	/**
+	 * @brief Returns the number, memory and build time of the physics meshes of the actor.
+	 */
+	UFUNCTION(BlueprintPure, Category = SkycatchTerrain)
+	FSkycatchCollisionStats GetCollisionStats() const;
+
+	/**
+	 * @brief Finds the height of the survey surface at a batch of points. The points are traced in parallel against
+	 * the loaded tiles, and the heights found are cached per tile. Points without a loaded tile under them are
+	 * answered once their tile loads, so the callback may be called on a later frame, once for the whole batch.
+	 *
+	 * @param LongitudeLatitude as the points, with the longitude in X and the latitude in Y
+	 * @param OnQueried as the callback receiving a sample per point, in the same order
+	 */
+	UFUNCTION(BlueprintCallable, Category = SkycatchTerrain)
+	void QueryHeights(const TArray<FVector2D>& LongitudeLatitude, const FOnSkycatchHeightsQueried& OnQueried);
+
+	/**
+	 * @brief Returns the number of height queries waiting for tiles to load.
+	 */
+	UFUNCTION(BlueprintPure, Category = SkycatchTerrain)
+	int32 GetPendingHeightQueryCount() const { return PendingHeightQueries.Num(); }
+
+	/**
+	 * @brief Returns the number of heights cached for the loaded tiles.
+	 */
+	UFUNCTION(BlueprintPure, Category = SkycatchTerrain)
+	int32 GetCachedHeightCount() const { return HeightCache.GetNumCached(); }
+
+	/**
+	 * @brief Computes the cut and fill volumes of the loaded survey surface inside a polygon against a reference
+	 * surface. The level of detail is the one of the loaded tiles with physics meshes, the collision tileset when the
+	 * collision policy uses one, and the cell size sets the resolution of the integration.
+	 *
+	 * @param PolygonLongitudeLatitude as the polygon, with the longitude in X and the latitude in Y
+	 * @param Reference as the reference surface
+	 * @param ReferenceHeight as the height in meters above the WGS84 ellipsoid of the FixedHeight reference
+	 * @param CellSizeMeters as the size of the raster cells in meters
+	 */
+	UFUNCTION(BlueprintCallable, Category = SkycatchTerrain)
+	FSkycatchVolumeResult ComputeVolume(const TArray<FVector2D>& PolygonLongitudeLatitude, ESkycatchVolumeReference Reference = ESkycatchVolumeReference::BoundaryPlane,
+		double ReferenceHeight = 0.0, double CellSizeMeters = 0.25) const;
+
+	/**
+	 * @brief Computes the cut and fill volumes of the loaded survey surface inside the outline of the site.
+	 *
+	 * @param Reference as the reference surface
+	 * @param ReferenceHeight as the height in meters above the WGS84 ellipsoid of the FixedHeight reference
+	 * @param CellSizeMeters as the size of the raster cells in meters
+	 */
+	UFUNCTION(BlueprintCallable, Category = SkycatchTerrain)
+	FSkycatchVolumeResult ComputeSiteVolume(ESkycatchVolumeReference Reference = ESkycatchVolumeReference::BoundaryPlane,
+		double ReferenceHeight = 0.0, double CellSizeMeters = 0.25) const;
+
 	/**
 	 * @brief Global instance for the raster overlay component of the world terrain.
 	 */
@@ -265,6 +684,161 @@ public:
 	 * @brief Global instance of the current tileset that is rendering.
 	 */
 	TSharedPtr<FJsonObject> SelectedTile;
+
+	/**
+	 * @brief Computes a 64 bits content hash of the geojson outline of a tile from the Skycatch services response.
+	 * Returns 0 when the tile has no outline.
+	 *
+	 * @param Tile as the json object of the tile
+	 */
+	static uint64 HashTileOutline(const TSharedPtr<FJsonObject>& Tile);
+
+	/**
+	 * @brief Tileset url currently loaded in the Cesium3DTilesetActor, used to skip redundant reloads.
+	 */
+	FString ShownTilesetUrl;
+
+	/**
+	 * @brief Hash of the outline currently set in the CartographicPolygon, used to skip redundant polygon rebuilds.
+	 */
+	uint64 ShownOutlineHash = 0;
+
+	/**
+	 * @brief Polygon outline in longitude, latitude and height of the shown polygon.
+	 */
+	TArray<FVector> OutlineLongitudeLatitudeHeight;
+
+	/**
+	 * @brief Every ring of the outline of the shown polygon and the bounds of its parts. OutlineLongitudeLatitudeHeight
+	 * is the single ring bridging them.
+	 */
+	FSkycatchOutline OutlineGeometry;
+
+	/**
+	 * @brief Polygon outline waiting for the pending tileset to be swapped in.
+	 */
+	FSkycatchOutline PendingOutline;
+
+	/**
+	 * @brief Whether PendingOutline holds an outline that has to be applied on the next swap.
+	 */
+	bool bHasPendingOutline = false;
+
+	/**
+	 * @brief All the captures of the current site from the Skycatch services response, sorted by capture date.
+	 */
+	TArray<TSharedPtr<FJsonObject>> SiteCaptures;
+
+	/**
+	 * @brief Index in SiteCaptures of the capture that is shown.
+	 */
+	int32 ActiveCaptureIndex = INDEX_NONE;
+
+	/**
+	 * @brief Hidden tilesets of the captures next to the active one.
+	 */
+	UPROPERTY(Transient)
+	TArray<ACesium3DTileset*> WarmTilesets;
+
+	/**
+	 * @brief Returns the warm tileset of a tileset url, or null.
+	 *
+	 * @param Url as the tileset url of the capture
+	 */
+	ACesium3DTileset* FindWarmTileset(const FString& Url) const;
+
+	/**
+	 * @brief Returns whether two tileset urls are the same. Urls are case sensitive, as the keys of the storage they
+	 * point to.
+	 *
+	 * @param A as the first url
+	 * @param B as the second url
+	 */
+	static bool IsSameUrl(const FString& A, const FString& B);
+
+	/**
+	 * @brief Returns the capture date of a tile from the Skycatch services response, or the minimum date when the tile
+	 * has no valid capture date.
+	 *
+	 * @param Tile as the json object of the tile
+	 */
+	static FDateTime GetTileCaptureDate(const TSharedPtr<FJsonObject>& Tile);
+
+	/**
+	 * @brief Returns whether the tileset url belongs to a capture next to the active one that has to be kept warm.
+	 *
+	 * @param Url as the tileset url of the capture
+	 */
+	bool ShouldKeepCaptureWarm(const FString& Url) const;
+
+	/**
+	 * @brief Prefetches the captures next to the active one into hidden tilesets and releases the ones that are no
+	 * longer neighbours, splitting the configured memory budget between them.
+	 */
+	void RefreshWarmCaptures();
+
+	/**
+	 * @brief Spawns, retargets or releases the collision tileset for the collision policy and the player views, and
+	 * enables the collision of the tiles close to a player with the NearPlayer policy.
+	 */
+	void UpdateCollision();
+
+	/**
+	 * @brief Returns the view locations of all the players, including the remote ones on a server.
+	 */
+	TArray<FVector> GetPlayerLocations() const;
+
+	/**
+	 * @brief Seconds since the last update of the collision.
+	 */
+	float TimeSinceCollisionUpdate = 0.0f;
+
+	/**
+	 * @brief Time at which the collision tileset started loading its current url, 0 once it is loaded.
+	 */
+	double CollisionLoadStartTime = 0.0;
+
+	/**
+	 * @brief Seconds the collision tileset took to download and cook its current url, -1 while it loads.
+	 */
+	float CollisionLoadSeconds = -1.0f;
+
+	/**
+	 * @brief Height query with points waiting for their tile to load.
+	 */
+	struct FPendingHeightQuery
+	{
+		TArray<FVector2D> LongitudeLatitude;
+		TArray<FSkycatchHeightSample> Samples;
+		TArray<int32> Unresolved;
+		double Deadline = 0.0;
+		FOnSkycatchHeightsQueried OnQueried;
+	};
+
+	/**
+	 * @brief Height queries with points waiting for their tile to load.
+	 */
+	TArray<FPendingHeightQuery> PendingHeightQueries;
+
+	/**
+	 * @brief Heights found on the loaded tiles.
+	 */
+	FSkycatchHeightCache HeightCache;
+
+	/**
+	 * @brief Seconds since the pending height queries were last retried.
+	 */
+	float TimeSinceHeightRetry = 0.0f;
+
+	/**
+	 * @brief Returns the tileset the height queries trace, the collision tileset when there is one.
+	 */
+	ACesium3DTileset* GetHeightQueryTileset() const;
+
+	/**
+	 * @brief Retries the points of the pending height queries, and answers the queries that are complete or timed out.
+	 */
+	void ResolvePendingHeightQueries();
 };
 
 /*
@@ -297,6 +871,8 @@ private:
 	double Lon;
 	bool AutoRegisterPolygon;
 
+	int32 RequestSerial;
+
 	UFUNCTION()
 	void Execute(bool success, ACesium3DTileset* CesiumTileset, ACesiumCartographicPolygon* Polygon);
 };
@@ -326,6 +902,7 @@ private:
 	UObject* WorldContextObject;
 	ASkycatchTerrain* SkycatchTerrain;
 	bool AutoRegisterPolygon;
+	int32 RequestSerial;
 
 	UFUNCTION()
 		void Execute(bool success, ACesium3DTileset* CesiumTileset, ACesiumCartographicPolygon* Polygon);
@@ -0,0 +1,127 @@
+#pragma once
+
+/**
+ * Including the Header libraries and files required
+ **/
+#include "CoreMinimal.h"
+#include "SkycatchVolume.generated.h"
+
+class ACesium3DTileset;
+class ACesiumGeoreference;
+
+/**
+ * @brief Surface the volume of a polygon is measured against.
+ */
+UENUM(BlueprintType)
+enum class ESkycatchVolumeReference : uint8
+{
+	/** Horizontal plane at a given height above the WGS84 ellipsoid */
+	FixedHeight,
+	/** Horizontal plane at the lowest point of the surface along the polygon */
+	LowestBoundaryPoint,
+	/** Plane fitted to the surface along the polygon, the usual base of a stockpile */
+	BoundaryPlane
+};
+
+/**
+ * @brief Cut and fill volumes of the surface inside a polygon against a reference surface.
+ */
+USTRUCT(BlueprintType)
+struct SKYCATCHAPI_API FSkycatchVolumeResult
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief Whether any loaded geometry was found inside the polygon.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	bool bValid = false;
+
+	/**
+	 * @brief Volume in cubic meters of the surface above the reference.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	double CutVolume = 0.0;
+
+	/**
+	 * @brief Volume in cubic meters between the surface and the reference, where the surface is below it.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	double FillVolume = 0.0;
+
+	/**
+	 * @brief Cut minus fill volume in cubic meters.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	double NetVolume = 0.0;
+
+	/**
+	 * @brief Area in square meters of the polygon covered by loaded geometry.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	double Area = 0.0;
+
+	/**
+	 * @brief Fraction (0-1) of the polygon covered by loaded geometry.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	float Coverage = 0.0f;
+
+	/**
+	 * @brief Mean height of the reference surface inside the polygon, in meters above the WGS84 ellipsoid.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	double ReferenceHeight = 0.0;
+
+	/**
+	 * @brief Number of triangles rasterized.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	int32 Triangles = 0;
+
+	/**
+	 * @brief Size in meters of the raster cells.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	float CellSize = 0.0f;
+
+	/**
+	 * @brief Milliseconds taken by the computation.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchTerrain)
+	float ComputeMilliseconds = 0.0f;
+};
+
+/**
+ * @brief Computes cut and fill volumes by rasterizing triangles into a height grid over a polygon and integrating the
+ * grid against a reference surface. Rows of the grid are processed in parallel and accumulated four cells at a time.
+ */
+struct SKYCATCHAPI_API FSkycatchVolume
+{
+	/**
+	 * @brief Integrates the volume of triangles given in a local frame, X and Y horizontal and Z up, all in meters.
+	 *
+	 * @param TriangleVertices as the vertices of the triangles, three per triangle
+	 * @param Polygon as the polygon in the local frame
+	 * @param Reference as the reference surface
+	 * @param ReferenceHeight as the height of the FixedHeight reference in the local frame
+	 * @param CellSize as the size of the raster cells in meters, enlarged when the grid would be too large
+	 * @param bSingleThreaded as whether to run on the calling thread only, used to measure the parallel speedup
+	 */
+	static FSkycatchVolumeResult Integrate(const TArray<FVector3f>& TriangleVertices, const TArray<FVector2D>& Polygon,
+		ESkycatchVolumeReference Reference, double ReferenceHeight, double CellSize, bool bSingleThreaded = false);
+
+	/**
+	 * @brief Computes the volume of the loaded tiles of a tileset inside a polygon. The tiles are measured in a plane
+	 * tangent to the ellipsoid at the center of the polygon, from the physics meshes of the tiles that are shown.
+	 *
+	 * @param Tileset as the tileset to measure
+	 * @param Georeference as the georeference of the polygon
+	 * @param PolygonLongitudeLatitude as the polygon, with the longitude in X and the latitude in Y
+	 * @param Reference as the reference surface
+	 * @param ReferenceHeight as the height in meters above the WGS84 ellipsoid of the FixedHeight reference
+	 * @param CellSize as the size of the raster cells in meters
+	 */
+	static FSkycatchVolumeResult Compute(const ACesium3DTileset* Tileset, const ACesiumGeoreference* Georeference,
+		const TArray<FVector2D>& PolygonLongitudeLatitude, ESkycatchVolumeReference Reference, double ReferenceHeight, double CellSize);
+};
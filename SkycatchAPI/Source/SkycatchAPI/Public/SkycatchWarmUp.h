@@ -0,0 +1,145 @@
+#pragma once
+
+/**
+ * Including the Header libraries and files required
+ **/
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "SkycatchWarmUp.generated.h"
+
+/**
+ * @brief Progress and timings of the warm up of the plugin.
+ */
+USTRUCT(BlueprintType)
+struct SKYCATCHAPI_API FSkycatchWarmUpStats
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief Whether the warm up started.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchWarmUp)
+	bool bStarted = false;
+
+	/**
+	 * @brief Whether every step of the warm up completed.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchWarmUp)
+	bool bReady = false;
+
+	/**
+	 * @brief Seconds from the start of the warm up until every step completed. Negative while not ready.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchWarmUp)
+	float TimeToReadySeconds = -1.0f;
+
+	/**
+	 * @brief Seconds until every endpoint answered its probe. Negative while not connected.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchWarmUp)
+	float ConnectSeconds = -1.0f;
+
+	/**
+	 * @brief Seconds until the sites saved by the previous session were loaded. Negative while not loaded.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchWarmUp)
+	float LoadSeconds = -1.0f;
+
+	/**
+	 * @brief Sites loaded from the previous session.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchWarmUp)
+	int32 LoadedSites = 0;
+
+	/**
+	 * @brief Home sites whose lookup completed, from the cache or the Skycatch services.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchWarmUp)
+	int32 HomeSites = 0;
+
+	/**
+	 * @brief Root tilesets of the home sites fetched into the Cesium request cache.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = SkycatchWarmUp)
+	int32 HomeTilesets = 0;
+};
+
+/**
+ * @brief Warms up the plugin once the engine started, so the first lookup of a session doesn't pay for the name
+ * resolution, the connection and a cold cache. The endpoints are probed, the sites saved by the previous session are
+ * loaded on a worker thread, then the home sites and their root tilesets are prefetched. Nothing blocks the caller.
+ */
+class SKYCATCHAPI_API FSkycatchWarmUp
+{
+public:
+
+	/**
+	 * @brief Returns the process wide warm up.
+	 */
+	static FSkycatchWarmUp& Get();
+
+	/**
+	 * @brief Starts the warm up on the next tick of the engine. Does nothing when it already started.
+	 */
+	void Start();
+
+	/**
+	 * @brief Cancels the warm up if it didn't start yet. Called when the plugin stops.
+	 */
+	void Shutdown();
+
+	/**
+	 * @brief Returns the progress and timings of the warm up.
+	 */
+	FSkycatchWarmUpStats GetStats() const { return Stats; }
+
+private:
+
+	/**
+	 * @brief Runs the steps of the warm up.
+	 */
+	void Run();
+
+	/**
+	 * @brief Looks up the home sites, and fetches their root tilesets.
+	 */
+	void PrefetchHomeSites();
+
+	/**
+	 * @brief Fetches the root tileset.json of a site through the Cesium asset accessor, so it lands in the Cesium
+	 * request cache the tileset reads from.
+	 *
+	 * @param Url as the url of the tileset
+	 */
+	void PrefetchTileset(const FString& Url);
+
+	/**
+	 * @brief Marks a step of the warm up as completed, and the warm up as ready once none is left.
+	 */
+	void CompleteStep();
+
+	/**
+	 * @brief Returns the seconds since the warm up started.
+	 */
+	float GetElapsedSeconds() const;
+
+	/**
+	 * @brief Progress and timings of the warm up.
+	 */
+	FSkycatchWarmUpStats Stats;
+
+	/**
+	 * @brief Steps of the warm up that did not complete yet.
+	 */
+	int32 PendingSteps = 0;
+
+	/**
+	 * @brief Platform time the warm up started.
+	 */
+	double StartTime = 0.0;
+
+	/**
+	 * @brief Handle of the ticker that starts the warm up.
+	 */
+	FTSTicker::FDelegateHandle StartTickerHandle;
+};
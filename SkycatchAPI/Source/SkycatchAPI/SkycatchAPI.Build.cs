@@ -43,6 +43,10 @@ public class SkycatchAPI : ModuleRules
 				"Slate",
 				"SlateCore",
                 "HTTP",
+				"HTTPServer",
+				"LevelSequence",
+				"MovieScene",
+				"NetCore",
 				"Json",
 				"JsonUtilities"
 				// ... add private dependencies that you statically link with here ...	